@@ -0,0 +1,120 @@
+// cookiedough -- large buffer alloc. & free (frame buffers, render targets, maps, tables)
+
+#include "main.h"
+#include "alloc-large.h"
+
+#include <mutex>
+#include <map>
+#include <unordered_map>
+
+#if defined(__linux__)
+	#include <sys/mman.h>
+#endif
+
+constexpr size_t kHugePage = 2*1024*1024;
+constexpr size_t kMaxHugePadding = 8; // round up to whole huge pages if it adds less than 1/8th of the size
+
+namespace
+{
+	struct Allocation
+	{
+		size_t size;
+		const char *subsystem;
+	};
+
+	struct Tally
+	{
+		size_t numBuffers = 0;
+		size_t numBytes = 0;
+		size_t peakBytes = 0;
+	};
+}
+
+static std::mutex s_mutex;
+static std::unordered_map<void *, Allocation> s_allocations;
+static std::map<std::string, Tally> s_tallies;
+
+void *mallocLarge(size_t size, const char *subsystem)
+{
+	VIZ_ASSERT(size > 0 && nullptr != subsystem);
+
+	void *address = nullptr;
+
+#if defined(__linux__)
+	if (size >= kHugePage)
+	{
+		// round up to whole huge pages if that's cheap, else the tail would end up on regular ones; if it isn't (say
+		// 2.1MB or 4.1MB), only the body goes on huge pages so we don't waste up to twice the memory
+		const size_t hugeSize = (size + kHugePage-1) & ~(kHugePage-1);
+		const bool roundUp = (hugeSize-size) < size/kMaxHugePadding;
+
+		const size_t allocSize = (true == roundUp) ? hugeSize : size;
+		address = mallocAligned(allocSize, kHugePage);
+		if (nullptr != address)
+		{
+			// advise before touching, it's a hint and it's fine if it's ignored
+			madvise(address, allocSize & ~(kHugePage-1), MADV_HUGEPAGE);
+			size = allocSize;
+		}
+	}
+#endif
+
+	if (nullptr == address)
+		address = mallocAligned(size, std::max(kCacheLine, kAlignTo));
+
+	if (nullptr == address)
+		return nullptr;
+
+	// prefault
+	memset(address, 0, size);
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	s_allocations[address] = { size, subsystem };
+
+	Tally &tally = s_tallies[subsystem];
+	tally.numBuffers += 1;
+	tally.numBytes += size;
+	tally.peakBytes = std::max(tally.peakBytes, tally.numBytes);
+
+	return address;
+}
+
+void freeLarge(void *address)
+{
+	if (nullptr == address)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+
+		auto iAlloc = s_allocations.find(address);
+		VIZ_ASSERT(s_allocations.end() != iAlloc); // not allocated with mallocLarge()!
+
+		if (s_allocations.end() != iAlloc)
+		{
+			Tally &tally = s_tallies[iAlloc->second.subsystem];
+			tally.numBuffers -= 1;
+			tally.numBytes -= iAlloc->second.size;
+
+			s_allocations.erase(iAlloc);
+		}
+	}
+
+	freeAligned(address);
+}
+
+std::string LargeAlloc_Report()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	std::string report;
+	for (const auto &[subsystem, tally] : s_tallies)
+	{
+		char line[256];
+		snprintf(line, 256, "%-16s %4zu buffer(s), %8.2f MB (peak: %.2f MB)\n", subsystem.c_str(), tally.numBuffers, tally.numBytes/(1024.0*1024.0), tally.peakBytes/(1024.0*1024.0));
+		report += line;
+	}
+
+	return report;
+}
@@ -0,0 +1,21 @@
+// cookiedough -- large buffer alloc. & free (frame buffers, render targets, maps, tables)
+
+/*
+	On top of what mallocAligned() does:
+	- aligned to (at least) kCacheLine, so no 2 threads share a line on the edges of a buffer
+	- Linux: buffers of 2MB and up are 2MB aligned and advised (madvise()) to be backed by transparent huge pages, which
+	  means a lot less TLB misses on random access (voxel, polar and bilinear lookups); they're rounded up to whole huge
+	  pages only if that adds less than 1/8th, otherwise the tail is left on regular pages
+	- prefaulted (zeroed) upon allocation, so the first frame to touch a buffer doesn't pay for it
+	- tallied per subsystem, see LargeAlloc_Report()
+
+	Use freeLarge() to release, never freeAligned().
+*/
+
+#pragma once
+
+void *mallocLarge(size_t size, const char *subsystem);
+void freeLarge(void *address);
+
+// per subsystem: number of buffers and size (one line each)
+std::string LargeAlloc_Report();
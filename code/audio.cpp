@@ -5,6 +5,8 @@
 // #include "../3rdparty/bass24-stripped/c/bass.h"
 #include "audio.h"
 
+#include <atomic>
+
 #if defined(_WIN32)
 	#include <Windows.h>
 #endif
@@ -20,6 +22,10 @@ const double kRowRate = (170.0 /* BPM */ / (60.0*(170.0/174.0)))*16.0 /* RPB */;
 static HMUSIC s_hMusic = 0;
 static BASS_INFO s_bassInf;
 
+// negative if not offline (see Audio_Set_Offline_Pos())
+// - atomic since the Audio_Rocket_*() callbacks are called from Rocket's network thread (BASS itself is thread-safe)
+static std::atomic<double> s_offlinePos = -1.0;
+
 bool Audio_Create(unsigned int iDevice, const std::string &musicPath, HWND hWnd, bool silent)
 {
 	VIZ_ASSERT(iDevice == unsigned(-1)); // || iDevice < Audio_GetDeviceCount());
@@ -116,6 +122,9 @@ void Audio_Update() {}
 
 void Audio_Start_Stream(unsigned bufLenMS)
 {
+	if (s_offlinePos >= 0.0)
+		return;
+
 	BASS_ChannelPlay(s_hMusic, TRUE);
 }
 
@@ -153,6 +162,9 @@ void Audio_Rocket_SetRow(void *, int row)
 
 int Audio_Rocket_IsPlaying(void *)
 {
+	if (s_offlinePos >= 0.0)
+		return BASS_ACTIVE_PLAYING;
+
 	return BASS_ChannelIsActive(s_hMusic);
 }
 
@@ -172,6 +184,10 @@ double Audio_Rocket_Sync(unsigned int &modOrder, unsigned int &modRow, float &mo
 	return modRowAlpha+(order*kRowsPerOrder + row);
 */
 
+	const double offlinePos = s_offlinePos;
+	if (offlinePos >= 0.0)
+		return offlinePos*kRowRate;
+
 	VIZ_ASSERT(s_hMusic != 0);
 	const QWORD chanPos = BASS_ChannelGetPosition(s_hMusic, BASS_POS_BYTE);
 	const double secPos = BASS_ChannelBytes2Seconds(s_hMusic, chanPos);
@@ -180,8 +196,23 @@ double Audio_Rocket_Sync(unsigned int &modOrder, unsigned int &modRow, float &mo
 
 float Audio_Get_Pos_In_Sec()
 {
+	const double offlinePos = s_offlinePos;
+	if (offlinePos >= 0.0)
+		return float(offlinePos);
+
 	VIZ_ASSERT(s_hMusic != 0);
 	const QWORD chanPos = BASS_ChannelGetPosition(s_hMusic, BASS_POS_BYTE);
 	const double secPos = BASS_ChannelBytes2Seconds(s_hMusic, chanPos);
 	return float(secPos);
-}
\ No newline at end of file
+}
+
+void Audio_Set_Offline_Pos(double secPos)
+{
+	VIZ_ASSERT(secPos >= 0.0);
+	s_offlinePos = secPos;
+}
+
+double Audio_Get_Row_Rate()
+{
+	return kRowRate;
+}
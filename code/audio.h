@@ -34,4 +34,11 @@ double Audio_Rocket_Sync(unsigned int &modOrder, unsigned int &modRow, float &mo
 // get pos. in seconds (does it work with anything else than streams?)
 float Audio_Get_Pos_In_Sec();
 
+// offline (headless) rendering: from here on the position is whatever you set it to, nothing plays (no need to
+// call Audio_Create() at all)
+void Audio_Set_Offline_Pos(double secPos);
+
+// Rocket rows per second
+double Audio_Get_Row_Rate();
+
 #endif // _AUDIO_H_	
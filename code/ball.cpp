@@ -2,6 +2,7 @@
 // cookiedough -- voxel balls (2-pass approach)
 
 #include "main.h"
+#include "alloc-large.h"
 // #include "ball.h"
 #include "image.h"
 #include "cspan.h"
@@ -10,6 +11,7 @@
 #include "polar.h"
 #include "voxel-shared.h"
 #include "rocket.h"
+#include "task-graph.h"
 // #include "shadertoy-util.h"
 
 static uint8_t *s_pHeightMap[5] = { nullptr };
@@ -62,22 +64,32 @@ static unsigned s_heightProj[kMaxRayLength];
 static int s_heightProjNorm[kMaxRayLength][3]; // for "lighting" (second index is 'to the power of'), projects on quarter of a circle, to attenuate and cull
 static unsigned s_curRayLength = kMaxRayLength;
 
-// max. radius (in pixels)
-// constexpr float kMaxBallRadius = float((kResX > kResY) ? kResX : kResY);
+// max. radius (in pixels at author resolution, scaled by g_resScale)
+// constexpr float kMaxBallRadius = float((g_resX > g_resY) ? g_resX : g_resY);
 constexpr float kMaxBallRadius = 1920.f;
 
 // beam attenuation (during accumulation) [0..255]
 constexpr auto kDefaultBeamAtten = 64;
-static unsigned s_beamAtten = kDefaultBeamAtten;
 
 // minimum beam alpha (extrusion) [0..255]
 constexpr float kDefaultBeamAlphaMin = 10.f;
-static float s_beamAlphaMin = kDefaultBeamAlphaMin;
 
 // ambient added to light calc.
 constexpr unsigned kAmbient = 32;
 
-static void vball_ray_beams(uint32_t *pDest, int curX, int curY, int dX, int dY)
+// expected sizes:
+// - maps: 1024x1024
+// ray casting is split in setup (once) and rays (in bands, see Ball_Draw())
+// - all per frame parameters live in here, not in globals
+struct VballRays
+{
+	void (*fn)(const VballRays &, uint32_t *, int, int, int, int);
+	int fromX, fromY;
+	unsigned beamAtten = kDefaultBeamAtten;
+	float beamAlphaMin = kDefaultBeamAlphaMin;
+};
+
+static void vball_ray_beams(const VballRays &rays, uint32_t *pDest, int curX, int curY, int dX, int dY)
 {
 	const unsigned lowLight = unsigned(clampi(0, 255, Rocket::geti(trackBallLowBeams)));
 
@@ -114,7 +126,7 @@ static void vball_ray_beams(uint32_t *pDest, int curX, int curY, int dX, int dY)
 
 		// and beam (light shaft) color
 		__m128i beam = bsamp32_16(s_pBeamMapMix, U0, V0, U1, V1, fracU, fracV);
-		beam = _mm_srli_epi16(_mm_mullo_epi16(beam, g_gradientUnp16[s_beamAtten]), 8);
+		beam = _mm_srli_epi16(_mm_mullo_epi16(beam, g_gradientUnp16[rays.beamAtten]), 8);
 
 		// light beam & diffuse light calc.
 		const unsigned heightNorm = mapHeight*s_heightProjNorm[iStep][0] >> 8;
@@ -174,7 +186,7 @@ static void vball_ray_beams(uint32_t *pDest, int curX, int curY, int dX, int dY)
 	unsigned beamCol = v2cISSE16(beamAccum);
 #endif
 
-	const unsigned remainder = (kTargetResX - 1) - lastDrawnHeight;
+	const unsigned remainder = (g_targetResX - 1) - lastDrawnHeight;
 
 	// discard alpha
 	beamCol &= 0xffffff;
@@ -196,14 +208,14 @@ static void vball_ray_beams(uint32_t *pDest, int curX, int curY, int dX, int dY)
 	float curStep = 0.f;
 	for (unsigned iPixel = 0; iPixel < remainder; ++iPixel)
 	{
-		const float fBeamAlpha = smoothstepf(s_beamAlphaMin, fLuminosity, curStep);
+		const float fBeamAlpha = smoothstepf(rays.beamAlphaMin, fLuminosity, curStep);
 		const unsigned beamAlpha = unsigned(fBeamAlpha);
 		pDest[lastDrawnHeight++] = beamCol | (beamAlpha << 24);
 		curStep += alphaStep;
 	}
 }
 
-static void vball_ray_no_beams(uint32_t *pDest, int curX, int curY, int dX, int dY)
+static void vball_ray_no_beams(const VballRays &rays, uint32_t *pDest, int curX, int curY, int dX, int dY)
 {
 	// grab first color
 	unsigned int U0, V0, U1, V1, fracU, fracV;
@@ -282,7 +294,7 @@ static void vball_ray_no_beams(uint32_t *pDest, int curX, int curY, int dX, int
 
 static void vball_precalc()
 {
-	const float radius = clampf(1.f, kMaxBallRadius, Rocket::getf(trackBallRadius));
+	const float radius = clampf(1.f, kMaxBallRadius, Rocket::getf(trackBallRadius))*g_resScale;
 	s_curRayLength = clampi(1, kMaxRayLength, Rocket::geti(trackBallRayLength));
 
 	// heights along ray wrap around half a circle
@@ -307,60 +319,44 @@ static void vball_precalc()
 	}
 }
 
-// expected sizes:
-// - maps: 1024x1024
-static void vball(uint32_t *pDest, float time)
+static VballRays vball_setup(float time)
 {
 	// precalc. projection map (FIXME: it's just a multiplication and a sine, can't we move this to the ray function already?)
 	vball_precalc();
 
-	// set global parameters
-	s_beamAtten = clampi(0, 255, Rocket::geti(trackBallBeamAtten));
-	s_beamAlphaMin = clampf(0.f, 255.f, Rocket::getf(trackBallBeamAlphaMin));
+	VballRays rays;
+
+	// beam parameters
+	rays.beamAtten = clampi(0, 255, Rocket::geti(trackBallBeamAtten));
+	rays.beamAlphaMin = clampf(0.f, 255.f, Rocket::getf(trackBallBeamAlphaMin));
 
 	// select if has beams
-	void (*vball_ray_fn)(uint32_t *, int, int, int, int);
 	const bool hasBeams = Rocket::geti(trackBallHasBeams) != 0;
-	vball_ray_fn = hasBeams? &vball_ray_beams : &vball_ray_no_beams;
+	rays.fn = hasBeams? &vball_ray_beams : &vball_ray_no_beams;
 
 	// move ray origin to fake hacky rotation 
 	const float timeScale = s_curRayLength*(0.25f/kMaxRayLength);
 	const float fMapDim = float(kMapSize);
 	const float fMapHalf = fMapDim*0.5f;
-	const int fromX = ftofp24(fMapDim*sinf(time*timeScale) + fMapHalf + Rocket::getf(trackBallRotateOffsX));
-	const int fromY = ftofp24(fMapDim*cosf(time*timeScale) + fMapHalf + Rocket::getf(trackBallRotateOffsY));
+	rays.fromX = ftofp24(fMapDim*sinf(time*timeScale) + fMapHalf + Rocket::getf(trackBallRotateOffsX));
+	rays.fromY = ftofp24(fMapDim*cosf(time*timeScale) + fMapHalf + Rocket::getf(trackBallRotateOffsY));
+
+	return rays;
+}
 
+static void vball_rays(uint32_t *pDest, const VballRays &rays, unsigned firstRay, unsigned numRays)
+{
 	// FOV (full circle)
 	constexpr float fovAngle = k2PI;
-	constexpr float delta = fovAngle/(kTargetResY-1);
-
-	// cast rays
-	if (false == hasBeams)
-	{
-		// FIXME: temporary release fix: no threading and erase buffer first, that "fixes" a glitch bug (issue @ Github)
-		memset32(pDest, 0, kTargetSize);
+	const float delta = fovAngle/(g_targetResY-1);
 
-//		#pragma omp parallel for schedule(dynamic)
-		for (unsigned iRay = 0; iRay < kTargetResY; ++iRay)
-		{
-			const float curAngle = iRay*delta;
-			float dX, dY;
-			voxel::calc_fandeltas(curAngle, dX, dY);
-			vball_ray_fn(pDest + iRay*kTargetResX, fromX, fromY, ftofp24(dX), ftofp24(dY));
-		}
-	}
-	else
+	const unsigned endRay = std::min<unsigned>(firstRay+numRays, g_targetResY);
+	for (unsigned iRay = firstRay; iRay < endRay; ++iRay)
 	{
-		// FIXME: beam version works glitchless or is it just not visible due to beams saturating the result?
-		// FIXME: I really wonder if throwing "all" threads at this is worth the overhead -> measure
-		#pragma omp parallel for schedule(dynamic)
-		for (unsigned iRay = 0; iRay < kTargetResY; ++iRay)
-		{
-			const float curAngle = iRay*delta;
-			float dX, dY;
-			voxel::calc_fandeltas(curAngle, dX, dY);
-			vball_ray_fn(pDest + iRay*kTargetResX, fromX, fromY, ftofp24(dX), ftofp24(dY));
-		}
+		const float curAngle = iRay*delta;
+		float dX, dY;
+		voxel::calc_fandeltas(curAngle, dX, dY);
+		rays.fn(rays, pDest + iRay*g_targetResX, rays.fromX, rays.fromY, ftofp24(dX), ftofp24(dY));
 	}
 }
 
@@ -409,17 +405,17 @@ bool Ball_Create()
 		return false;
 
 	// load backgrounds (1280x720)
-	s_pBackgrounds[0] = Image_Load32("assets/ball/nytrik-background_1280x720.png");
-	s_pBackgrounds[1] = Image_Load32("assets/ball/nytrik-background-2-1280x720.png");
+	s_pBackgrounds[0] = Image_Load32_Res("assets/ball/nytrik-background_1280x720.png");
+	s_pBackgrounds[1] = Image_Load32_Res("assets/ball/nytrik-background-2-1280x720.png");
 	if (nullptr == s_pBackgrounds[0] || nullptr == s_pBackgrounds[1])
 		return false;
 
 	// alloc. mix maps
-	s_heightMapMix = static_cast<uint8_t*>(mallocAligned(kMapSize*kMapSize*sizeof(uint8_t), kAlignTo));
-	s_pBeamMapMix  = static_cast<uint32_t*>(mallocAligned(kMapSize*kMapSize*sizeof(uint32_t), kAlignTo));
+	s_heightMapMix = static_cast<uint8_t*>(mallocLarge(kMapSize*kMapSize*sizeof(uint8_t), "ball"));
+	s_pBeamMapMix  = static_cast<uint32_t*>(mallocLarge(kMapSize*kMapSize*sizeof(uint32_t), "ball"));
 
 	// load halo (for beams)
-	s_pHalo = Image_Load32("assets/ball/halo.png");
+	s_pHalo = Image_Load32_Res("assets/ball/halo.png");
 	if (nullptr == s_pHalo)
 		return false;
 
@@ -445,70 +441,129 @@ bool Ball_Create()
 
 void Ball_Destroy()
 {
-	freeAligned(s_heightMapMix);
-	freeAligned(s_pBeamMapMix);
+	freeLarge(s_heightMapMix);
+	freeLarge(s_pBeamMapMix);
 }
 
+// band sizes for the task graph (see Ball_Draw())
+constexpr unsigned kMapBandRows = 64;
+constexpr unsigned kRayBandSize = 16;
+constexpr unsigned kTargetBandRows = 32;
+
+static TaskGraph s_graph("Ball");
+
 void Ball_Draw(uint32_t *pDest, float time, float delta)
 {
-	constexpr size_t mapNumPixels = kMapSize*kMapSize;
-
 	const bool hasBeams = Rocket::geti(trackBallHasBeams) != 0;
 
+	/*
+		map mixing (height & beams) and ray casting setup are independent; everything that's row-bound (mixing,
+		blur, composition) goes in bands and the rays in small batches; the background is read by the composition
+		directly, so it isn't copied first
+	*/
+
 	// blend between map (1-4) and and #0 (spikes)
 	const unsigned iBaseMap = clampi(1, 4, Rocket::geti(trackBallBaseShapeIndex));
-	memcpy_fast(s_heightMapMix, s_pHeightMap[iBaseMap], kMapSize*kMapSize);
-
 	const uint8_t spikes = uint8_t(Rocket::geti(trackBallSpikes));
-	if (0 != spikes)
-		Mix32(reinterpret_cast<uint32_t *>(s_heightMapMix), reinterpret_cast<uint32_t*>(s_pHeightMap[0]), mapNumPixels/4 /* function processes 4 8-bit components at a time */, spikes);
 
-	if (true == hasBeams)
+	const auto heightMix = s_graph.Add("height mix", NumBands(kMapSize, kMapBandRows), [=](unsigned iBand)
+	{
+		const size_t offset = iBand*kMapBandRows*kMapSize;
+		const size_t numPixels = kMapBandRows*kMapSize;
+
+		memcpy_fast(s_heightMapMix + offset, s_pHeightMap[iBaseMap] + offset, numPixels);
+
+		if (0 != spikes)
+			Mix32(reinterpret_cast<uint32_t *>(s_heightMapMix + offset), reinterpret_cast<uint32_t*>(s_pHeightMap[0] + offset), unsigned(numPixels/4) /* function processes 4 8-bit components at a time */, spikes);
+	});
+
+	// blend beam maps (if any)
+	const float beamA1 = saturatef(Rocket::getf(trackBallBeams1));
+	const float beamA2 = saturatef(Rocket::getf(trackBallBeams2));
+	const float beamA3 = saturatef(Rocket::getf(trackBallBeams3));
+
+	const auto beamMix = s_graph.Add("beam mix", NumBands(kMapSize, kMapBandRows), [=](unsigned iBand)
 	{
-		// blend beam maps
-		const float beamA1 = saturatef(Rocket::getf(trackBallBeams1));
-		const float beamA2 = saturatef(Rocket::getf(trackBallBeams2));
-		const float beamA3 = saturatef(Rocket::getf(trackBallBeams3));
+		if (false == hasBeams)
+			return;
 
-		memset32(s_pBeamMapMix, 0, kMapSize*kMapSize);
+		const size_t offset = iBand*kMapBandRows*kMapSize;
+		uint32_t *pBand = s_pBeamMapMix + offset;
+
+		memset32(pBand, 0, kMapBandRows*kMapSize);
 		if (beamA1 > 0.f)
-			BlitAdd32A(s_pBeamMapMix, s_pBeamMaps[0], kMapSize, kMapSize, kMapSize, beamA1);
+			BlitAdd32A(pBand, s_pBeamMaps[0] + offset, kMapSize, kMapSize, kMapBandRows, beamA1);
 		if (beamA2 > 0.f)
-			BlitAdd32A(s_pBeamMapMix, s_pBeamMaps[1], kMapSize, kMapSize, kMapSize, beamA2);
+			BlitAdd32A(pBand, s_pBeamMaps[1] + offset, kMapSize, kMapSize, kMapBandRows, beamA2);
 		if (beamA3 > 0.f)
-			BlitAdd32A(s_pBeamMapMix, s_pBeamMaps[2], kMapSize, kMapSize, kMapSize, beamA3);
-	}
+			BlitAdd32A(pBand, s_pBeamMaps[2] + offset, kMapSize, kMapSize, kMapBandRows, beamA3);
+	});
+
+	// background (2 of them, one for the object *with* beams, one for without)
+	const auto* pBackground = hasBeams ? s_pBackgrounds[0] : s_pBackgrounds[1];
 
 	// render unwrapped ball
-	vball(g_renderTarget[0], time * Rocket::getf(trackBallSpeed));
+	VballRays rays;
+	const float ballTime = time * Rocket::getf(trackBallSpeed);
+	const auto raySetup = s_graph.Add("ray setup", [&rays, ballTime]() { rays = vball_setup(ballTime); });
+
+	uint32_t *pTarget = g_renderTarget[0];
+
+	TaskGraph::Task rayCast;
+	if (false == hasBeams)
+	{
+		// FIXME: temporary release fix: no threading and erase buffer first, that "fixes" a glitch bug (issue @ Github)
+		rayCast = s_graph.Add("rays", [&rays, pTarget]()
+		{
+			memset32(pTarget, 0, g_targetSize);
+			vball_rays(pTarget, rays, 0, g_targetResY);
+		}, { heightMix, raySetup });
+	}
+	else
+	{
+		// FIXME: beam version works glitchless or is it just not visible due to beams saturating the result?
+		rayCast = s_graph.Add("rays", NumBands(g_targetResY, kRayBandSize), [&rays, pTarget](unsigned iBatch)
+		{
+			vball_rays(pTarget, rays, iBatch*kRayBandSize, kRayBandSize);
+		}, { heightMix, beamMix, raySetup });
+	}
 
-#if 1
 	// blur (optional)
 	const float blur = BoxBlurScale(Rocket::getf(trackBallBlur));
-	if (0.f != blur)
-		HorizontalBoxBlur32(g_renderTarget[0], g_renderTarget[0], kResX, kResY, blur);
-#endif
+	const auto blurred = s_graph.Add("blur", NumBands(g_targetResY, kTargetBandRows), [=](unsigned iBand)
+	{
+		if (0.f == blur)
+			return;
 
-	// blit (polar wrap) effect on top of background (2 of them, one for the object *with* beams, one for without)
-	const auto* pBackground = hasBeams ? s_pBackgrounds[0] : s_pBackgrounds[1];
-	memcpy(pDest, pBackground, kOutputBytes);
-//	memset32(pDest, 0, kOutputSize);
-	Polar_BlitA(pDest, g_renderTarget[0], false);
+		const unsigned firstRow = iBand*kTargetBandRows;
+		const Rect band = { 0, firstRow, unsigned(g_targetResX), std::min<unsigned>(kTargetBandRows, unsigned(g_targetResY)-firstRow) };
+		HorizontalBoxBlur32R(pTarget, pTarget, band, g_targetResX, blur);
+	}, { rayCast });
 
-	if (true == hasBeams)
+	s_graph.Add("composition", g_polarNumBands, [=](unsigned iBand)
 	{
-//		SoftLight32AA(pDest, pBackground, kOutputSize, 0.314f);
-		SoftLight32A(pDest, s_pHalo, kOutputSize);
-	}
+		// blit (polar wrap) effect on top of background
+		Polar_BlitA_Band(pDest, pBackground, pTarget, iBand);
+
+		if (true == hasBeams)
+		{
+			const size_t offset = iBand*kPolarBandRows*g_resX;
+			const size_t numPixels = std::min<size_t>(kPolarBandRows*g_resX, g_outputSize-offset);
+//			SoftLight32AA(pDest + offset, pBackground + offset, unsigned(numPixels), 0.314f);
+			SoftLight32A(pDest + offset, s_pHalo + offset, unsigned(numPixels));
+		}
+	}, { blurred });
+
+	s_graph.Run();
 
 #if 0
 	// debug blit: unwrapped
 	const uint32_t *pSrc = g_renderTarget[0];
-	for (unsigned int iY = 0; iY < kResY; ++iY)
+	for (unsigned int iY = 0; iY < g_resY; ++iY)
 	{
-		memcpy(pDest, pSrc, kTargetResX*4);
-		pSrc += kTargetResX;
-		pDest += kResX;
+		memcpy(pDest, pSrc, g_targetResX*4);
+		pSrc += g_targetResX;
+		pDest += g_resX;
 	}
 #endif
 }
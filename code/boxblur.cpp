@@ -13,6 +13,7 @@
 //   so for now I simply hide behind my readily available RAM
 
 #include "main.h"
+#include "alloc-large.h"
 #include "boxblur.h"
 
 constexpr size_t kMaxRes = 2048;
@@ -22,15 +23,15 @@ static uint32_t *s_pScratch[2] = { nullptr };
 
 bool BoxBlur_Create()
 {
-	s_pScratch[0] = (uint32_t *) mallocAligned(kScratchSize*sizeof(uint32_t), kAlignTo);
-	s_pScratch[1] = (uint32_t *) mallocAligned(kScratchSize*sizeof(uint32_t), kAlignTo);
+	s_pScratch[0] = (uint32_t *) mallocLarge(kScratchSize*sizeof(uint32_t), "box blur");
+	s_pScratch[1] = (uint32_t *) mallocLarge(kScratchSize*sizeof(uint32_t), "box blur");
 	return true;	
 }
 
 void BoxBlur_Destroy() 
 {
 	for (auto *pAlloc : s_pScratch)
-		freeAligned(pAlloc);
+		freeLarge(pAlloc);
 }
 
 // ref.
@@ -0,0 +1,329 @@
+// cookiedough -- YUV4MPEG2 (.y4m) capture
+
+#include "main.h"
+#include "alloc-large.h"
+#include "capture.h"
+
+#include <stdio.h>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+#if defined(_WIN32)
+	#include <io.h>
+	#include <fcntl.h>
+#else
+	#include <unistd.h>
+#endif
+
+// frames in flight (converted, not yet written)
+constexpr size_t kNumSlots = 4;
+
+static FILE *s_file = nullptr;
+static bool s_isStdout = false;
+
+static unsigned s_resX = 0, s_resY = 0, s_fps = 0;
+static size_t s_frameBytes = 0;
+
+static uint8_t *s_pSlots[kNumSlots] = { nullptr };
+static std::deque<uint8_t *> s_free, s_full;
+static std::mutex s_mutex;
+static std::condition_variable s_freed, s_filled;
+static bool s_stop = false;
+static std::thread s_writer;
+
+/*
+	ARGB8888 to YUV 4:2:0 (BT.709, limited range) in 8:8 fixed point:
+
+	Y  =  16 + ( 47*R + 157*G +  16*B) / 256
+	Cb = 128 + (-26*R -  86*G + 112*B) / 256
+	Cr = 128 + (112*R - 102*G -  10*B) / 256
+
+	Chroma is taken from the average of each 2x2 block (which is where 'C420jpeg' sites it).
+*/
+
+// per pixel B, G, R, A (as laid out in memory), 2 pixels per vector for _mm_madd_epi16()
+static const __m128i kCoeffsY  = _mm_setr_epi16( 16,  157,  47, 0,  16,  157,  47, 0);
+static const __m128i kCoeffsCb = _mm_setr_epi16(112,  -86, -26, 0, 112,  -86, -26, 0);
+static const __m128i kCoeffsCr = _mm_setr_epi16(-10, -102, 112, 0, -10, -102, 112, 0);
+
+// dot product of 4 pixels and coefficients (32-bit, 8:8 fixed point, rounded)
+CKD_INLINE static __m128i Dot4(__m128i pixels, __m128i coeffs)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i lo = _mm_madd_epi16(_mm_unpacklo_epi8(pixels, zero), coeffs);
+	const __m128i hi = _mm_madd_epi16(_mm_unpackhi_epi8(pixels, zero), coeffs);
+	return _mm_srai_epi32(_mm_add_epi32(_mm_hadd_epi32(lo, hi), _mm_set1_epi32(128)), 8);
+}
+
+// 8 pixels (2 vectors) to 8 luma samples
+CKD_INLINE static void StoreY8(uint8_t *pY, __m128i A, __m128i B)
+{
+	const __m128i Y = _mm_add_epi16(_mm_packs_epi32(Dot4(A, kCoeffsY), Dot4(B, kCoeffsY)), _mm_set1_epi16(16));
+	_mm_storel_epi64(reinterpret_cast<__m128i*>(pY), _mm_packus_epi16(Y, Y));
+}
+
+static void ConvertFrame(uint8_t *pDest, const uint32_t *pSrc)
+{
+	const unsigned chromaResX = s_resX>>1;
+
+	uint8_t *pDestY = pDest;
+	uint8_t *pDestU = pDestY + s_resX*s_resY;
+	uint8_t *pDestV = pDestU + chromaResX*(s_resY>>1);
+
+	#pragma omp parallel for schedule(static)
+	for (int iPair = 0; iPair < int(s_resY>>1); ++iPair)
+	{
+		const unsigned iY = iPair<<1;
+
+		const __m128i *pRow0 = reinterpret_cast<const __m128i*>(pSrc + iY*s_resX);
+		const __m128i *pRow1 = reinterpret_cast<const __m128i*>(pSrc + (iY+1)*s_resX);
+
+		uint8_t *pY0 = pDestY + iY*s_resX;
+		uint8_t *pY1 = pY0 + s_resX;
+		uint8_t *pU = pDestU + iPair*chromaResX;
+		uint8_t *pV = pDestV + iPair*chromaResX;
+
+		for (unsigned iX = 0; iX < s_resX; iX += 8)
+		{
+			const __m128i A0 = _mm_loadu_si128(pRow0 + (iX>>2));
+			const __m128i B0 = _mm_loadu_si128(pRow0 + (iX>>2) + 1);
+			const __m128i A1 = _mm_loadu_si128(pRow1 + (iX>>2));
+			const __m128i B1 = _mm_loadu_si128(pRow1 + (iX>>2) + 1);
+
+			StoreY8(pY0 + iX, A0, B0);
+			StoreY8(pY1 + iX, A1, B1);
+
+			// average vertically, then horizontally (pairs end up in even lanes), then gather the 4 averages
+			const __m128i avgA = _mm_avg_epu8(A0, A1);
+			const __m128i avgB = _mm_avg_epu8(B0, B1);
+			const __m128i pairsA = _mm_avg_epu8(avgA, _mm_shuffle_epi32(avgA, _MM_SHUFFLE(2, 3, 0, 1)));
+			const __m128i pairsB = _mm_avg_epu8(avgB, _mm_shuffle_epi32(avgB, _MM_SHUFFLE(2, 3, 0, 1)));
+			const __m128i blocks = _mm_unpacklo_epi64(
+				_mm_shuffle_epi32(pairsA, _MM_SHUFFLE(3, 1, 2, 0)),
+				_mm_shuffle_epi32(pairsB, _MM_SHUFFLE(3, 1, 2, 0)));
+
+			const __m128i UV16 = _mm_add_epi16(_mm_packs_epi32(Dot4(blocks, kCoeffsCb), Dot4(blocks, kCoeffsCr)), _mm_set1_epi16(128));
+			const __m128i UV8 = _mm_packus_epi16(UV16, UV16);
+
+			const int U = _mm_cvtsi128_si32(UV8);
+			const int V = _mm_cvtsi128_si32(_mm_srli_si128(UV8, 4));
+			memcpy(pU + (iX>>1), &U, 4);
+			memcpy(pV + (iX>>1), &V, 4);
+		}
+	}
+}
+
+static void WriterThread()
+{
+	for (;;)
+	{
+		uint8_t *pFrame;
+
+		{
+			std::unique_lock<std::mutex> lock(s_mutex);
+			s_filled.wait(lock, [] { return false == s_full.empty() || true == s_stop; });
+
+			if (true == s_full.empty())
+				break; // stopped & flushed
+
+			pFrame = s_full.front();
+			s_full.pop_front();
+		}
+
+		fputs("FRAME\n", s_file);
+		fwrite(pFrame, 1, s_frameBytes, s_file);
+
+		{
+			std::lock_guard<std::mutex> lock(s_mutex);
+			s_free.push_back(pFrame);
+		}
+
+		s_freed.notify_one();
+	}
+
+	fflush(s_file);
+}
+
+static std::string FormatHeader(unsigned resX, unsigned resY, unsigned fps)
+{
+	char header[256];
+	snprintf(header, 256, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg XYSCSS=420JPEG XCOLORRANGE=LIMITED\n", resX, resY, fps);
+	return header;
+}
+
+bool Capture_Create(const std::string &path, unsigned resX, unsigned resY, unsigned fps)
+{
+	VIZ_ASSERT(nullptr == s_file);
+
+	if (0 != (resX & 7) || 0 != (resY & 1))
+	{
+		SetLastError("Can't capture at resolution: " + std::to_string(resX) + "x" + std::to_string(resY));
+		return false;
+	}
+
+	if ("-" == path)
+	{
+#if defined(_WIN32)
+		_setmode(_fileno(stdout), _O_BINARY);
+		s_file = stdout;
+#else
+		// keep the stream to ourselves: anything printed from here on goes to stderr
+		fflush(stdout);
+		const int streamFD = dup(STDOUT_FILENO);
+		dup2(STDERR_FILENO, STDOUT_FILENO);
+		s_file = fdopen(streamFD, "wb");
+#endif
+		s_isStdout = true;
+	}
+	else
+		s_file = fopen(path.c_str(), "wb");
+
+	if (nullptr == s_file)
+	{
+		SetLastError("Can't open capture output: " + path);
+		return false;
+	}
+
+	s_resX = resX;
+	s_resY = resY;
+	s_frameBytes = size_t(resX)*resY*3/2;
+
+	s_fps = fps;
+	fputs(FormatHeader(resX, resY, fps).c_str(), s_file);
+
+	for (auto &pSlot : s_pSlots)
+	{
+		pSlot = static_cast<uint8_t*>(mallocLarge(s_frameBytes, "capture"));
+		s_free.push_back(pSlot);
+	}
+
+	s_stop = false;
+	s_writer = std::thread(WriterThread);
+
+	return true;
+}
+
+void Capture_Destroy()
+{
+	if (nullptr == s_file)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		s_stop = true;
+	}
+
+	s_filled.notify_one();
+	s_writer.join();
+
+#if defined(_WIN32)
+	if (false == s_isStdout)
+		fclose(s_file);
+#else
+	fclose(s_file); // on stdout it's our own duplicate
+#endif
+
+	s_file = nullptr;
+	s_isStdout = false;
+
+	for (auto &pSlot : s_pSlots)
+	{
+		freeLarge(pSlot);
+		pSlot = nullptr;
+	}
+
+	s_free.clear();
+	s_full.clear();
+}
+
+bool Capture_IsActive()
+{
+	return nullptr != s_file;
+}
+
+void Capture_Frame(const uint32_t *pPixels)
+{
+	if (nullptr == s_file)
+		return;
+
+	uint8_t *pFrame;
+
+	{
+		std::unique_lock<std::mutex> lock(s_mutex);
+		s_freed.wait(lock, [] { return false == s_free.empty(); });
+
+		pFrame = s_free.front();
+		s_free.pop_front();
+	}
+
+	ConvertFrame(pFrame, pPixels);
+
+	{
+		std::lock_guard<std::mutex> lock(s_mutex);
+		s_full.push_back(pFrame);
+	}
+
+	s_filled.notify_one();
+}
+
+int Capture_Append(const std::string &path, unsigned numSkip /* = 0 */, std::vector<uint8_t> *pSkipped /* = nullptr */, std::vector<uint8_t> *pLast /* = nullptr */)
+{
+	VIZ_ASSERT(nullptr != s_file);
+
+	FILE *file = fopen(path.c_str(), "rb");
+	if (nullptr == file)
+	{
+		SetLastError("Can't open capture stream: " + path);
+		return -1;
+	}
+
+	// header must be identical to ours
+	char header[256];
+	if (nullptr == fgets(header, 256, file) || FormatHeader(s_resX, s_resY, s_fps) != header)
+	{
+		fclose(file);
+		SetLastError("Capture stream format mismatch: " + path);
+		return -1;
+	}
+
+	// wait for frames in flight
+	{
+		std::unique_lock<std::mutex> lock(s_mutex);
+		s_freed.wait(lock, [] { return kNumSlots == s_free.size(); });
+	}
+
+	const size_t recordBytes = 6 /* "FRAME\n" */ + s_frameBytes;
+	// 2 so the last frame appended is still around when a read fails
+	std::unique_ptr<uint8_t[]> records[2] = { std::unique_ptr<uint8_t[]>(new uint8_t[recordBytes]), std::unique_ptr<uint8_t[]>(new uint8_t[recordBytes]) };
+	unsigned iRecord = 0;
+
+	int numFrames = 0;
+	while (recordBytes == fread(records[iRecord].get(), 1, recordBytes, file))
+	{
+		const uint8_t *pRecord = records[iRecord].get();
+
+		if (numSkip > 0)
+		{
+			--numSkip;
+			if (nullptr != pSkipped)
+				pSkipped->assign(pRecord, pRecord+recordBytes);
+
+			continue;
+		}
+
+		fwrite(pRecord, 1, recordBytes, s_file);
+		++numFrames;
+
+		iRecord ^= 1;
+	}
+
+	if (nullptr != pLast && numFrames > 0)
+	{
+		const uint8_t *pRecord = records[iRecord^1].get();
+		pLast->assign(pRecord, pRecord+recordBytes);
+	}
+
+	fclose(file);
+	return numFrames;
+}
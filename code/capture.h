@@ -0,0 +1,30 @@
+// cookiedough -- YUV4MPEG2 (.y4m) capture
+
+/*
+	Writes presented frames as an uncompressed YUV 4:2:0 stream (BT.709, limited range) that any encoder can eat, e.g.:
+
+	cookiedough 1920x1080 -y4m - | ffmpeg -i - -c:v libx264 -crf 16 capture.mp4
+
+	- path "-" means stdout; on Linux & OSX regular stdout output is moved to stderr so it doesn't end up in the stream
+	- conversion is done (in parallel) by Capture_Frame(), writing on a thread of it's own: Capture_Frame() only blocks
+	  if the disk (or pipe) can't keep up
+	- frames are captured as they are presented: if you're not hitting 'fps', the stream won't be in sync with the
+	  audio
+*/
+
+#pragma once
+
+// resolution must be a multiple of 8 (horizontally) and 2 (vertically)
+bool Capture_Create(const std::string &path, unsigned resX, unsigned resY, unsigned fps);
+void Capture_Destroy(); // flushes
+
+bool Capture_IsActive();
+
+// does nothing if not active
+void Capture_Frame(const uint32_t *pPixels);
+
+// appends all frames of another .y4m stream of the same format (e.g. rendered by another process, see render-farm.h)
+// - the first 'numSkip' frames are read but not appended, the last of those ends up in 'pSkipped' (if any)
+// - the last frame appended ends up in 'pLast' (if any)
+// returns number of frames appended, or -1 on failure
+int Capture_Append(const std::string &path, unsigned numSkip = 0, std::vector<uint8_t> *pSkipped = nullptr, std::vector<uint8_t> *pLast = nullptr);
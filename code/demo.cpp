@@ -4,13 +4,19 @@
 #include "main.h"
 #include "demo.h"
 #include "rocket.h"
+#include "audio.h"
 #include "image.h"
+#include "frame-cache.h"
 
 // filters & blitters
 #include "boxblur.h"
 #include "deprecated/boxblur.h"
 #include "polar.h"
 #include "fx-blitter.h"
+#include "fx-governor.h"
+#include "target-pool.h"
+#include "layer-cache.h"
+#include "sprite-batch.h"
 
 // effects
 #include "ball.h"
@@ -22,8 +28,11 @@
 // 3D engine (doesn't that sound 'delightfully 1997')
 #include "retro3D/retro3D.h"
 
-// for this production:
-static_assert(kResX == 1280 && kResY == 720);
+// for this production (sizes and offsets below are in these pixels, see ToRes()):
+static_assert(kAuthorResX == 1280 && kAuthorResY == 720);
+
+// memory spent on keeping blended/blurred logos around (see layer-cache.h)
+constexpr size_t kLayerCacheBudget = 64*1024*1024;
 
 // --- Sync. tracks ---
 
@@ -63,6 +72,7 @@ SyncTrack trackFullWarpTPB;
 static uint32_t *s_pCredits[4] = { nullptr };
 constexpr auto kCredX = 1280;
 constexpr auto kCredY = 568;
+static unsigned s_credX, s_credY; // scaled (see ToRes())
 static uint32_t *s_pComatron[5] = { nullptr };
 static uint32_t *s_pSuperplek[5] = { nullptr };
 static uint32_t *s_pJadeNytrik[5] = { nullptr };
@@ -105,6 +115,7 @@ static uint32_t *s_pNautilusCousteauRim1 = nullptr;
 static uint32_t* s_pNautilusCousteauRim2 = nullptr;
 static uint32_t *s_pNautilusCousteau2 = nullptr;
 static uint32_t *s_pNautilusText = nullptr;
+static Rect s_nautilusTextRect;
 
 // disco guys (hello Thorsten, TPB-06) + melancholic numbers to accompany them
 static uint32_t *s_pDiscoGuys[8] = { nullptr };
@@ -135,11 +146,18 @@ constexpr unsigned kLenzSize = 64;
 
 // --------------------
 
+// shooting star trail, disco guys et cetera
+static SpriteBatch s_sprites;
+
+// --------------------
+
 bool Demo_Create()
 {
 	if (false == Rocket::Launch())
 		return false;
 
+	LayerCache_Create(kLayerCacheBudget);
+
 	bool fxInit = true;
 	fxInit &= Twister_Create();
 	fxInit &= Landscape_Create();
@@ -201,80 +219,82 @@ bool Demo_Create()
 	trackCloseUpMoonrakerTextBlur = Rocket::AddTrack("closeSpike:MoonrakerBlur");
 
 	// load credits logos (1280x568)
-	s_pCredits[0] = Image_Load32("assets/credits/Credits_Tag_Superplek_outlined.png");
-	s_pCredits[1] = Image_Load32("assets/credits/Credits_Tag_Comatron_Featuring_Celin_outlined.png");
-	s_pCredits[2] = Image_Load32("assets/credits/Credits_Tag_Jade_outlined.png");
-	s_pCredits[3] = Image_Load32("assets/credits/Credits_Tag_ErnstHot_outlined_new.png");
+	s_credX = unsigned(ToRes(kCredX));
+	s_credY = unsigned(ToRes(kCredY));
+	s_pCredits[0] = Image_Load32_Res("assets/credits/Credits_Tag_Superplek_outlined.png");
+	s_pCredits[1] = Image_Load32_Res("assets/credits/Credits_Tag_Comatron_Featuring_Celin_outlined.png");
+	s_pCredits[2] = Image_Load32_Res("assets/credits/Credits_Tag_Jade_outlined.png");
+	s_pCredits[3] = Image_Load32_Res("assets/credits/Credits_Tag_ErnstHot_outlined_new.png");
 	for (auto *pImg : s_pCredits)
 		if (nullptr == pImg)
 			return false;
 	
-	s_pComatron[0] = Image_Load32("assets/credits/comatron_anim/comatron_1.png");
-	s_pComatron[1] = Image_Load32("assets/credits/comatron_anim/comatron_2.png");
-	s_pComatron[2] = Image_Load32("assets/credits/comatron_anim/comatron_3.png");
-	s_pComatron[3] = Image_Load32("assets/credits/comatron_anim/comatron_4.png");
-	s_pComatron[4] = Image_Load32("assets/credits/comatron_anim/comatron_5.png");
+	s_pComatron[0] = Image_Load32_Res("assets/credits/comatron_anim/comatron_1.png");
+	s_pComatron[1] = Image_Load32_Res("assets/credits/comatron_anim/comatron_2.png");
+	s_pComatron[2] = Image_Load32_Res("assets/credits/comatron_anim/comatron_3.png");
+	s_pComatron[3] = Image_Load32_Res("assets/credits/comatron_anim/comatron_4.png");
+	s_pComatron[4] = Image_Load32_Res("assets/credits/comatron_anim/comatron_5.png");
 	for (auto *pImg : s_pComatron)
 		if (nullptr == pImg)
 			return false;
 
-	s_pSuperplek[0] = Image_Load32("assets/credits/animplek/animplek0.png");
-	s_pSuperplek[1] = Image_Load32("assets/credits/animplek/animplek1.png");
-	s_pSuperplek[2] = Image_Load32("assets/credits/animplek/animplek2.png");
-	s_pSuperplek[3] = Image_Load32("assets/credits/animplek/animplek3.png");
-	s_pSuperplek[4] = Image_Load32("assets/credits/animplek/animplek4.png");
+	s_pSuperplek[0] = Image_Load32_Res("assets/credits/animplek/animplek0.png");
+	s_pSuperplek[1] = Image_Load32_Res("assets/credits/animplek/animplek1.png");
+	s_pSuperplek[2] = Image_Load32_Res("assets/credits/animplek/animplek2.png");
+	s_pSuperplek[3] = Image_Load32_Res("assets/credits/animplek/animplek3.png");
+	s_pSuperplek[4] = Image_Load32_Res("assets/credits/animplek/animplek4.png");
 	for (auto *pImg : s_pSuperplek)
 		if (nullptr == pImg)
 			return false;
 
-	s_pJadeNytrik[0] = Image_Load32("assets/credits/jade&nytrik/jade&nytrik0.png");
-	s_pJadeNytrik[1] = Image_Load32("assets/credits/jade&nytrik/jade&nytrik1.png");
-	s_pJadeNytrik[2] = Image_Load32("assets/credits/jade&nytrik/jade&nytrik2.png");
-	s_pJadeNytrik[3] = Image_Load32("assets/credits/jade&nytrik/jade&nytrik3.png");
-	s_pJadeNytrik[4] = Image_Load32("assets/credits/jade&nytrik/jade&nytrik4.png");
+	s_pJadeNytrik[0] = Image_Load32_Res("assets/credits/jade&nytrik/jade&nytrik0.png");
+	s_pJadeNytrik[1] = Image_Load32_Res("assets/credits/jade&nytrik/jade&nytrik1.png");
+	s_pJadeNytrik[2] = Image_Load32_Res("assets/credits/jade&nytrik/jade&nytrik2.png");
+	s_pJadeNytrik[3] = Image_Load32_Res("assets/credits/jade&nytrik/jade&nytrik3.png");
+	s_pJadeNytrik[4] = Image_Load32_Res("assets/credits/jade&nytrik/jade&nytrik4.png");
 	for (auto *pImg : s_pJadeNytrik)
 		if (nullptr == pImg)
 			return false;
 
-	s_pErnstHot[0] = Image_Load32("assets/credits/animhot0/animhot0.png");
-	s_pErnstHot[1] = Image_Load32("assets/credits/animhot0/animhot1.png");
-	s_pErnstHot[2] = Image_Load32("assets/credits/animhot0/animhot2.png");
-	s_pErnstHot[3] = Image_Load32("assets/credits/animhot0/animhot3.png");
-	s_pErnstHot[4] = Image_Load32("assets/credits/animhot0/animhot4.png");
+	s_pErnstHot[0] = Image_Load32_Res("assets/credits/animhot0/animhot0.png");
+	s_pErnstHot[1] = Image_Load32_Res("assets/credits/animhot0/animhot1.png");
+	s_pErnstHot[2] = Image_Load32_Res("assets/credits/animhot0/animhot2.png");
+	s_pErnstHot[3] = Image_Load32_Res("assets/credits/animhot0/animhot3.png");
+	s_pErnstHot[4] = Image_Load32_Res("assets/credits/animhot0/animhot4.png");
 	for (auto *pImg : s_pErnstHot)
 		if (nullptr == pImg)
 			return false;
 
 	// load generic TPB-06 dirty vignette
-	s_pVignette06 = Image_Load32("assets/demo/tpb-06-dirty-vignette-1280x720.png");
+	s_pVignette06 = Image_Load32_Res("assets/demo/tpb-06-dirty-vignette-1280x720.png");
 	if (nullptr == s_pVignette06)
 		return false;
 	
 	// first appearance of the 'spikey ball' including the title and main group
-	s_pSpikeyArrested[0] = Image_Load32("assets/spikeball/Layer 2023_1.png");
-	s_pSpikeyArrested[1] = Image_Load32("assets/spikeball/Layer 2023_2.png");
-	s_pSpikeyArrested[2] = Image_Load32("assets/spikeball/Layer 2023_3.png");
-	s_pSpikeyArrested[3] = Image_Load32("assets/spikeball/Layer 2023_4.png");
-	s_pSpikeyVignette = Image_Load32("assets/spikeball/Vignette_CoolFilmLook.png");
-	s_pSpikeyVignette2 = Image_Load32("assets/spikeball/Vignette_Layer02_inverted.png");
-	s_pSpikeyBypass = Image_Load32("assets/spikeball/SpikeyBall_byPass_BG_Overlay.png");
-	s_pSpikeyFullDirt = Image_Load32("assets/spikeball/nytrik-TheYearWas_Overlay_LensDirt.jpg");
+	s_pSpikeyArrested[0] = Image_Load32_Res("assets/spikeball/Layer 2023_1.png");
+	s_pSpikeyArrested[1] = Image_Load32_Res("assets/spikeball/Layer 2023_2.png");
+	s_pSpikeyArrested[2] = Image_Load32_Res("assets/spikeball/Layer 2023_3.png");
+	s_pSpikeyArrested[3] = Image_Load32_Res("assets/spikeball/Layer 2023_4.png");
+	s_pSpikeyVignette = Image_Load32_Res("assets/spikeball/Vignette_CoolFilmLook.png");
+	s_pSpikeyVignette2 = Image_Load32_Res("assets/spikeball/Vignette_Layer02_inverted.png");
+	s_pSpikeyBypass = Image_Load32_Res("assets/spikeball/SpikeyBall_byPass_BG_Overlay.png");
+	s_pSpikeyFullDirt = Image_Load32_Res("assets/spikeball/nytrik-TheYearWas_Overlay_LensDirt.jpg");
 	const bool spikeyArresteds = nullptr == s_pSpikeyArrested[0] || nullptr == s_pSpikeyArrested[1] || nullptr == s_pSpikeyArrested[2] || nullptr == s_pSpikeyArrested[3];
 	if (true == spikeyArresteds || nullptr == s_pSpikeyBypass || nullptr == s_pSpikeyFullDirt || nullptr == s_pSpikeyVignette || nullptr == s_pSpikeyVignette2)
 		return false;
 
 	// NoooN et cetera
-	s_pNoooN[0] = Image_Load32("assets/tunnels/layer 1995_1.png");
-	s_pNoooN[1] = Image_Load32("assets/tunnels/layer 1995_2.png");
-	s_pNoooN[2] = Image_Load32("assets/tunnels/layer 1995_3.png");
-	s_pNoooN[3] = Image_Load32("assets/tunnels/layer 1995_4.png");
-	s_pMFX[0] = Image_Load32("assets/tunnels/layer 2006_1.png");
-	s_pMFX[1] = Image_Load32("assets/tunnels/layer 2006_2.png");
-	s_pMFX[2] = Image_Load32("assets/tunnels/layer 2006_3.png");
-	s_pMFX[3] = Image_Load32("assets/tunnels/layer 2006_4.png");
-	s_pTunnelFullDirt = Image_Load32("assets/tunnels/nytrik-TheYearWas_Overlay_LensDirt.png");
-	s_pTunnelVignette = Image_Load32("assets/tunnels/Vignette_CoolFilmLook.png");;
-	s_pTunnelVignette2 = Image_Load32("assets/tunnels/Vignette_Layer02_inverted.png");
+	s_pNoooN[0] = Image_Load32_Res("assets/tunnels/layer 1995_1.png");
+	s_pNoooN[1] = Image_Load32_Res("assets/tunnels/layer 1995_2.png");
+	s_pNoooN[2] = Image_Load32_Res("assets/tunnels/layer 1995_3.png");
+	s_pNoooN[3] = Image_Load32_Res("assets/tunnels/layer 1995_4.png");
+	s_pMFX[0] = Image_Load32_Res("assets/tunnels/layer 2006_1.png");
+	s_pMFX[1] = Image_Load32_Res("assets/tunnels/layer 2006_2.png");
+	s_pMFX[2] = Image_Load32_Res("assets/tunnels/layer 2006_3.png");
+	s_pMFX[3] = Image_Load32_Res("assets/tunnels/layer 2006_4.png");
+	s_pTunnelFullDirt = Image_Load32_Res("assets/tunnels/nytrik-TheYearWas_Overlay_LensDirt.png");
+	s_pTunnelVignette = Image_Load32_Res("assets/tunnels/Vignette_CoolFilmLook.png");;
+	s_pTunnelVignette2 = Image_Load32_Res("assets/tunnels/Vignette_Layer02_inverted.png");
 
 	const bool NoooN = nullptr == s_pNoooN[0] || nullptr == s_pNoooN[1] || nullptr == s_pNoooN[2] || nullptr == s_pNoooN[3];
 	const bool MFX = nullptr == s_pMFX[0] || nullptr == s_pMFX[1] || nullptr == s_pMFX[2] || nullptr == s_pMFX[3];
@@ -283,23 +303,23 @@ bool Demo_Create()
 		return false;
 	
 	// landscape
-	s_pGodLayer = Image_Load32("assets/demo/nytrik-god-layer-720p.png"); 
-	s_pRevLogo = Image_Load32("assets/scape/revision-logo_white.png");
+	s_pGodLayer = Image_Load32_Res("assets/demo/nytrik-god-layer-720p.png"); 
+	s_pRevLogo = Image_Load32_Res("assets/scape/revision-logo_white.png");
 	if (nullptr == s_pGodLayer || nullptr == s_pRevLogo)
 		return false;
 
 	// voxel ball
-	s_pBallVignette = Image_Load32("assets/ball/Vignette_Sparta300.png");
+	s_pBallVignette = Image_Load32_Res("assets/ball/Vignette_Sparta300.png");
 	if (nullptr == s_pBallVignette)
 		return false;
 
 	// greetings
-	s_pGreetingsDirt = Image_Load32("assets/greetings/Bokeh_Lens_Dirt_51.png");
-	s_pGreetings[0]= Image_Load32("assets/greetings/Greetings_Part1_BG_Overlay.png");
-	s_pGreetings[1] = Image_Load32("assets/greetings/Greetings_Part2_BG_Overlay.png");
-	s_pGreetings[2] = Image_Load32("assets/greetings/Greetings_Part3_BG_Overlay.png");
-	s_pGreetings[3] = Image_Load32("assets/greetings/Greetings_Part4_BG_Overlay.png");
-	s_pGreetingsVignette = Image_Load32("assets/greetings/Vignette_CoolFilmLook.png");
+	s_pGreetingsDirt = Image_Load32_Res("assets/greetings/Bokeh_Lens_Dirt_51.png");
+	s_pGreetings[0]= Image_Load32_Res("assets/greetings/Greetings_Part1_BG_Overlay.png");
+	s_pGreetings[1] = Image_Load32_Res("assets/greetings/Greetings_Part2_BG_Overlay.png");
+	s_pGreetings[2] = Image_Load32_Res("assets/greetings/Greetings_Part3_BG_Overlay.png");
+	s_pGreetings[3] = Image_Load32_Res("assets/greetings/Greetings_Part4_BG_Overlay.png");
+	s_pGreetingsVignette = Image_Load32_Res("assets/greetings/Vignette_CoolFilmLook.png");
 	if (
 		nullptr == s_pGreetingsDirt || 
 		nullptr == s_pGreetings[0] || nullptr == s_pGreetings[1] || nullptr == s_pGreetings[2] || nullptr == s_pGreetings[3] ||
@@ -307,62 +327,62 @@ bool Demo_Create()
 			return false;
 
 	// nautilus
-	s_pNautilusVignette = Image_Load32("assets/nautilus/Vignette.png");
-	s_pNautilusDirt = Image_Load32("assets/nautilus/GlassDirt_Distorted2.png");
-	s_pNautilusCousteau2 = Image_Load32("assets/nautilus/JacquesCousteau_Silhouette2.png");
-	s_pNautilusCousteau1 = Image_Load32("assets/nautilus/JacquesCousteau1_Silhouette.png");
-	s_pNautilusCousteauRim1 = Image_Load32("assets/nautilus/JacquesCousteau1_Silhouette_RimMask.png");
-	s_pNautilusCousteauRim2 = Image_Load32("assets/nautilus/JacquesCousteau_Silhouette2_RimMask.png");
-	s_pNautilusText = Image_Load32("assets/nautilus/JacquesCousteau_Text.png");
+	s_pNautilusVignette = Image_Load32_Res("assets/nautilus/Vignette.png");
+	s_pNautilusDirt = Image_Load32_Res("assets/nautilus/GlassDirt_Distorted2.png");
+	s_pNautilusCousteau2 = Image_Load32_Res("assets/nautilus/JacquesCousteau_Silhouette2.png");
+	s_pNautilusCousteau1 = Image_Load32_Res("assets/nautilus/JacquesCousteau1_Silhouette.png");
+	s_pNautilusCousteauRim1 = Image_Load32_Res("assets/nautilus/JacquesCousteau1_Silhouette_RimMask.png");
+	s_pNautilusCousteauRim2 = Image_Load32_Res("assets/nautilus/JacquesCousteau_Silhouette2_RimMask.png");
+	s_pNautilusText = Image_Load32_Crop("assets/nautilus/JacquesCousteau_Text.png", s_nautilusTextRect);
 	if (nullptr == s_pNautilusVignette || nullptr == s_pNautilusDirt || nullptr == s_pNautilusText || nullptr == s_pNautilusCousteau1 || nullptr == s_pNautilusCousteau2 || nullptr == s_pNautilusCousteauRim1 || nullptr == s_pNautilusCousteauRim2)
 		return false;
 
 	// load 'disco guys'
-	s_pDiscoGuys[0] = Image_Load32("assets/demo/tpb-06-disco-guy/1.png");
-	s_pDiscoGuys[1] = Image_Load32("assets/demo/tpb-06-disco-guy/1b.png");
-	s_pDiscoGuys[2] = Image_Load32("assets/demo/tpb-06-disco-guy/2.png");
-	s_pDiscoGuys[3] = Image_Load32("assets/demo/tpb-06-disco-guy/2b.png");
-	s_pDiscoGuys[4] = Image_Load32("assets/demo/tpb-06-disco-guy/3.png");
-	s_pDiscoGuys[5] = Image_Load32("assets/demo/tpb-06-disco-guy/3b.png");
-	s_pDiscoGuys[6] = Image_Load32("assets/demo/tpb-06-disco-guy/4.png");
-	s_pDiscoGuys[7] = Image_Load32("assets/demo/tpb-06-disco-guy/4b.png");
+	s_pDiscoGuys[0] = Image_Load32_Res("assets/demo/tpb-06-disco-guy/1.png");
+	s_pDiscoGuys[1] = Image_Load32_Res("assets/demo/tpb-06-disco-guy/1b.png");
+	s_pDiscoGuys[2] = Image_Load32_Res("assets/demo/tpb-06-disco-guy/2.png");
+	s_pDiscoGuys[3] = Image_Load32_Res("assets/demo/tpb-06-disco-guy/2b.png");
+	s_pDiscoGuys[4] = Image_Load32_Res("assets/demo/tpb-06-disco-guy/3.png");
+	s_pDiscoGuys[5] = Image_Load32_Res("assets/demo/tpb-06-disco-guy/3b.png");
+	s_pDiscoGuys[6] = Image_Load32_Res("assets/demo/tpb-06-disco-guy/4.png");
+	s_pDiscoGuys[7] = Image_Load32_Res("assets/demo/tpb-06-disco-guy/4b.png");
 	for (const auto *pointer : s_pDiscoGuys)
 		if (nullptr == pointer)
 			return false;
 
 	// full credits (used to be a melancholic '2001-2023' to signify the end of TPB, hence the variable name)
-//	s_pAreWeDone = Image_Load32("assets/demo/are-we-done-1000x52.png");
-	s_pAreWeDone = Image_Load32("assets/demo/are-we-done-1100x57.png");
+//	s_pAreWeDone = Image_Load32_Res("assets/demo/are-we-done-1000x52.png");
+	s_pAreWeDone = Image_Load32_Res("assets/demo/are-we-done-1100x57.png");
 	if (nullptr == s_pAreWeDone)
 		return false;
 
 	// close-up 'spikey' 
-	s_pCloseSpikeDirtRaker = Image_Load32("assets/closeup/raker-LensDirt5_invert.png");
-	s_pCloseSpikeVignetteForRaker = Image_Load32("assets/closeup/VignetteForRaker.png");
-	s_pCloseSpikeVignette = Image_Load32("assets/closeup/Vignette_CoolFilmLook.png");
-	s_pCloseSpike1961 = Image_Load32("assets/closeup/raker_textSmall.png"); // 624x115
+	s_pCloseSpikeDirtRaker = Image_Load32_Res("assets/closeup/raker-LensDirt5_invert.png");
+	s_pCloseSpikeVignetteForRaker = Image_Load32_Res("assets/closeup/VignetteForRaker.png");
+	s_pCloseSpikeVignette = Image_Load32_Res("assets/closeup/Vignette_CoolFilmLook.png");
+	s_pCloseSpike1961 = Image_Load32_Res("assets/closeup/raker_textSmall.png"); // 624x115
 	if (nullptr == s_pCloseSpikeDirtRaker || nullptr == s_pCloseSpikeVignette || nullptr == s_pCloseSpikeVignetteForRaker || nullptr == s_pCloseSpike1961)
 		return false;
 
 	// under water tunnel
-	s_pWaterDirt = Image_Load32("assets/underwater/LensDirt3_invert.png");
+	s_pWaterDirt = Image_Load32_Res("assets/underwater/LensDirt3_invert.png");
 	if (nullptr == s_pWaterDirt)
 		return false;
 
-	s_pWaterPrismOverlay = Image_Load32("assets/underwater/love prism_alpha 1280_720.png");
+	s_pWaterPrismOverlay = Image_Load32_Res("assets/underwater/love prism_alpha 1280_720.png");
 	if (nullptr == s_pWaterPrismOverlay)
 		return false;
 
 	// shooting star
-	s_pLenz = Image_Load32("assets/shooting/Lenz.png");
+	s_pLenz = Image_Load32_Res("assets/shooting/Lenz.png");
 
 	// ribbons
-	s_pRibbons = Image_Load32("assets/demo/ribbons.png");
+	s_pRibbons = Image_Load32_Res("assets/demo/ribbons.png");
 	if (nullptr == s_pRibbons)
 		return false;
 
 	// making fun of competition machine
-	s_pGPUJoke = Image_Load32("assets/demo/GPU-joke.png");
+	s_pGPUJoke = Image_Load32_Res("assets/demo/GPU-joke.png");
 	if (nullptr == s_pGPUJoke)
 		return false;
 
@@ -373,6 +393,8 @@ void Demo_Destroy()
 {
 	Rocket::Land();
 
+	LayerCache_Destroy();
+
 	Twister_Destroy();
 	Landscape_Destroy();
 	Ball_Destroy();
@@ -383,97 +405,102 @@ void Demo_Destroy()
 static void FadeFlash(uint32_t *pDest, float fadeToBlack, float fadeToWhite)
 {
 	if (fadeToWhite > 0.f)
-		Fade32(pDest, kOutputSize, 0xffffff, uint8_t(fadeToWhite*255.f));
+		Fade32(pDest, g_outputSize, 0xffffff, uint8_t(fadeToWhite*255.f));
 
 	if (fadeToBlack > 0.f)
-		Fade32(pDest, kOutputSize, 0, uint8_t(fadeToBlack*255.f));
+		Fade32(pDest, g_outputSize, 0, uint8_t(fadeToBlack*255.f));
 }
 
-// blend blood logos from zero to full ([0..3]) -- uses g_renderTarget[3]!
-static uint32_t *BloodBlend(float blend, uint32_t *pLogos[4])
+// blend logos (animation) from zero to full ([0..numLogos-1]), returns what to blit; 'key' is extended to identify it
+static const uint32_t *LogoBlend(LayerKey &key, float blend, uint32_t *pLogos[], unsigned numLogos, unsigned resX, unsigned resY)
 {
-	VIZ_ASSERT(nullptr != pLogos);
-
-	uint32_t *pTarget = g_renderTarget[3];
-
-	const float factor = fmodf(blend, 1.f);
-	const uint8_t iFactor = uint8_t(255.f*factor);
+	VIZ_ASSERT(nullptr != pLogos && blend >= 0.f);
 
-	// we're going to do this the stupid way
-	if (blend >= 0.f && blend < 1.f)
+	const unsigned iLogo = std::min(unsigned(blend), numLogos-1);
+	if (numLogos-1 == iLogo)
 	{
-		memcpy(pTarget, pLogos[0], kOutputBytes);
-		Mix32(pTarget, pLogos[1], kOutputSize, iFactor);	
-	}
-	else if (blend >= 1.f && blend < 2.f)
-	{
-		memcpy(pTarget, pLogos[1], kOutputBytes);
-		Mix32(pTarget, pLogos[2], kOutputSize, iFactor);	
-	}
-	else if (blend >= 2.f && blend < 3.f)
-	{
-		memcpy(pTarget, pLogos[2], kOutputBytes);
-		Mix32(pTarget, pLogos[3], kOutputSize, iFactor);	
-	}
-	else if (blend >= 3.f)
-	{
-		return pLogos[3];
+		key.Source(pLogos[iLogo]);
+		return pLogos[iLogo];
 	}
 
-	return pTarget;
+	// all that counts is the 8-bit factor, so there's only so many distinct blends
+	const uint8_t iFactor = uint8_t(255.f*fmodf(blend, 1.f));
+	key.Source(pLogos[iLogo]).Source(pLogos[iLogo+1]).Param(iFactor);
+
+	const unsigned numPixels = resX*resY;
+	return LayerCache_Get(key, resX, resY, [&](uint32_t *pDest) {
+		Mix32(pDest, pLogos[iLogo], pLogos[iLogo+1], numPixels, iFactor);
+	});
 }
 
-// blend credit anim. logos from zero to full ([0..4]) -- uses g_renderTarget[3]!
-// FIXME: collapse with function above, it does exactly the same, except that the resolution is different
-static uint32_t *CreditBlend(float blend, uint32_t *pLogos[5])
+// blur credit logo (s_credX*s_credY) according to sync., returns what to blit
+static const uint32_t *CreditBlur(const LayerKey &key, const uint32_t *pLogo)
 {
-	VIZ_ASSERT(nullptr != pLogos);
+	const uint32_t *pCur = pLogo;
+	LayerKey curKey = key;
 
-	uint32_t *pTarget = g_renderTarget[3];
-
-	const float factor = fmodf(blend, 1.f);
-	const uint8_t iFactor = uint8_t(255.f*factor);
+	const float blurH = BoxBlurScale(Rocket::getf(trackCreditLogoBlurH));
+	if (0.f != blurH)
+	{
+		LayerKey blurKey("credit blur H");
+		blurKey.Source(curKey).Param(BoxBlurSpan(blurH));
 
-	constexpr size_t kCreditImgSize = kCredX*kCredY;
-	constexpr size_t kCreditImgBytes = kCreditImgSize*sizeof(uint32_t);
+		const uint32_t *pSrc = pCur;
+		pCur = LayerCache_Get(blurKey, s_credX, s_credY, [&](uint32_t *pDest) {
+			HorizontalBoxBlur32(pDest, pSrc, s_credX, s_credY, blurH);
+		});
 
-	// we're going to do this the stupid way
-	if (blend >= 0.f && blend < 1.f)
-	{
-		memcpy(pTarget, pLogos[0], kCreditImgBytes);
-		Mix32(pTarget, pLogos[1], kCreditImgSize, iFactor);
-	}
-	else if (blend >= 1.f && blend < 2.f)
-	{
-		memcpy(pTarget, pLogos[1], kCreditImgBytes);
-		Mix32(pTarget, pLogos[2], kCreditImgSize, iFactor);
-	}
-	else if (blend >= 2.f && blend < 3.f)
-	{
-		memcpy(pTarget, pLogos[2], kCreditImgBytes);
-		Mix32(pTarget, pLogos[3], kCreditImgSize, iFactor);
+		curKey = blurKey;
 	}
-	else if (blend >= 3.f && blend < 4.f)
-	{
-		memcpy(pTarget, pLogos[3], kCreditImgBytes);
-		Mix32(pTarget, pLogos[4], kCreditImgSize, iFactor);
-	}
-	else if (blend >= 4.f)
+
+	const float blurV = BoxBlurScale(Rocket::getf(trackCreditLogoBlurV));
+	if (0.f != blurV)
 	{
-		return pLogos[4];
+		LayerKey blurKey("credit blur V");
+		blurKey.Source(curKey).Param(BoxBlurSpan(blurV));
+
+		// after a horizontal blur this used to be done in place, which looks a little different, and that's the look
+		const uint32_t *pSrc = pCur;
+		const bool inPlace = 0.f != blurH;
+		pCur = LayerCache_Get(blurKey, s_credX, s_credY, [&](uint32_t *pDest) {
+			if (true == inPlace)
+			{
+				memcpy(pDest, pSrc, s_credX*s_credY*sizeof(uint32_t));
+				VerticalBoxBlur32(pDest, pDest, s_credX, s_credY, blurV);
+			}
+			else
+				VerticalBoxBlur32(pDest, pSrc, s_credX, s_credY, blurV);
+		});
 	}
 
-	return pTarget;
+	return pCur;
 }
 
 bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 {
+	TargetPool_NewFrame();
+	LayerCache_NewFrame();
+
 	// update sync.
 #if defined(SYNC_PLAYER)
 	if (false == Rocket::Boost())
 		return false; // demo is over!
 #else
 	Rocket::Boost();
+
+	if (true == Rocket::KeysEdited())
+		FrameCache_Invalidate();
+
+	// scrubbing (paused): serve from cache if possible
+	const bool scrubbing = BASS_ACTIVE_PLAYING != Audio_Rocket_IsPlaying(nullptr);
+	const DemoState state = Demo_GetState();
+	const uint64_t fxLevels = FxGovernor_GetLevels();
+
+	FrameCache_ShowStats();
+	LayerCache_ShowStats();
+
+	if (true == scrubbing && true == FrameCache_Fetch(pDest, state, fxLevels))
+		return true;
 #endif
 
 #if 0
@@ -483,7 +510,7 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 
 	// (WIP) new blur test
 
-	memset32(pDest, 0, kResX*kResY);
+	memset32(pDest, 0, g_resX*g_resY);
 
 	const float strength = 6.28f;
 
@@ -510,14 +537,14 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 		case 1:
 			// Quick intermezzo: voxel torus
 			Twister_Draw(pDest, timer, delta);
-//			SoftLight32(pDest, s_pBallVignette, kOutputSize);
+//			SoftLight32(pDest, s_pBallVignette, g_outputSize);
 			FadeFlash(pDest, fadeToBlack, fadeToWhite);
 
 			// FIXME: placeholder
-			SoftLight32A(pDest, s_pCloseSpikeVignette, kOutputSize);
+			SoftLight32A(pDest, s_pCloseSpikeVignette, g_outputSize);
 
 			// curious but might be grunge enough for this part
-			MulSrc32A(pDest, s_pVignette06, kOutputSize);
+			MulSrc32A(pDest, s_pVignette06, g_outputSize);
 			break;
 	
 		case 2:
@@ -530,21 +557,20 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 
 				// shooting star (or what has to pass for it)
 				// this is the charm of a hack made possible by Rocket
-				// FIXME: really shouldn't be using threaded blit function(s) here
 				if (1 == Rocket::geti(trackShooting))
 				{
-					int xPos = Rocket::geti(trackShootingX);
-					int yPos = Rocket::geti(trackShootingY);
+					float xPos = float(ToRes(Rocket::geti(trackShootingX)));
+					float yPos = float(ToRes(Rocket::geti(trackShootingY)));
 					float alpha = Rocket::getf(trackShootingAlpha);
 
-					const unsigned offset = yPos*kResX + xPos;
-					BlitAdd32A(pDest + offset, s_pLenz, kResX, kLenzSize, kLenzSize, alpha);
+					const unsigned lenzSize = unsigned(ToRes(kLenzSize));
+					s_sprites.Add({ .pImage = s_pLenz, .resX = lenzSize, .resY = lenzSize, .x = xPos, .y = yPos, .alpha = alpha });
 
 					int trail = Rocket::geti(trackShootingTrail);
 					if (trail > 0)
 					{
-						const int xStep = kLenzSize/16;
-						const int yStep = 1;
+						const float xStep = float(kLenzSize/16)*g_resScale;
+						const float yStep = g_resScale;
 						const float alphaStep = alpha/trail;
 
 						for (int iTrail = 0; iTrail < trail; ++iTrail)
@@ -553,16 +579,17 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 							yPos -= yStep; // ... and from top to bottom
 							alpha -= alphaStep;
 
-							const unsigned offset = yPos*kResX + xPos;
-							BlitAdd32A(pDest + offset, s_pLenz, kResX, kLenzSize, kLenzSize, alpha);
+							s_sprites.Add({ .pImage = s_pLenz, .resX = lenzSize, .resY = lenzSize, .x = xPos, .y = yPos, .alpha = alpha });
 						}
 					}
+
+					s_sprites.Draw(pDest, g_resX, g_resY);
 				}
 
 				// add overlay
 				const float overlayAlpha = saturatef(Rocket::getf(trackScapeOverlay));
 				if (0.f != overlayAlpha)
-					BlitAdd32A(pDest, s_pGodLayer, kResX, kResX, kResY, overlayAlpha);
+					BlitAdd32A(pDest, s_pGodLayer, g_resX, g_resX, g_resY, overlayAlpha);
 
 				// add Revision logo
 				const float alphaRev = saturatef(Rocket::getf(trackScapeRevision));
@@ -572,20 +599,20 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 					{
 						const float easeA = easeOutElasticf(alphaRev)*kGoldenAngle;
 						const float easeB = easeInBackf(alphaRev)*kGoldenRatio;
-						TapeWarp32(g_renderTarget[0], s_pRevLogo, kResX, kResY, easeA, easeB);
-						BlitSrc32A(pDest, g_renderTarget[0], kResX, kResX, kResY, alphaRev);
+						TapeWarp32(g_renderTarget[0], s_pRevLogo, g_resX, g_resY, easeA, easeB);
+						BlitSrc32A(pDest, g_renderTarget[0], g_resX, g_resX, g_resY, alphaRev);
 					}
 					else
 					{
-						BoxBlur32(g_renderTarget[0], s_pRevLogo, kResX, kResY, BoxBlurScale(((alphaRev-0.314f)*k2PI)));
-						BlitSrc32A(pDest, g_renderTarget[0], kResX, kResX, kResY, alphaRev);
+						BoxBlur32(g_renderTarget[0], s_pRevLogo, g_resX, g_resY, BoxBlurScale(((alphaRev-0.314f)*k2PI)));
+						BlitSrc32A(pDest, g_renderTarget[0], g_resX, g_resX, g_resY, alphaRev);
 					}
 				}
 
 				FadeFlash(pDest, fadeToBlack, fadeToWhite);
 
 				// FIXME: placeholder
-				SoftLight32A(pDest, s_pCloseSpikeVignette, kOutputSize);
+				SoftLight32A(pDest, s_pCloseSpikeVignette, g_outputSize);
 			}
 			break;
 
@@ -595,15 +622,15 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 				Ball_Draw(pDest, timer, delta);
 
 				if (false == Ball_HasBeams())
-					MulSrc32(pDest, s_pGreetingsVignette, kOutputSize); // FIXME: borrowed/placeholder
+					MulSrc32(pDest, s_pGreetingsVignette, g_outputSize); // FIXME: borrowed/placeholder
 				else
-					SoftLight32(pDest, s_pBallVignette, kOutputSize);
+					SoftLight32(pDest, s_pBallVignette, g_outputSize);
 
 				FadeFlash(pDest, fadeToBlack, fadeToWhite);
 
 				// I'm unsure how this looks (might need tweaking), but let's just try it on the beams version to "grime" it up a little
 				if (true == Ball_HasBeams())				
-					MulSrc32A(pDest, s_pVignette06, kOutputSize);
+					MulSrc32A(pDest, s_pVignette06, g_outputSize);
 			}
 			break;
 
@@ -612,27 +639,30 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 			{
 				Tunnelscape_Draw(pDest, timer, delta);
 
-				Sub32(pDest, s_pTunnelVignette2, kOutputSize);
+				Sub32(pDest, s_pTunnelVignette2, g_outputSize);
 
-				MixSrc32(pDest, s_pTunnelFullDirt, kOutputSize);
+				MixSrc32(pDest, s_pTunnelFullDirt, g_outputSize);
 
 				// FIXME: belongs to the old lens dirt overlay; remove, or?
 //				const float dirt = Rocket::getf(trackDirt);
 //				if (0.f == dirt)
 //				{
-//					Excl32(pDest, s_pTunnelFullDirt, kOutputSize);
+//					Excl32(pDest, s_pTunnelFullDirt, g_outputSize);
 //				}
 //				else
 //				{
-//					BoxBlur32(g_renderTarget[0], s_pTunnelFullDirt, kResX, kResY, BoxBlurScale(dirt));
-//					Excl32(pDest, g_renderTarget[0], kOutputSize);
+//					BoxBlur32(g_renderTarget[0], s_pTunnelFullDirt, g_resX, g_resY, BoxBlurScale(dirt));
+//					Excl32(pDest, g_renderTarget[0], g_outputSize);
 //				}
 
 				const float show1995 = clampf(0.f, 3.f, Rocket::getf(trackShow1995));
 				if (show1995 > 0.f)
-					MixOver32(pDest, BloodBlend(show1995, s_pNoooN), kOutputSize);
+				{
+					LayerKey key("blood blend");
+					MixOver32(pDest, LogoBlend(key, show1995, s_pNoooN, 4, g_resX, g_resY), g_outputSize);
+				}
 
-				Overlay32(pDest, s_pTunnelVignette, kOutputSize);
+				Overlay32(pDest, s_pTunnelVignette, g_outputSize);
 			}
 			break;
 		
@@ -672,44 +702,20 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 						}
 
 						// credit logo blit (animated)
-						uint32_t *pCur = CreditBlend(logoBlend, pLogos);
+						LayerKey key("credit blend");
+						const uint32_t *pBlend = LogoBlend(key, logoBlend, pLogos, 5, s_credX, s_credY);
+						const uint32_t *pCur = CreditBlur(key, pBlend);
 
-						const float blurH = Rocket::getf(trackCreditLogoBlurH);
-						if (0.f != blurH)
-						{
-							HorizontalBoxBlur32(g_renderTarget[0], pCur, kCredX, kCredY, BoxBlurScale(blurH));
-							pCur = g_renderTarget[0];
-						}
-
-						const float blurV = Rocket::getf(trackCreditLogoBlurV);
-						if (0 != blurV)
-						{
-							VerticalBoxBlur32(g_renderTarget[0], pCur, kCredX, kCredY, BoxBlurScale(blurV));
-							pCur = g_renderTarget[0];
-						}
-
-						BlitSrc32A(pDest + ((kResY-kCredY)>>1)*kResX, pCur, kResX, kCredX, kCredY, clampf(0.f, 1.f, Rocket::getf(trackCreditLogoAlpha)));
+						BlitSrc32A(pDest + ((g_resY-s_credY)>>1)*g_resX, pCur, g_resX, s_credX, s_credY, clampf(0.f, 1.f, Rocket::getf(trackCreditLogoAlpha)));
 					}
 					else
 					{
 						// credit logo blit (rest)
-						uint32_t *pCur = s_pCredits[iLogo-1];
-
-						const float blurH = Rocket::getf(trackCreditLogoBlurH);
-						if (0.f != blurH)
-						{
-							HorizontalBoxBlur32(g_renderTarget[0], pCur, kCredX, kCredY, BoxBlurScale(blurH));
-							pCur = g_renderTarget[0];
-						}
+						LayerKey key("credit");
+						key.Source(s_pCredits[iLogo-1]);
+						const uint32_t *pCur = CreditBlur(key, s_pCredits[iLogo-1]);
 
-						const float blurV = Rocket::getf(trackCreditLogoBlurV);
-						if (0 != blurV)
-						{
-							VerticalBoxBlur32(g_renderTarget[0], pCur, kCredX, kCredY, BoxBlurScale(blurV));
-							pCur = g_renderTarget[0];
-						}
-
-						BlitSrc32A(pDest + ((kResY-kCredY)>>1)*kResX, pCur, kResX, kCredX, kCredY, clampf(0.f, 1.f, Rocket::getf(trackCreditLogoAlpha)));
+						BlitSrc32A(pDest + ((g_resY-s_credY)>>1)*g_resX, pCur, g_resX, s_credX, s_credY, clampf(0.f, 1.f, Rocket::getf(trackCreditLogoAlpha)));
 					}
 				}
 			}
@@ -719,8 +725,8 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 			// Nautilus (Michiel, RIP)
 			{
 				Nautilus_Draw(pDest, timer, delta);
-				SoftLight32(pDest, s_pNautilusVignette, kOutputSize);
-				SoftLight32(pDest, s_pNautilusDirt, kOutputSize);
+				SoftLight32(pDest, s_pNautilusVignette, g_outputSize);
+				SoftLight32(pDest, s_pNautilusDirt, g_outputSize);
 				FadeFlash(pDest, fadeToBlack, 0.f);
 
 				// just so we can add a little shakin'
@@ -738,22 +744,22 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 				}
 
 				// add rim overlay
-				Overlay32A(pDest, pCousteauRim, kOutputSize);
+				Overlay32A(pDest, pCousteauRim, g_outputSize);
 
 				float hBlur = Rocket::getf(trackCousteauHorzBlur);
 				if (0.f != hBlur)
 				{
 					hBlur = BoxBlurScale(hBlur);
-					HorizontalBoxBlur32(g_renderTarget[0], pCousteau, kResX, kResY, hBlur);
+					HorizontalBoxBlur32(g_renderTarget[0], pCousteau, g_resX, g_resY, hBlur);
 					pCousteau = g_renderTarget[0];
 				}
 
 				// and now Jacques himself!
-				MixSrc32(pDest, pCousteau, kOutputSize);
+				MixSrc32(pDest, pCousteau, g_outputSize);
 
 				FadeFlash(pDest, 0.f, fadeToWhite);
 
-				MixSrc32(pDest, s_pNautilusText, kOutputSize);
+				MixSrc32R(pDest, s_pNautilusText, s_nautilusTextRect, g_resX, s_nautilusTextRect.resX);
 			}
 			break;
       
@@ -766,51 +772,55 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 				const auto dirt = Rocket::geti(trackDirt);
 
 				if (1 != dirt)
-					MulSrc32(pDest, s_pSpikeyVignette, kOutputSize);
+					MulSrc32(pDest, s_pSpikeyVignette, g_outputSize);
 
 				if (1 == dirt)
 				{
 					// Moonraker
 					const float raker = Rocket::getf(trackCloseUpMoonraker);
 					const float rakerText = clampf(0.f, 2.f, Rocket::getf(trackCloseUpMoonrakerText));
+					const unsigned textResX = unsigned(ToRes(624)), textResY = unsigned(ToRes(115));
 					
 					if (raker > 0.f)
 					{
-						MulSrc32(pDest, s_pCloseSpikeVignetteForRaker, kOutputSize);
-						SoftLight32AA(pDest, s_pCloseSpikeDirtRaker, kOutputSize, raker);
+						MulSrc32(pDest, s_pCloseSpikeVignetteForRaker, g_outputSize);
+						SoftLight32AA(pDest, s_pCloseSpikeDirtRaker, g_outputSize, raker);
 						
 						if (rakerText > 0.f && rakerText < 1.f)
 						{						
 							// this is shit slow, but it'll only last a short while (FIXME: optimize for major release)
-							memset32(g_renderTarget[2], 0, kOutputSize);
-							BlitSrc32(g_renderTarget[2] + ((kResY-115)*kResX), s_pCloseSpike1961, kResX, 624, 115);
-							SoftLight32AA(pDest, g_renderTarget[2], kOutputSize, rakerText); // <- this would be the function to make work on arbitrarily sized bitmaps
+							ScratchTarget textTarget(g_resX, g_resY, "raker text");
+							memset32(textTarget, 0, g_outputSize);
+							BlitSrc32(textTarget + ((g_resY-textResY)*g_resX), s_pCloseSpike1961, g_resX, textResX, textResY);
+							SoftLight32AA(pDest, textTarget, g_outputSize, rakerText); // <- this would be the function to make work on arbitrarily sized bitmaps
 						}
 						else if (rakerText >= 1.f)
 						{
 							// just (possibly) blur and blit
 
 							const uint32_t *pText = s_pCloseSpike1961;
+							ScratchTarget blurTarget(textResX, textResY, "raker text blur");
+
 							const float rakerBlur = clampf(0.f, 100.f, Rocket::getf(trackCloseUpMoonrakerTextBlur));
 							if (rakerBlur >= 1.f)
 							{
-								HorizontalBoxBlur32(g_renderTarget[3] /* just assuming this one is free */, pText, 624, 115, BoxBlurScale(rakerBlur));
-								pText = g_renderTarget[3];
+								HorizontalBoxBlur32(blurTarget, pText, textResX, textResY, BoxBlurScale(rakerBlur));
+								pText = blurTarget;
 							}
 
-							BlitSrc32(pDest + ((kResY-115)*kResX), pText, kResX, 624, 115);
+							BlitSrc32(pDest + ((g_resY-textResY)*g_resX), pText, g_resX, textResX, textResY);
 						}
 						
 
 						FadeFlash(pDest, 0.f, fadeToWhite);
-						Overlay32(pDest, s_pCloseSpikeDirtRaker, kOutputSize);
+						Overlay32(pDest, s_pCloseSpikeDirtRaker, g_outputSize);
 						FadeFlash(pDest, fadeToBlack, 0.f);
 					}
 				}
 				else if (2 == dirt)
-					SoftLight32AA(pDest, s_pGreetingsDirt, kOutputSize, 0.09f*kGoldenAngle); // FIXME: borrowed asset
+					SoftLight32AA(pDest, s_pGreetingsDirt, g_outputSize, 0.09f*kGoldenAngle); // FIXME: borrowed asset
 				else if (3 == dirt)
-					SoftLight32AA(pDest, s_pGreetingsDirt, kOutputSize, 0.075f*kGoldenAngle); // FIXME: borrowed asset
+					SoftLight32AA(pDest, s_pGreetingsDirt, g_outputSize, 0.075f*kGoldenAngle); // FIXME: borrowed asset
 
 				if (1 != dirt)
 					FadeFlash(pDest, fadeToBlack, fadeToWhite);
@@ -824,15 +834,15 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 				// Spike ball with title and group name (Bypass)
 				Spikey_Draw(pDest, timer, delta, false);
 				FadeFlash(pDest, fadeToBlack, fadeToWhite);
-				SoftLight32(pDest, s_pSpikeyBypass, kOutputSize);
-				Sub32(pDest, s_pSpikeyVignette2, kOutputSize);
-				Excl32(pDest, s_pSpikeyFullDirt, kOutputSize);
-				MulSrc32A(pDest, s_pVignette06, kOutputSize);
+				SoftLight32(pDest, s_pSpikeyBypass, g_outputSize);
+				Sub32(pDest, s_pSpikeyVignette2, g_outputSize);
+				Excl32(pDest, s_pSpikeyFullDirt, g_outputSize);
+				MulSrc32A(pDest, s_pVignette06, g_outputSize);
 
 				if (0 != logoIdx)
-					MixOver32(pDest, s_pSpikeyArrested[logoIdx-1], kOutputSize);
+					MixOver32(pDest, s_pSpikeyArrested[logoIdx-1], g_outputSize);
 				
-				Overlay32(pDest, s_pSpikeyVignette, kOutputSize);
+				Overlay32(pDest, s_pSpikeyVignette, g_outputSize);
 			}
 			break;
 
@@ -840,11 +850,14 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 			// Part of the 'tunnels' part
 			{
 				Tunnel_Draw(pDest, timer, delta);
-				Sub32(pDest, s_pTunnelVignette2, kOutputSize);
+				Sub32(pDest, s_pTunnelVignette2, g_outputSize);
 
 				const float show2006 = clampf(0.f, 3.f, Rocket::getf(trackShow2006));
 				if (show2006 > 0.f)
-					MixOver32(pDest, BloodBlend(show2006, s_pMFX), kOutputSize);
+				{
+					LayerKey key("blood blend");
+					MixOver32(pDest, LogoBlend(key, show2006, s_pMFX, 4, g_resX, g_resY), g_outputSize);
+				}
 			}
 			break;
 
@@ -858,14 +871,14 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 				const float waterOverlayBlurHorz = clampf(0.f, 100.f, Rocket::getf(trackLoveBlurHorz));
 				if (0.f != waterOverlayBlurHorz)
 				{
-					HorizontalBoxBlur32(g_renderTarget[0], pWaterOverlay, kResX, kResY, BoxBlurScale(waterOverlayBlurHorz));
+					HorizontalBoxBlur32(g_renderTarget[0], pWaterOverlay, g_resX, g_resY, BoxBlurScale(waterOverlayBlurHorz));
 					pWaterOverlay = g_renderTarget[0];
 				}
 
-				BlitAdd32A(pDest, pWaterOverlay, kResX, kResX, kResY, overlayA);
+				BlitAdd32A(pDest, pWaterOverlay, g_resX, g_resX, g_resY, overlayA);
 
 				if (0 != Rocket::geti(trackDirt))
-					MulSrc32(pDest, s_pWaterDirt, kOutputSize);
+					MulSrc32(pDest, s_pWaterDirt, g_outputSize);
 
 				FadeFlash(pDest, fadeToBlack, fadeToWhite);
 			}
@@ -878,14 +891,15 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 
 				const int greetSwitch = Rocket::geti(trackGreetSwitch);
 
-				Darken32_50(pDest, s_pGreetings[greetSwitch], kOutputSize);
-				SoftLight32(pDest, s_pGreetingsDirt, kOutputSize);
+				Darken32_50(pDest, s_pGreetings[greetSwitch], g_outputSize);
+				SoftLight32(pDest, s_pGreetingsDirt, g_outputSize);
 
-				const auto yOffs = ((kResY-243)/2) + 227;
-				const auto xOffs = 24; // ((kResX-263)/2) - 300;
-				BlitSrc32(pDest + xOffs + yOffs*kResX, g_pXboxLogoTPB, kResX, 263, 243);
+				const unsigned logoResX = unsigned(ToRes(263)), logoResY = unsigned(ToRes(243));
+				const auto yOffs = ((g_resY-logoResY)/2) + ToRes(227);
+				const auto xOffs = ToRes(24); // ((g_resX-263)/2) - 300;
+				BlitSrc32(pDest + xOffs + yOffs*g_resX, g_pXboxLogoTPB, g_resX, logoResX, logoResY);
 
-				Overlay32(pDest, s_pGreetingsVignette, kOutputSize);
+				Overlay32(pDest, s_pGreetingsVignette, g_outputSize);
 			}
 			break;
 
@@ -898,102 +912,116 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 
 				if (false == warpAll)
 				{
-					// clear 2 targets, so we can composite them and only warp one
-					memset32(g_renderTarget[0], 0xffffff, kOutputSize);
-					memset32(pDest, 0xffffff, kOutputSize);
+					// clear target, so we can composite 2 layers and only warp one
+					memset32(pDest, 0xffffff, g_outputSize);
 
 					// ribbon to layer 
-					const auto ribX = clampi(0, kResX, Rocket::geti(trackRibbonsTPB));
-					MixSrc32S(pDest, s_pRibbons + ribX, kResX, kResY-1, 2160); // FIXME
+					const auto ribX = ToRes(clampi(0, int(kAuthorResX), Rocket::geti(trackRibbonsTPB)));
+					MixSrc32S(pDest, s_pRibbons + ribX, g_resX, g_resY-1, ToRes(2160)); // FIXME
 
-	//				BlitSrc32(g_renderTarget[0] + ((kResX-800)/2) + ((kResY-600)/2)*kResX, g_pNytrikMexico, kResX, 800, 600);
-	//				memcpy(g_renderTarget[0], g_pNytrikTPB, kOutputBytes);
+	//				BlitSrc32(g_renderTarget[0] + ((g_resX-800)/2) + ((g_resY-600)/2)*g_resX, g_pNytrikMexico, g_resX, 800, 600);
+	//				memcpy(g_renderTarget[0], g_pNytrikTPB, g_outputBytes);
 
-					// logo to layer
-					MixSrc32(g_renderTarget[0], g_pNytrikTPB, kOutputSize);
+					// logo to (cleared) layer
+					MixSrc32R(g_renderTarget[0], 0xffffff, g_pNytrikTPB, g_nytrikTPBRect, g_resX, g_resY, g_nytrikTPBRect.resX);
 
 					// blur logo
 					float blurTPB = Rocket::getf(trackBlurTPB);
 					if (0.f != blurTPB)
 					{
 						blurTPB = BoxBlurScale(blurTPB);
-						HorizontalBoxBlur32(g_renderTarget[0], g_renderTarget[0], kResX, kResY, blurTPB);
+						HorizontalBoxBlur32(g_renderTarget[0], g_renderTarget[0], g_resX, g_resY, blurTPB);
 					}
 
 					// distort logo
 					const float distortTPB = Rocket::getf(trackDistortTPB);
 					const float distortStrengthTPB = Rocket::getf(trackDistortStrengthTPB);
-					TapeWarp32(g_renderTarget[1], g_renderTarget[0], kResX, kResY, distortStrengthTPB, distortTPB);
+					ScratchTarget warpTarget(g_resX, g_resY, "TPB warp");
+					TapeWarp32(warpTarget, g_renderTarget[0], g_resX, g_resY, distortStrengthTPB, distortTPB);
 
 					// add logo on top of layer
-					MixOver32(pDest, g_renderTarget[1], kOutputSize);
+					MixOver32(pDest, warpTarget, g_outputSize);
 				}
 				else
 				{
 					// some subtle re-use of the plasma marching effect
 					Plasma_Draw(pDest, timer, delta);
 
-					// logo to layer (FIXME: blit instead?)
-					memset32(g_renderTarget[0], 0xffffff, kOutputSize);
-					MixSrc32(g_renderTarget[0], g_pNytrikTPB, kOutputSize);
+					// logo to (cleared) layer
+					MixSrc32R(g_renderTarget[0], 0xffffff, g_pNytrikTPB, g_nytrikTPBRect, g_resX, g_resY, g_nytrikTPBRect.resX);
 
 					// blur logo (V)
 					float blurTPB = Rocket::getf(trackBlurTPB);
 					if (0.f != blurTPB)
 					{
 						blurTPB = BoxBlurScale(blurTPB);
-						VerticalBoxBlur32(g_renderTarget[0], g_renderTarget[0], kResX, kResY, blurTPB);
+						VerticalBoxBlur32(g_renderTarget[0], g_renderTarget[0], g_resX, g_resY, blurTPB);
 					}
 
 					// distort logo
 					const float distortTPB = Rocket::getf(trackDistortTPB);
 					const float distortStrengthTPB = Rocket::getf(trackDistortStrengthTPB);
-					TapeWarp32(g_renderTarget[1], g_renderTarget[0], kResX, kResY, distortStrengthTPB, distortTPB);
+					ScratchTarget warpTarget(g_resX, g_resY, "TPB warp");
+					TapeWarp32(warpTarget, g_renderTarget[0], g_resX, g_resY, distortStrengthTPB, distortTPB);
 
 					// add logo on top of layer
-					MixOver32(pDest, g_renderTarget[1], kOutputSize);
+					MixOver32(pDest, warpTarget, g_outputSize);
 				}
 
 				// vignette
-				MulSrc32(pDest, s_pNautilusVignette, kOutputSize); // FIXME: placeholder
+				MulSrc32(pDest, s_pNautilusVignette, g_outputSize); // FIXME: placeholder
 
 			}
 			break;
 
 		case 13:
 			{
-				memset32(pDest, 0, kResX*kResY);
+				memset32(pDest, 0, g_resX*g_resY);
 
 				const float discoGuys = saturatef(Rocket::getf(trackDiscoGuys));
 				const float joke = saturatef(Rocket::getf(trackCheapJoke));
 
 				if (discoGuys > 0.f)
 				{
-					const unsigned xStart = (kResX-(8*128))>>1;
-					const unsigned yOffs = ((kResY-128)>>1) + 16;
+					const unsigned guySize = unsigned(ToRes(128));
+					const unsigned xStart = unsigned(g_resX-(8*guySize))>>1;
+					const unsigned yOffs = unsigned((g_resY-guySize)>>1) + ToRes(16);
 					for (int iGuy = 0; iGuy < 8; ++iGuy)
 					{
 						// this gives me the opportunity to for ex. fade them in in order
 						const float appearance = saturatef(Rocket::getf(trackDiscoGuysAppearance[iGuy]));
 
-						BlitSrc32A(pDest + xStart + iGuy*128 + yOffs*kResX, s_pDiscoGuys[iGuy], kResX, 128, 128, discoGuys*smootherstepf(0.f, 1.f, appearance));
+						s_sprites.Add({
+							.pImage = s_pDiscoGuys[iGuy], .resX = guySize, .resY = guySize,
+							.x = float(xStart + iGuy*guySize), .y = float(yOffs),
+							.alpha = discoGuys*smootherstepf(0.f, 1.f, appearance), .blend = SpriteBlend::kSrc });
 
 						if (discoGuys < 1.f)
 						{
-							uint32_t *pStrip = pDest + yOffs*kResX;
-							HorizontalBoxBlur32(pStrip, pStrip, kResX, 128, BoxBlurScale((1.f-discoGuys)*k2PI*kGoldenAngle));
+							s_sprites.Draw(pDest, g_resX, g_resY);
+
+							// the strip is black up to the guys drawn so far (minus what previous passes spread out to the left),
+							// so starting the blur there instead of at the left edge of the screen yields the exact same result
+							const float blurStrength = BoxBlurScale((1.f-discoGuys)*k2PI*kGoldenAngle);
+							const unsigned margin = (iGuy+2)*BoxBlurSpan(blurStrength);
+							const unsigned left = xStart > margin ? xStart-margin : 0;
+							const Rect stripRect = { left, yOffs, unsigned(g_resX)-left, guySize };
+							HorizontalBoxBlur32R(pDest, pDest, stripRect, g_resX, blurStrength);
 						}
 					}
 
 					// (semi-)full credits
-//					BlitAdd32A(pDest + (((kResX-1000)/2)-1) + (yOffs+130)*kResX, s_pAreWeDone, kResX, 1000, 52, discoGuys);
-					BlitAdd32A(pDest + (((kResX-1100)/2)-1) + (yOffs+130)*kResX, s_pAreWeDone, kResX, 1100, 57, discoGuys);
+//					BlitAdd32A(pDest + (((g_resX-1000)/2)-1) + (yOffs+130)*g_resX, s_pAreWeDone, g_resX, 1000, 52, discoGuys);
+					const unsigned doneResX = unsigned(ToRes(1100)), doneResY = unsigned(ToRes(57));
+					s_sprites.Add({ .pImage = s_pAreWeDone, .resX = doneResX, .resY = doneResY, .x = float(((g_resX-doneResX)/2)-1), .y = float(yOffs+ToRes(130)), .alpha = discoGuys });
+					s_sprites.Draw(pDest, g_resX, g_resY);
 				}
 				else if (joke > 0.f)
 				{
 					// they can't 'ford no GPU
-					memset(pDest, 0, kOutputBytes);
-					BlitSrc32A(pDest + ((kResX-960)/2) + (((kResY-160 )/2)*kResX), s_pGPUJoke, kResX, 960, 160, joke);
+					memset(pDest, 0, g_outputBytes);
+					const unsigned jokeResX = unsigned(ToRes(960)), jokeResY = unsigned(ToRes(160));
+					BlitSrc32A(pDest + ((g_resX-jokeResX)/2) + (((g_resY-jokeResY)/2)*g_resX), s_pGPUJoke, g_resX, jokeResX, jokeResY, joke);
 				}
 			}
 			break;
@@ -1019,5 +1047,22 @@ bool Demo_Draw(uint32_t *pDest, float timer, float delta)
 		FadeFlash(pDest, fadeToBlack, fadeToWhite);
 	}
 
+#if !defined(SYNC_PLAYER)
+	if (true == scrubbing)
+		FrameCache_Store(pDest, state, fxLevels);
+#endif
+
 	return true;
 }
+
+DemoState Demo_GetState()
+{
+	DemoState state;
+	state.voxelScape = Landscape_GetState();
+	return state;
+}
+
+void Demo_SetState(const DemoState &state)
+{
+	Landscape_SetState(state.voxelScape);
+}
@@ -5,9 +5,20 @@
 #define _DEMO_H_
 
 #include "../3rdparty/rocket-stripped/lib/sync.h"
+#include "landscape.h"
 
 bool Demo_Create();
 void Demo_Destroy();
 bool Demo_Draw(uint32_t *pDest, float time, float delta);
 
+// everything parts carry over from one frame to the next (the rest is a function of time & sync.)
+// - snapshot it along with a frame, restore it to render (or re-render) frames out of order
+struct DemoState
+{
+	VoxelScapeState voxelScape;
+};
+
+DemoState Demo_GetState();
+void Demo_SetState(const DemoState &state);
+
 #endif // _DEMO_H_
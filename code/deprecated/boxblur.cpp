@@ -6,7 +6,7 @@
 // - it has a cache-unfriendly naive vertical pass (though it's potentially not that bad for relatively small images)
 
 #include "../main.h"
-// #include "boxblur.h"
+#include "boxblur.h"
 
 VIZ_INLINE uint32_t WeightToDiv(unsigned int weight)
 {
@@ -41,19 +41,19 @@ VIZ_INLINE uint32_t Div(__m128i accumulator, __m128i weightDiv)
 	return _mm_cvtsi128_si32(_mm_packus_epi16(_mm_mulhi_epu16(accumulator, weightDiv), _mm_setzero_si128()));
 }
 
-void HorizontalBoxBlur32(
+// 'stride' allows blurring a region of interest within a larger buffer (see ...R() functions below)
+static void HorizontalBoxBlur32_Stride(
 	uint32_t *pDest,
 	const uint32_t *pSrc,
 	unsigned int xRes,
 	unsigned int yRes,
+	unsigned int stride,
 	float strength)
 {
 //	VIZ_ASSERT(pDest != pSrc);
 
 	// calculate actual kernel span
-	const float fKernelSpan = strength*255.f;
-	unsigned kernelSpan = unsigned(fKernelSpan);
-	kernelSpan = clampi(1, 255, kernelSpan);
+	const unsigned kernelSpan = BoxBlurSpan(strength);
 
 	// derive edge details (even-sized kernels have subpixel edges)
 	const bool subEdges = (kernelSpan & 1) == 0;
@@ -62,7 +62,7 @@ void HorizontalBoxBlur32(
 	const unsigned int kernelMedian = edgeSpan + !subEdges;
 
 	// calculate divisors for edge passes
-	static __m128i edgeDivs[256];
+	__m128i edgeDivs[256]; // not static: blurs may run concurrently (see task-graph.h)
 	VIZ_ASSERT(kernelMedian < 256);
 	const unsigned int startWeight = (kernelMedian << 4) + (subEdges<<3); // FIXME: 0.5 weight bias during pre-pass
 	for (unsigned int curWeight = startWeight, iDiv = 0; iDiv < kernelMedian; ++iDiv)
@@ -72,6 +72,7 @@ void HorizontalBoxBlur32(
 	}
 
 	// full pass length & divisor
+	VIZ_ASSERT(xRes >= kernelMedian+edgeSpan);
 	const unsigned int fullPassLen = xRes - (kernelMedian+edgeSpan);
 	const __m128i fullDiv = _mm_set1_epi16(WeightToDiv(kernelSpan << 4));
 
@@ -81,7 +82,7 @@ void HorizontalBoxBlur32(
 	#pragma omp parallel for schedule(static) if (parallelize)
 	for (int iY = 0; iY < int(yRes); ++iY)
 	{
-		auto destIndex = iY*xRes;
+		auto destIndex = iY*stride;
 		const uint32_t *pSrcLine = pSrc + destIndex;
 
 		unsigned int addPos = 0;
@@ -125,19 +126,18 @@ void HorizontalBoxBlur32(
 	}
 }
 
-void VerticalBoxBlur32(
+static void VerticalBoxBlur32_Stride(
 	uint32_t *pDest,
 	const uint32_t *pSrc,
 	unsigned int xRes,
 	unsigned int yRes,
+	unsigned int stride,
 	float strength)
 {
 //	VIZ_ASSERT(pDest != pSrc);
 
 	// calculate actual kernel span
-	const float fKernelSpan = strength*255.f;
-	unsigned kernelSpan = unsigned(fKernelSpan);
-	kernelSpan = clampi(1, 255, kernelSpan);
+	const unsigned kernelSpan = BoxBlurSpan(strength);
 
 	// derive edge details (even-sized kernels have subpixel edges)
 	const bool subEdges = (kernelSpan & 1) == 0;
@@ -146,7 +146,7 @@ void VerticalBoxBlur32(
 	const unsigned int kernelMedian = edgeSpan + !subEdges;
 
 	// calculate divisors for edge passes
-	static __m128i edgeDivs[256];
+	__m128i edgeDivs[256]; // not static: blurs may run concurrently (see task-graph.h)
 	VIZ_ASSERT(kernelMedian < 256);
 	const unsigned int startWeight = (kernelMedian << 4) + (subEdges << 3);
 	for (unsigned int curWeight = startWeight, iDiv = 0; iDiv < kernelMedian; ++iDiv)
@@ -156,6 +156,7 @@ void VerticalBoxBlur32(
 	}
 
 	// full pass length & divisor
+	VIZ_ASSERT(yRes >= kernelMedian+edgeSpan);
 	const unsigned int fullPassLen = yRes - (kernelMedian+edgeSpan);
 	const __m128i fullDiv = _mm_set1_epi16(WeightToDiv(kernelSpan << 4));
 
@@ -177,30 +178,30 @@ void VerticalBoxBlur32(
 		for (unsigned int iY = 0; iY < edgeSpan; ++iY)
 		{
 			Add(accumulator, addRemainder, pSrc[addPos], remainderShift);
-			addPos += xRes;
+			addPos += stride;
 		}
 
 		// pre-pass: up to full weight
 		for (unsigned int iY = 0; iY < kernelMedian; ++iY)
 		{
 			Add(accumulator, addRemainder, pSrc[addPos], remainderShift);
-			addPos += xRes;
+			addPos += stride;
 
 			pDest[destIndex] = Div(accumulator, edgeDivs[iY]);
-			destIndex += xRes;
+			destIndex += stride;
 		}
 		
 		// main pass
 		for (unsigned int iY = 0; iY < fullPassLen; ++iY)
 		{
 			Add(accumulator, addRemainder, pSrc[addPos], remainderShift);
-			addPos += xRes;
+			addPos += stride;
 
 			Sub(accumulator, subRemainder, pSrc[subPos], remainderShift);
-			subPos += xRes;
+			subPos += stride;
 
 			pDest[destIndex] = Div(accumulator, fullDiv);
-			destIndex += xRes;
+			destIndex += stride;
 		}
 		
 		// add additive remainder if needed (subtractive remainder is taken care of by Sub())
@@ -211,14 +212,34 @@ void VerticalBoxBlur32(
 		for (unsigned int iY = edgeSpan; iY > 0; --iY)
 		{
 			Sub(accumulator, subRemainder, pSrc[subPos], remainderShift);
-			subPos += xRes;	
+			subPos += stride;	
 
 			pDest[destIndex] = Div(accumulator, edgeDivs[iY-1]);
-			destIndex += xRes;
+			destIndex += stride;
 		}
 	}
 }
 
+void HorizontalBoxBlur32(
+	uint32_t *pDest,
+	const uint32_t *pSrc,
+	unsigned int xRes,
+	unsigned int yRes,
+	float strength)
+{
+	HorizontalBoxBlur32_Stride(pDest, pSrc, xRes, yRes, xRes, strength);
+}
+
+void VerticalBoxBlur32(
+	uint32_t *pDest,
+	const uint32_t *pSrc,
+	unsigned int xRes,
+	unsigned int yRes,
+	float strength)
+{
+	VerticalBoxBlur32_Stride(pDest, pSrc, xRes, yRes, xRes, strength);
+}
+
 void BoxBlur32(
 	uint32_t *pDest,
 	const uint32_t *pSrc,
@@ -229,3 +250,36 @@ void BoxBlur32(
 	HorizontalBoxBlur32(pDest, pSrc, xRes, yRes, strength);
 	VerticalBoxBlur32(pDest, pDest, xRes, yRes, strength);
 }
+
+void HorizontalBoxBlur32R(
+	uint32_t *pDest,
+	const uint32_t *pSrc,
+	const Rect &rect,
+	unsigned int stride,
+	float strength)
+{
+	const size_t offset = RectOffset(rect, stride);
+	HorizontalBoxBlur32_Stride(pDest+offset, pSrc+offset, rect.resX, rect.resY, stride, strength);
+}
+
+void VerticalBoxBlur32R(
+	uint32_t *pDest,
+	const uint32_t *pSrc,
+	const Rect &rect,
+	unsigned int stride,
+	float strength)
+{
+	const size_t offset = RectOffset(rect, stride);
+	VerticalBoxBlur32_Stride(pDest+offset, pSrc+offset, rect.resX, rect.resY, stride, strength);
+}
+
+void BoxBlur32R(
+	uint32_t *pDest,
+	const uint32_t *pSrc,
+	const Rect &rect,
+	unsigned int stride,
+	float strength)
+{
+	HorizontalBoxBlur32R(pDest, pSrc, rect, stride, strength);
+	VerticalBoxBlur32R(pDest, pDest, rect, stride, strength);
+}
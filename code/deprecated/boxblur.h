@@ -18,6 +18,13 @@ CKD_INLINE static float BoxBlurScale(float strength)
 	return strength;
 }
 
+// kernel span (in pixels) for a given strength, scaled along with the production resolution (see g_resScale)
+// - limited to 255 pixels, so at higher resolutions the strongest blurs top out a little sooner
+CKD_INLINE static unsigned BoxBlurSpan(float strength)
+{
+	return clampi(1, 255, int(strength*255.f*g_resScale));
+}
+
 void HorizontalBoxBlur32(
 	uint32_t *pDest,
 	const uint32_t *pSrc,
@@ -40,6 +47,30 @@ void BoxBlur32(
 	unsigned int yRes,
 	float strength);
 
+// region of interest variants: only 'rect' is blurred, both buffers are 'stride' pixels wide
+// - anything outside of 'rect' does not bleed in (it's treated like the edge of a buffer)
+// - 'rect' must be at least as large as the kernel span along the blur axis
+void HorizontalBoxBlur32R(
+	uint32_t *pDest,
+	const uint32_t *pSrc,
+	const Rect &rect,
+	unsigned int stride,
+	float strength);
+
+void VerticalBoxBlur32R(
+	uint32_t *pDest,
+	const uint32_t *pSrc,
+	const Rect &rect,
+	unsigned int stride,
+	float strength);
+
+void BoxBlur32R(
+	uint32_t *pDest,
+	const uint32_t *pSrc,
+	const Rect &rect,
+	unsigned int stride,
+	float strength);
+
 #endif // _BOX_BLUR_H_DEPRECATED
 
 #endif // ARRESTED_DEV_LEGACY
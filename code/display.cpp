@@ -4,10 +4,24 @@
 #include "main.h"
 #include "display.h"
 
+// renderers whose SDL_LockTexture() hands out a plain heap buffer (uploaded on unlock) instead of mapped GPU memory
+static bool IsCachedLock(const char *renderer)
+{
+	const char *kCached[] = { "software", "opengl", "opengles2" };
+	for (const char *name : kCached)
+		if (0 == strcmp(renderer, name))
+			return true;
+
+	return false;
+}
+
 Display::Display() :
 	m_window(nullptr),
 	m_renderer(nullptr),
-	m_texture(nullptr)
+	m_texture(nullptr),
+	m_direct(false),
+	m_locked(false),
+	m_pFallback(nullptr)
 {
 	// smooth scaling (if necessary)
 	SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "linear");
@@ -15,6 +29,9 @@ Display::Display() :
 
 Display::~Display()
 {
+	if (true == m_locked)
+		SDL_UnlockTexture(m_texture);
+
 	SDL_DestroyTexture(m_texture);
 	SDL_DestroyRenderer(m_renderer);
 	SDL_DestroyWindow(m_window);
@@ -36,6 +53,10 @@ bool Display::Open(const std::string &title, unsigned int xRes, unsigned int yRe
 		m_texture = SDL_CreateTexture(m_renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, xRes, yRes);
 		m_pitch = xRes*4;
 
+		// only render straight into texture memory if it's a system memory copy we can read back (see Lock())
+		SDL_RendererInfo info;
+		m_direct = 0 == SDL_GetRendererInfo(m_renderer, &info) && IsCachedLock(info.name);
+
 #if !defined(SYNC_PLAYER)
 		// initialize ImGui
 		if (!kFullScreen)
@@ -73,6 +94,60 @@ void Display::Update(const uint32_t *pPixels)
 		SDL_RenderCopy(m_renderer, m_texture, nullptr, nullptr);
 	}
 
+	Render();
+}
+
+uint32_t *Display::Lock(uint32_t *pFallback, bool direct)
+{
+	VIZ_ASSERT(false == m_locked && nullptr != pFallback);
+
+	m_pFallback = pFallback;
+
+	if (true == direct && true == m_direct)
+	{
+		void *pPixels;
+		int pitch;
+		if (0 == SDL_LockTexture(m_texture, nullptr, &pPixels, &pitch))
+		{
+			// our effects assume a contiguous buffer (pitch equals width) and aligned rows
+			if (unsigned(pitch) == m_pitch && 0 == (reinterpret_cast<uintptr_t>(pPixels) & (kAlignTo-1)))
+			{
+				m_locked = true;
+				return static_cast<uint32_t *>(pPixels);
+			}
+
+			SDL_UnlockTexture(m_texture);
+		}
+
+		// don't bother trying again
+		m_direct = false;
+	}
+
+	return pFallback;
+}
+
+void Display::Present()
+{
+	SDL_RenderClear(m_renderer);
+
+	if (true == m_locked)
+	{
+		SDL_UnlockTexture(m_texture);
+		m_locked = false;
+	}
+	else
+	{
+		VIZ_ASSERT(nullptr != m_pFallback);
+		SDL_UpdateTexture(m_texture, nullptr, m_pFallback, m_pitch);
+	}
+
+	SDL_RenderCopy(m_renderer, m_texture, nullptr, nullptr);
+
+	Render();
+}
+
+void Display::Render()
+{
 #if !defined(SYNC_PLAYER)
 	if (!kFullScreen)
 		ImGui_ImplSDLRenderer2_RenderDrawData(ImGui::GetDrawData());
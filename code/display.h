@@ -16,13 +16,31 @@ public:
 
 	bool Open(const std::string &title, unsigned int xRes, unsigned int yRes, bool fullScreen);
 
-	// pass a kResX*kResY ARGB8888 buffer or NULL to just clear the screen
+	// pass an ARGB8888 buffer of the resolution passed to Open() (see output.h) or NULL to just clear the screen
 	void Update(const uint32_t *pPixels);
 
+	// zero-copy alternative to Update():
+	// - Lock() returns the buffer to render the next frame into: the (locked) texture memory itself if 'direct' is set,
+	//   the renderer locks into plain (cached) system memory and its pitch and alignment match ours, otherwise
+	//   'pFallback' (which is then copied by Present() like Update() does)
+	// - most of our code reads back what it draws (blends, blurs, fades, capture), which on write-combined or write-only
+	//   texture memory (D3D, Metal) is either dreadfully slow or undefined, so only renderers known to hand out a system
+	//   memory copy (software, OpenGL) qualify; pass 'direct' false if anyone else (e.g. capture) is going to read it
+	// - contents are undefined (not the previous frame!), so the frame must be drawn in it's entirety
+	// - every Lock() must be followed by Present()
+	uint32_t *Lock(uint32_t *pFallback, bool direct);
+	void Present();
+
 private:
+	void Render();
+
 	SDL_Window   *m_window;
 	SDL_Renderer *m_renderer;
 	SDL_Texture  *m_texture;
 
 	unsigned m_pitch;
+
+	bool m_direct;        // false if texture memory is (or proved) unfit
+	bool m_locked;
+	uint32_t *m_pFallback;
 };
@@ -0,0 +1,169 @@
+// cookiedough -- rendered frame cache (Rocket editor scrubbing)
+
+#include "main.h"
+#include "alloc-large.h"
+#include "frame-cache.h"
+#include "rocket.h"
+#include "output.h"
+
+#include <list>
+#include <unordered_map>
+
+struct CachedFrame
+{
+	uint64_t hash;
+	double row;
+	std::vector<double> values;
+	DemoState state;
+	uint64_t fxLevels;
+	unsigned outputMode;
+	uint32_t *pPixels;
+};
+
+// front is most recently used
+static std::list<CachedFrame> s_frames;
+static std::unordered_map<uint64_t, std::list<CachedFrame>::iterator> s_index;
+
+// pixel buffers of frames that were dropped, reused before allocating new ones
+static std::vector<uint32_t *> s_pFree;
+
+static size_t s_capacity = 0; // in frames
+static size_t s_numHits = 0, s_numMisses = 0, s_numInvalidated = 0;
+
+// FNV-1a
+static uint64_t Hash(const void *pData, size_t size, uint64_t hash = 14695981039346656037ull)
+{
+	const uint8_t *pBytes = static_cast<const uint8_t *>(pData);
+	for (size_t iByte = 0; iByte < size; ++iByte)
+		hash = (hash ^ pBytes[iByte]) * 1099511628211ull;
+
+	return hash;
+}
+
+static uint64_t Hash(const Rocket::Snapshot &snapshot, const DemoState &state, uint64_t fxLevels)
+{
+	const unsigned outputMode = Output_GetMode();
+
+	uint64_t hash = Hash(&snapshot.row, sizeof(double));
+	hash = Hash(snapshot.values.data(), snapshot.values.size()*sizeof(double), hash);
+	hash = Hash(&state, sizeof(DemoState), hash);
+	hash = Hash(&fxLevels, sizeof(uint64_t), hash);
+	return Hash(&outputMode, sizeof(unsigned), hash);
+}
+
+static bool Matches(const CachedFrame &frame, const Rocket::Snapshot &snapshot, const DemoState &state, uint64_t fxLevels)
+{
+	return frame.row == snapshot.row && frame.values == snapshot.values && 0 == memcmp(&frame.state, &state, sizeof(DemoState)) &&
+		frame.fxLevels == fxLevels && frame.outputMode == Output_GetMode();
+}
+
+static void Drop(std::list<CachedFrame>::iterator iFrame)
+{
+	s_pFree.push_back(iFrame->pPixels);
+	s_index.erase(iFrame->hash);
+	s_frames.erase(iFrame);
+}
+
+bool FrameCache_Create(size_t budget)
+{
+	s_capacity = budget/g_outputBytes;
+	return true;
+}
+
+void FrameCache_Destroy()
+{
+	for (CachedFrame &frame : s_frames)
+		freeLarge(frame.pPixels);
+
+	for (uint32_t *pPixels : s_pFree)
+		freeLarge(pPixels);
+
+	s_frames.clear();
+	s_index.clear();
+	s_pFree.clear();
+}
+
+bool FrameCache_Fetch(uint32_t *pDest, const DemoState &state, uint64_t fxLevels)
+{
+	if (0 == s_capacity)
+		return false;
+
+	const Rocket::Snapshot &snapshot = Rocket::GetSnapshot();
+
+	const auto iEntry = s_index.find(Hash(snapshot, state, fxLevels));
+	if (s_index.end() == iEntry || false == Matches(*iEntry->second, snapshot, state, fxLevels))
+	{
+		++s_numMisses;
+		return false;
+	}
+
+	// move to front
+	s_frames.splice(s_frames.begin(), s_frames, iEntry->second);
+
+	memcpy(pDest, s_frames.front().pPixels, g_outputBytes);
+
+	++s_numHits;
+	return true;
+}
+
+void FrameCache_Store(const uint32_t *pSrc, const DemoState &state, uint64_t fxLevels)
+{
+	if (0 == s_capacity)
+		return;
+
+	const Rocket::Snapshot &snapshot = Rocket::GetSnapshot();
+	const uint64_t hash = Hash(snapshot, state, fxLevels);
+
+	// same hash, other frame (or the exact same one): replace
+	const auto iEntry = s_index.find(hash);
+	if (s_index.end() != iEntry)
+		Drop(iEntry->second);
+
+	// evict least recently used
+	if (s_frames.size() == s_capacity)
+		Drop(std::prev(s_frames.end()));
+
+	uint32_t *pPixels;
+	if (false == s_pFree.empty())
+	{
+		pPixels = s_pFree.back();
+		s_pFree.pop_back();
+	}
+	else
+		pPixels = static_cast<uint32_t*>(mallocLarge(g_outputBytes, "frame cache"));
+
+	memcpy(pPixels, pSrc, g_outputBytes);
+
+	s_frames.push_front({ hash, snapshot.row, snapshot.values, state, fxLevels, Output_GetMode(), pPixels });
+	s_index[hash] = s_frames.begin();
+}
+
+void FrameCache_Invalidate()
+{
+	if (true == s_frames.empty())
+		return;
+
+	// re-evaluate each frame's row with the new keys and drop it if anything differs
+	Rocket::Snapshot snapshot;
+	for (auto iFrame = s_frames.begin(); iFrame != s_frames.end(); )
+	{
+		const auto iNext = std::next(iFrame);
+
+		Rocket::Evaluate(iFrame->row, snapshot);
+		if (iFrame->values != snapshot.values)
+		{
+			Drop(iFrame);
+			++s_numInvalidated;
+		}
+
+		iFrame = iNext;
+	}
+}
+
+void FrameCache_ShowStats()
+{
+#if !defined(SYNC_PLAYER)
+	if (true == ImGuiIsVisible())
+		ImGui::Text("Frame cache: %zu/%zu frames, %zu hits, %zu misses, %zu invalidated", s_frames.size(), s_capacity, s_numHits, s_numMisses, s_numInvalidated);
+#endif
+}
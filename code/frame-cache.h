@@ -0,0 +1,32 @@
+// cookiedough -- rendered frame cache (Rocket editor scrubbing)
+
+/*
+	While syncing the editor is paused most of the time and you keep jumping back and forth over the same rows; this
+	keeps finished frames around (least recently used goes first) so revisiting a row costs a copy instead of a render.
+
+	- a frame is keyed by the row, all sync. values at that row, the DemoState (see demo.h), the Fx map levels
+	  (FxGovernor_GetLevels()) and the output mode (Output_GetMode()), so a hit is exactly what Demo_Draw() would render
+	- when keys are edited, entries for which any value at their row changed are dropped right away
+	- memory bound: 'budget' bytes worth of frames, 0 disables the cache
+	- opt-in: '-frame-cache <MB>' on the command line (see main.cpp), off by default
+	- only used by the editor, and only while paused; on a hit no part draws, so neither do their ImGui widgets
+*/
+
+#pragma once
+
+#include "demo.h"
+
+bool FrameCache_Create(size_t budget);
+void FrameCache_Destroy();
+
+// copies cached frame for the current row (and state and levels) to 'pDest' and returns true, if any
+bool FrameCache_Fetch(uint32_t *pDest, const DemoState &state, uint64_t fxLevels);
+
+// stores finished frame for the current row (and state and levels the frame started with)
+void FrameCache_Store(const uint32_t *pSrc, const DemoState &state, uint64_t fxLevels);
+
+// call after Rocket::Boost() picked up edited keys
+void FrameCache_Invalidate();
+
+// ImGui statistics
+void FrameCache_ShowStats();
@@ -2,26 +2,170 @@
 // cookiedough -- old school 2x2 map bilinear blitters plus buffers to use (for heavier effects)
 
 #include "main.h"
+#include "alloc-large.h"
 #include "util.h"
+#include "bilinear.h"
 #include "fx-blitter.h"
+#include "output.h"
+
+static_assert(0 == (FxMapResX(kOutputModes[0].resX) & 3) && 0 == (FxMapResY(kOutputModes[0].resY) & 3));
+static_assert(0 == (FxMapResX(kOutputModes[1].resX) & 3) && 0 == (FxMapResY(kOutputModes[1].resY) & 3));
+static_assert(0 == (FxMapResX(kOutputModes[2].resX) & 3) && 0 == (FxMapResY(kOutputModes[2].resY) & 3));
+static_assert(0 == (FxMapPitch(kMaxResX)*sizeof(uint32_t)) % kCacheLine);
+
+size_t g_fxMapResX = FxMapResX(kAuthorResX);
+size_t g_fxMapResY = FxMapResY(kAuthorResY);
+size_t g_fxMapPitch = FxMapPitch(kAuthorResX);
+size_t g_fxMapSize = FxMapPitch(kAuthorResX)*FxMapResY(kAuthorResY);
+size_t g_fxMapBytes = FxMapPitch(kAuthorResX)*FxMapResY(kAuthorResY)*sizeof(uint32_t);
+unsigned g_fxMapVisX = unsigned(FxMapResX(kAuthorResX)-4);
+Rect g_fxMapRect = { 0, 0, unsigned(FxMapResX(kAuthorResX)), unsigned(FxMapResY(kAuthorResY)) };
+
+FxMapRes g_fxMapRes[kNumFxMapRes];
 
 uint32_t *g_pFxMap[kNumFxMaps] = { nullptr };
 
+// instances for the output mode (see output.h), picked by FxBlitter_Create()
+static void (*s_blit2x2)(uint32_t* pDest, const uint32_t* pSrc) = nullptr;
+static void (*s_blit2x2Band)(uint32_t* pDest, const uint32_t* pSrc, unsigned firstRow, unsigned numRows) = nullptr;
+static void (*s_blitScaled[kNumFxMapRes])(uint32_t* pDest, const uint32_t* pSrc) = { nullptr };
+
+template <unsigned kMode> static void Fx_Blit_2x2_Mode(uint32_t* pDest, const uint32_t* pSrc);
+template <unsigned kMode> static void Fx_Blit_2x2_Band_Mode(uint32_t* pDest, const uint32_t* pSrc, unsigned firstRow, unsigned numRows);
+template <unsigned kMode, unsigned kLevel> static void Fx_Blit_Scaled(uint32_t* pDest, const uint32_t* pSrc);
+
+template <unsigned kMode>
+static void FxBlitter_PickMode()
+{
+	s_blit2x2 = Fx_Blit_2x2_Mode<kMode>;
+	s_blit2x2Band = Fx_Blit_2x2_Band_Mode<kMode>;
+
+	static_assert(4 == kNumFxMapRes);
+	s_blitScaled[0] = nullptr; // Fx_Blit_2x2()
+	s_blitScaled[1] = Fx_Blit_Scaled<kMode, 1>;
+	s_blitScaled[2] = Fx_Blit_Scaled<kMode, 2>;
+	s_blitScaled[3] = Fx_Blit_Scaled<kMode, 3>;
+}
+
 bool FxBlitter_Create()
 {
-	uint32_t* basePtr = static_cast<uint32_t*>(mallocAligned(kFxMapBytes*4, kAlignTo));
+	g_fxMapResX = FxMapResX(g_resX);
+	g_fxMapResY = FxMapResY(g_resY);
+	g_fxMapPitch = FxMapPitch(g_resX);
+	g_fxMapSize = g_fxMapPitch*g_fxMapResY;
+	g_fxMapBytes = g_fxMapSize*sizeof(uint32_t);
+	g_fxMapVisX = unsigned(g_fxMapResX-4);
+	g_fxMapRect = { 0, 0, unsigned(g_fxMapResX), unsigned(g_fxMapResY) };
+
+	for (unsigned iRes = 0; iRes < kNumFxMapRes; ++iRes)
+		g_fxMapRes[iRes] = FxMapResForDiv(g_resX, g_resY, iRes, kFxMapResDiv[iRes]);
+
+	VIZ_ASSERT(g_fxMapRes[0].resX == g_fxMapResX && g_fxMapRes[0].resY == g_fxMapResY);
+
+	static_assert(3 == kNumOutputModes);
+	switch (Output_GetMode())
+	{
+	case 0:
+		FxBlitter_PickMode<0>();
+		break;
+
+	case 1:
+		FxBlitter_PickMode<1>();
+		break;
+
+	case 2:
+		FxBlitter_PickMode<2>();
+		break;
+
+	default:
+		VIZ_ASSERT(false);
+		return false;
+	}
+
+	uint32_t* basePtr = static_cast<uint32_t*>(mallocLarge(g_fxMapBytes*4, "fx maps"));
 
 	g_pFxMap[0] = basePtr;
-	g_pFxMap[1] = g_pFxMap[0] + kFxMapSize;
-	g_pFxMap[2] = g_pFxMap[1] + kFxMapSize;
-	g_pFxMap[3] = g_pFxMap[2] + kFxMapSize;
+	g_pFxMap[1] = g_pFxMap[0] + g_fxMapSize;
+	g_pFxMap[2] = g_pFxMap[1] + g_fxMapSize;
+	g_pFxMap[3] = g_pFxMap[2] + g_fxMapSize;
 
 	return true;
 }
 
 void FxBlitter_Destroy()
 {
-	freeAligned(g_pFxMap[0]);
+	freeLarge(g_pFxMap[0]);
+}
+
+// blits map row iY (and interpolates towards iY+1) to 2 output rows
+template <unsigned kMode>
+CKD_INLINE static void Fx_Blit_2x2_Row(uint32_t* pDest, const uint32_t* pSrc, unsigned iY)
+{
+	constexpr size_t kDestResX = kOutputModes[kMode].resX;
+	constexpr size_t kMapResX = FxMapResX(kDestResX);
+	constexpr size_t kMapPitch = FxMapPitch(kDestResX);
+
+	const __m128i *pSrcRow0 = reinterpret_cast<const __m128i*>(&pSrc[iY*kMapPitch]);
+	const __m128i *pSrcRow1 = reinterpret_cast<const __m128i*>(&pSrc[(iY+1)*kMapPitch]);
+
+	__m128i* pDstTop = reinterpret_cast<__m128i*>(&pDest[(iY<<1)*kDestResX]);
+	__m128i* pDstBot = reinterpret_cast<__m128i*>(&pDest[((iY<<1)+1)*kDestResX]);
+
+	for (unsigned iX = 0; iX < (kMapResX-4)/4; ++iX)
+	{
+		// load quad pixels
+		const __m128i r0c0 = _mm_load_si128(pSrcRow0+iX); 
+		const __m128i r1c0 = _mm_load_si128(pSrcRow1+iX);
+		
+		// fetch next 4 pixels to get right hand neighbours for interpolation (this is where the guard band allows for a full extra 128-bit load)
+		const __m128i r0c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc[iY*kMapPitch + (iX<<2) + 1]));
+		const __m128i r1c1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&pSrc[(iY+1)*kMapPitch + (iX<<2) + 1]));
+
+		// avg. horz. top/bottom rows
+		const __m128i avgH0 = _mm_avg_epu8(r0c0, r0c1);
+		const __m128i avgH1 = _mm_avg_epu8(r1c0, r1c1);
+
+		// vertical avg.
+		const __m128i avgV0 = _mm_avg_epu8(r0c0, r1c0);
+		const __m128i avgCenter = _mm_avg_epu8(avgH0, avgH1);
+
+		// unpack/interleave into dest. pairs
+		const __m128i dstTopL = _mm_unpacklo_epi32(r0c0, avgH0);
+		const __m128i dstTopR = _mm_unpackhi_epi32(r0c0, avgH0);
+		
+		const __m128i dstBotL = _mm_unpacklo_epi32(avgV0, avgCenter);
+		const __m128i dstBotR = _mm_unpackhi_epi32(avgV0, avgCenter);
+
+		// store 8 pixels per row (4 x 128-bit stores)
+		_mm_store_si128(pDstTop + (iX<<1),  dstTopL);
+		_mm_store_si128(pDstTop + (iX<<1)+1,dstTopR);
+		_mm_store_si128(pDstBot + (iX<<1),  dstBotL);
+		_mm_store_si128(pDstBot + (iX<<1)+1,dstBotR);
+	}
+}
+
+template <unsigned kMode>
+static void Fx_Blit_2x2_Mode(uint32_t* pDest, const uint32_t* pSrc)
+{
+	constexpr unsigned kMapVisY = unsigned(FxMapResY(kOutputModes[kMode].resY)-4);
+
+	#pragma omp parallel for schedule(static)
+	for (unsigned iY = 0; iY < kMapVisY; ++iY)
+		Fx_Blit_2x2_Row<kMode>(pDest, pSrc, iY);
+ 
+	CKD_FLANDERS(_mm_sfence());
+}
+
+template <unsigned kMode>
+static void Fx_Blit_2x2_Band_Mode(uint32_t* pDest, const uint32_t* pSrc, unsigned firstRow, unsigned numRows)
+{
+	constexpr unsigned kMapVisY = unsigned(FxMapResY(kOutputModes[kMode].resY)-4);
+
+	const unsigned endRow = std::min<unsigned>(firstRow+numRows, kMapVisY);
+	for (unsigned iY = firstRow; iY < endRow; ++iY)
+		Fx_Blit_2x2_Row<kMode>(pDest, pSrc, iY);
+
+	CKD_FLANDERS(_mm_sfence());
 }
 
 void Fx_Blit_2x2(uint32_t* pDest, const uint32_t* pSrc)
@@ -29,59 +173,79 @@ void Fx_Blit_2x2(uint32_t* pDest, const uint32_t* pSrc)
 	VIZ_ASSERT_ALIGNED(pDest);
 	VIZ_ASSERT_ALIGNED(pSrc);
 
+	s_blit2x2(pDest, pSrc);
+}
+
+void Fx_Blit_2x2_Band(uint32_t* pDest, const uint32_t* pSrc, unsigned firstRow, unsigned numRows)
+{
+	VIZ_ASSERT_ALIGNED(pDest);
+	VIZ_ASSERT_ALIGNED(pSrc);
+
+	s_blit2x2Band(pDest, pSrc, firstRow, numRows);
+}
+
+// bilinear upscale of g_fxMapRes[kLevel] map, everything known at compile time per mode and level
+template <unsigned kMode, unsigned kLevel>
+static void Fx_Blit_Scaled(uint32_t* pDest, const uint32_t* pSrc)
+{
+	constexpr size_t kDestResX = kOutputModes[kMode].resX;
+	constexpr size_t kDestResY = kOutputModes[kMode].resY;
+	constexpr size_t kMapPitch = FxMapPitch(kDestResX);
+	constexpr FxMapRes kRes = FxMapResForDiv(kDestResX, kDestResY, kLevel, kFxMapResDiv[kLevel]);
+
+	// 16:16 steps, top left aligned like Fx_Blit_2x2() (the guard band holds the right & bottom neighbours)
+	constexpr unsigned kStepX = ((kRes.resX-4)<<16)/unsigned(kDestResX);
+	constexpr unsigned kStepY = ((kRes.resY-4)<<16)/unsigned(kDestResY);
+
 	#pragma omp parallel for schedule(static)
-	for (unsigned iY = 0; iY < kFxMapResY-4; ++iY)
+	for (int iY = 0; iY < int(kDestResY); ++iY)
 	{
-		const __m128i *pSrcRow0 = reinterpret_cast<const __m128i*>(&pSrc[iY*kFxMapResX]);
-		const __m128i *pSrcRow1 = reinterpret_cast<const __m128i*>(&pSrc[(iY+1)*kFxMapResX]);
+		const unsigned V = iY*kStepY;
+		const unsigned V0 = (V >> 16)*kMapPitch;
+		const unsigned fracV = ((V >> 8) & 0xff) * 0x01010101;
 
-		__m128i* pDstTop = reinterpret_cast<__m128i*>(&pDest[(iY<<1)*kResX]);
-		__m128i* pDstBot = reinterpret_cast<__m128i*>(&pDest[((iY<<1)+1)*kResX]);
+		__m128i* pDestRow = reinterpret_cast<__m128i*>(pDest + iY*kDestResX);
 
-		for (unsigned iX = 0; iX < (kFxMapResX-4)/4; ++iX)
+		for (unsigned iX = 0; iX < kDestResX; iX += 4)
 		{
-			// load quad pixels
-			const __m128i r0c0 = _mm_load_si128(pSrcRow0+iX); 
-			const __m128i r1c0 = _mm_load_si128(pSrcRow1+iX);
-			
-			// fetch next 4 pixels to get right hand neighbours for interpolation (this is where the guard band allows for a full extra 128-bit load)
-			const __m128i r0c1 = _mm_load_si128(reinterpret_cast<const __m128i*>(&pSrc[iY*kFxMapResX + (iX<<2) + 1]));
-			const __m128i r1c1 = _mm_load_si128(reinterpret_cast<const __m128i*>(&pSrc[(iY+1)*kFxMapResX + (iX<<2) + 1]));
-
-			// avg. horz. top/bottom rows
-			const __m128i avgH0 = _mm_avg_epu8(r0c0, r0c1);
-			const __m128i avgH1 = _mm_avg_epu8(r1c0, r1c1);
-
-			// vertical avg.
-			const __m128i avgV0 = _mm_avg_epu8(r0c0, r1c0);
-			const __m128i avgCenter = _mm_avg_epu8(avgH0, avgH1);
-
-			// unpack/interleave into dest. pairs
-			const __m128i dstTopL = _mm_unpacklo_epi32(r0c0, avgH0);
-			const __m128i dstTopR = _mm_unpackhi_epi32(r0c0, avgH0);
-			
-			const __m128i dstBotL = _mm_unpacklo_epi32(avgV0, avgCenter);
-			const __m128i dstBotR = _mm_unpackhi_epi32(avgV0, avgCenter);
-
-			// store 8 pixels per row (4 x 128-bit stores)
-			_mm_store_si128(pDstTop + (iX<<1),  dstTopL);
-			_mm_store_si128(pDstTop + (iX<<1)+1,dstTopR);
-			_mm_store_si128(pDstBot + (iX<<1),  dstBotL);
-			_mm_store_si128(pDstBot + (iX<<1)+1,dstBotR);
+			__m128i colors[4];
+			for (unsigned iPixel = 0; iPixel < 4; ++iPixel)
+			{
+				const unsigned U = (iX+iPixel)*kStepX;
+				const unsigned U0 = U >> 16;
+				const unsigned fracU = ((U >> 8) & 0xff) * 0x01010101;
+				colors[iPixel] = bsamp32_32(pSrc, U0, V0, U0+1, V0+kMapPitch, fracU, fracV);
+			}
+
+			const __m128i AB = _mm_packus_epi32(colors[0], colors[1]);
+			const __m128i CD = _mm_packus_epi32(colors[2], colors[3]);
+			_mm_stream_si128(pDestRow + (iX>>2), _mm_packus_epi16(AB, CD));
 		}
 	}
- 
+
 	CKD_FLANDERS(_mm_sfence());
 }
 
+void Fx_Blit(uint32_t* pDest, const uint32_t* pSrc, const FxMapRes &res)
+{
+	VIZ_ASSERT_ALIGNED(pDest);
+	VIZ_ASSERT_ALIGNED(pSrc);
+	VIZ_ASSERT(res.level < kNumFxMapRes);
+
+	if (0 == res.level)
+		s_blit2x2(pDest, pSrc);
+	else
+		s_blitScaled[res.level](pDest, pSrc);
+}
+
 void FxBlitter_DrawTestPattern(uint32_t* pDest)
 {
-	for (unsigned iY = 0; iY < kFxMapResY; ++iY)
+	for (unsigned iY = 0; iY < g_fxMapResY; ++iY)
 	{
-		for (unsigned iX = 0; iX < kFxMapResX; ++iX)
+		for (unsigned iX = 0; iX < g_fxMapResX; ++iX)
 		{
 			int color;
-			if (iY < kFxMapResY / 2)
+			if (iY < g_fxMapResY / 2)
 			{
 				color = (iY&1) ? -1 : 0;
 			}
@@ -90,7 +254,7 @@ void FxBlitter_DrawTestPattern(uint32_t* pDest)
 				color = (iX&1) ? -1 : 0;
 			}
 
-			g_pFxMap[0][iY*kFxMapResX + iX] = color;
+			g_pFxMap[0][iY*g_fxMapPitch + iX] = color;
 		}
 	}
 
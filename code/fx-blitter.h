@@ -4,7 +4,8 @@
 /*
 	IMPORTANT:
 	- assumes output resolution for blit destination
-	- buffers must be 16-byte aligned
+	- map sizes follow the output resolution, so call FxBlitter_Create() after Output_Create() (see output.h)
+	- buffers must be 16-byte aligned and g_fxMapPitch pixels wide
 	- 4 pixels guard band is necessary both for the blitter(s) and effects
 */
 
@@ -13,14 +14,52 @@
 constexpr unsigned kFxMapDiv = 2;
 constexpr size_t kNumFxMaps = 4;
 
-constexpr size_t kFxMapResX = (kResX/kFxMapDiv)+4; // add 4 pixels guard band for blit implementation (no edge cases)
-constexpr size_t kFxMapResY = (kResY/kFxMapDiv)+4; // 4 pixels because effects depend on these being multiples of 4
+// map size for a given production resolution (see kOutputModes[], main.h)
+constexpr size_t FxMapResX(size_t resX) { return (resX/kFxMapDiv)+4; } // add 4 pixels guard band for blit implementation (no edge cases)
+constexpr size_t FxMapResY(size_t resY) { return (resY/kFxMapDiv)+4; } // 4 pixels because effects depend on these being multiples of 4
 
-static_assert(0 == (kFxMapResX & 3));
-static_assert(0 == (kFxMapResY & 3));
+// rows are padded to a whole number of cache lines so threads writing neighbouring rows never share one:
+// g_fxMapResX is the width, but rows are g_fxMapPitch pixels apart (treating a map as a flat array is fine)
+constexpr size_t FxMapPitch(size_t resX) 
+{ 
+	return (FxMapResX(resX) + kCacheLine/sizeof(uint32_t)-1) & ~(kCacheLine/sizeof(uint32_t)-1); 
+}
 
-constexpr size_t kFxMapSize = kFxMapResX*kFxMapResY;
-constexpr size_t kFxMapBytes = kFxMapSize*sizeof(uint32_t);
+// for the production resolution (set once by FxBlitter_Create(), treat as constants)
+extern size_t g_fxMapResX;
+extern size_t g_fxMapResY;
+extern size_t g_fxMapPitch;
+extern size_t g_fxMapSize;
+extern size_t g_fxMapBytes;
+extern unsigned g_fxMapVisX;
+
+// for the ...R() functions (util.h, deprecated/boxblur.h), pass g_fxMapPitch as stride
+extern Rect g_fxMapRect;
+
+// dynamic resolution (see fx-governor.h): a map can also be rendered at a coarser divisor than kFxMapDiv, in which
+// case only the top left resX*resY pixels are used (same pitch, same buffers) and Fx_Blit() scales it up
+struct FxMapRes
+{
+	unsigned level;      // index in g_fxMapRes[]
+	float div;
+	unsigned resX, resY; // like g_fxMapResX/g_fxMapResY: visible area (rounded up to 4) plus 4 pixels guard band
+	float toU, toV;      // pixel to [0..1] in terms of g_fxMapRes, so every level frames the image exactly the same
+};
+
+constexpr FxMapRes FxMapResForDiv(size_t resX, size_t resY, unsigned level, float div)
+{
+	const unsigned mapVisX = unsigned(FxMapResX(resX)-4);
+	const unsigned mapVisY = unsigned(FxMapResY(resY)-4);
+	const unsigned visX = (unsigned(resX/div + 0.999f) + 3) & ~3;
+	const unsigned visY = (unsigned(resY/div + 0.999f) + 3) & ~3;
+	return { level, div, visX+4, visY+4, (float(mapVisX)/visX)/(mapVisX+4), (float(mapVisY)/visY)/(mapVisY+4) };
+}
+
+constexpr unsigned kNumFxMapRes = 4;
+constexpr float kFxMapResDiv[kNumFxMapRes] = { float(kFxMapDiv), 2.5f, 3.f, 4.f };
+
+// for the production resolution (set by FxBlitter_Create())
+extern FxMapRes g_fxMapRes[kNumFxMapRes];
 
 // FIXME: this is just asking for trouble, even for late 1990s standards
 extern uint32_t *g_pFxMap[kNumFxMaps];
@@ -30,4 +69,11 @@ void FxBlitter_Destroy();
 
 void Fx_Blit_2x2(uint32_t* pDest, const uint32_t* pSrc);
 
+// same, but only map rows [firstRow, firstRow+numRows) (for use in a task graph)
+// reads one row further down, so make sure that one is done too
+void Fx_Blit_2x2_Band(uint32_t* pDest, const uint32_t* pSrc, unsigned firstRow, unsigned numRows);
+
+// blit map rendered at 'res' (Fx_Blit_2x2() for g_fxMapRes[0], otherwise bilinear upscale to g_resX*g_resY)
+void Fx_Blit(uint32_t* pDest, const uint32_t* pSrc, const FxMapRes &res);
+
 void FxBlitter_DrawTestPattern(uint32_t* pDest);
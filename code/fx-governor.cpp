@@ -0,0 +1,106 @@
+// cookiedough -- dynamic resolution governor for (expensive) Fx map effects
+
+#include "main.h"
+#include "fx-governor.h"
+
+// hysteresis: frames in a row over budget before going coarser, under (with headroom) before going finer
+constexpr unsigned kFramesToCoarsen = 2;
+constexpr unsigned kFramesToRefine = 60;
+constexpr float kHeadroom = 0.8f;
+
+// moving average weight of the latest measurement
+constexpr float kSmoothing = 0.1f;
+
+static bool s_enabled = true;
+
+// function-local so it's there before any (static) governor registers
+static std::vector<const FxGovernor *> &Governors()
+{
+	static std::vector<const FxGovernor *> governors;
+	return governors;
+}
+
+void FxGovernor_Enable(bool enable)
+{
+	s_enabled = enable;
+}
+
+uint64_t FxGovernor_GetLevels()
+{
+	static_assert(kNumFxMapRes <= 4);
+
+	if (false == s_enabled)
+		return 0;
+
+	uint64_t levels = 0;
+	for (size_t iGovernor = 0; iGovernor < Governors().size(); ++iGovernor)
+		levels |= uint64_t(Governors()[iGovernor]->GetLevel()) << (iGovernor*2);
+
+	return levels;
+}
+
+FxGovernor::FxGovernor(const char *name, float budgetMS /* = kDefaultBudgetMS */) :
+	m_name(name), m_budget(budgetMS)
+{
+	VIZ_ASSERT(Governors().size() < 32);
+	Governors().push_back(this);
+}
+
+CKD_INLINE static float NumPixels(unsigned level)
+{
+	return float(g_fxMapRes[level].resX*g_fxMapRes[level].resY);
+}
+
+float FxGovernor::Predict(unsigned level) const
+{
+	return m_nsPerPixel*NumPixels(level)*1e-6f;
+}
+
+const FxMapRes &FxGovernor::Begin(bool allowScaling /* = true */)
+{
+	m_pRes = &g_fxMapRes[(true == allowScaling && true == s_enabled) ? m_level : 0];
+	m_start = omp_get_wtime();
+	return *m_pRes;
+}
+
+void FxGovernor::End()
+{
+	VIZ_ASSERT(nullptr != m_pRes);
+
+	const float elapsed = float(omp_get_wtime()-m_start)*1000.f;
+	const float nsPerPixel = elapsed*1e6f/NumPixels(m_pRes->level);
+	m_nsPerPixel = (0.f == m_nsPerPixel) ? nsPerPixel : lerpf(m_nsPerPixel, nsPerPixel, kSmoothing);
+
+	if (Predict(m_level) > m_budget)
+	{
+		m_framesUnder = 0;
+		if (++m_framesOver >= kFramesToCoarsen)
+		{
+			// straight to the finest level that fits (or the coarsest we've got)
+			while (m_level < kNumFxMapRes-1 && Predict(m_level) > m_budget)
+				++m_level;
+
+			m_framesOver = 0;
+		}
+	}
+	else if (m_level > 0 && Predict(m_level-1) < m_budget*kHeadroom)
+	{
+		m_framesOver = 0;
+		if (++m_framesUnder >= kFramesToRefine)
+		{
+			--m_level;
+			m_framesUnder = 0;
+		}
+	}
+	else
+		m_framesOver = m_framesUnder = 0;
+
+#if !defined(SYNC_PLAYER)
+	if (true == ImGuiIsVisible())
+	{
+		ImGui::Text("%s: %.2fms at 1/%.1f (%ux%u), next: 1/%.1f", m_name, elapsed, m_pRes->div, m_pRes->resX, m_pRes->resY, g_fxMapRes[m_level].div);
+	}
+#endif
+
+	m_pRes = nullptr;
+}
@@ -0,0 +1,59 @@
+// cookiedough -- dynamic resolution governor for (expensive) Fx map effects
+
+/*
+	One per part: it measures how long rendering the map takes and picks the map resolution (g_fxMapRes[], see
+	fx-blitter.h) for the next frame so that it fits the budget, which keeps the heavy ray marchers at frame rate on
+	slower machines at the cost of a blurrier image.
+
+	{
+		const FxMapRes &res = s_governor.Begin();
+		RenderMap(g_pFxMap[0], time, res);
+		s_governor.End();
+
+		Fx_Blit(pDest, g_pFxMap[0], res);
+	}
+
+	- cost is tracked per pixel, so the cost at any other level can be predicted
+	- going coarser happens within a couple of frames, going finer only after a while with room to spare (hysteresis),
+	  so the resolution doesn't flicker
+	- pass false to Begin() if the part can't deal with anything but g_fxMapRes[0] at that point (it still measures)
+	- FxGovernor_Enable(false) pins all governors to g_fxMapRes[0], for when output must not depend on timing (captures)
+	- FxGovernor_GetLevels() tells which levels the next frame will be rendered at (e.g. to key cached frames with)
+*/
+
+#pragma once
+
+#include "fx-blitter.h"
+
+void FxGovernor_Enable(bool enable);
+
+// level of each governor (2 bits apiece, in order of construction) as Begin() would pick it right now
+uint64_t FxGovernor_GetLevels();
+
+class FxGovernor
+{
+public:
+	// registers itself, so construct (as a static) once per part
+	FxGovernor(const char *name, float budgetMS = kDefaultBudgetMS);
+
+	const FxMapRes &Begin(bool allowScaling = true);
+	void End();
+
+	// roughly 60% of a 60Hz frame, leaves room for blits, blends and overlays
+	static constexpr float kDefaultBudgetMS = 10.f;
+
+	unsigned GetLevel() const { return m_level; }
+
+private:
+	float Predict(unsigned level) const;
+
+	const char *m_name;
+	const float m_budget;
+
+	unsigned m_level = 0;
+	const FxMapRes *m_pRes = nullptr;
+	double m_start = 0.0;
+
+	float m_nsPerPixel = 0.f; // moving average, zero until first measurement
+	unsigned m_framesOver = 0, m_framesUnder = 0;
+};
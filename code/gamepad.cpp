@@ -6,6 +6,7 @@
 #include "gamepad.h"
 
 static SDL_GameController *s_pPad = nullptr;
+static bool s_enabled = true;
 
 void Gamepad_Create()
 {
@@ -41,6 +42,9 @@ bool Gamepad_Update(PadState &state)
 	// small courtesy so you don't really have to check
 	memset(&state, 0, sizeof(PadState));
 
+	if (false == s_enabled)
+		return false;
+
 	if (nullptr != s_pPad)
 	{
 		SDL_GameControllerUpdate();
@@ -84,3 +88,7 @@ bool Gamepad_Update(PadState &state)
 	return false;
 }
 
+void Gamepad_Enable(bool enable)
+{
+	s_enabled = enable;
+}
@@ -21,3 +21,6 @@ struct PadState
 };
 
 bool Gamepad_Update(PadState &state);
+
+// disabled, Gamepad_Update() acts as if there's no pad (for when output must not depend on input, e.g. render farm workers)
+void Gamepad_Enable(bool enable);
@@ -2,6 +2,8 @@
 // cookiedough -- image loader
 
 #include "main.h"
+#include "alloc-large.h"
+#include "bilinear.h"
 
 // FIXME: lazily using the 1.7.8 x64 header for all platforms for now
 #include "../3rdparty/DevIL-SDK-x64-1.7.8/include/IL/il.h"
@@ -25,10 +27,10 @@ bool Image_Create()
 void Image_Destroy() 
 {
 	for (auto* pImage : s_pGC)
-		freeAligned(pImage);
+		freeLarge(pImage);
 }
 
-static void *Image_Load(const std::string &path, bool isGrayscale, unsigned *pNumPixels = nullptr, bool noGC = false)
+static void *Image_Load(const std::string &path, bool isGrayscale, unsigned *pNumPixels = nullptr, bool noGC = false, unsigned *pResX = nullptr, unsigned *pResY = nullptr)
 {
 	ILuint image;
 	ilGenImages(1, &image);
@@ -49,14 +51,14 @@ static void *Image_Load(const std::string &path, bool isGrayscale, unsigned *pNu
 	if (!isGrayscale)
 	{
 		// load as 32-bit ARGB
-		pPixels = mallocAligned(width*height*sizeof(uint32_t), kAlignTo);
+		pPixels = mallocLarge(width*height*sizeof(uint32_t), "images");
 		ilConvertImage(IL_BGRA, IL_UNSIGNED_BYTE);
 		ilCopyPixels(0, 0, 0, width, height, 1, IL_BGRA, IL_UNSIGNED_BYTE, pPixels);
 	}
 	else
 	{
 		// load as 8-bit grayscale
-		pPixels = mallocAligned(width*height, kAlignTo);
+		pPixels = mallocLarge(width*height, "images");
 		ilConvertImage(IL_LUMINANCE, IL_UNSIGNED_BYTE);
 		ilCopyPixels(0, 0, 0, width, height, 1, IL_LUMINANCE, IL_UNSIGNED_BYTE, pPixels);
 	}
@@ -69,6 +71,12 @@ static void *Image_Load(const std::string &path, bool isGrayscale, unsigned *pNu
 	if (nullptr != pNumPixels)
 		*pNumPixels = width*height;
 
+	if (nullptr != pResX)
+		*pResX = width;
+
+	if (nullptr != pResY)
+		*pResY = height;
+
 	return pPixels;
 }
 
@@ -103,7 +111,131 @@ uint32_t *Image_Load32_CA(const std::string &pathC, const std::string &pathA)
 		pColor[iPixel] = (pColor[iPixel] & 0xffffff) | (pAlpha[iPixel] & 0xff)<<24;
 	}
 
-	freeAligned(pAlpha);
+	freeLarge(pAlpha);
 
 	return pColor;
 }
+
+// bilinear resize (pixel centers line up, edges are clamped), returns a new buffer that isn't collected
+static uint32_t *Resize32(const uint32_t *pSrc, unsigned srcResX, unsigned srcResY, unsigned destResX, unsigned destResY)
+{
+	VIZ_ASSERT(srcResX > 0 && srcResY > 0);
+
+	uint32_t *pDest = static_cast<uint32_t *>(mallocLarge(size_t(destResX)*destResY*sizeof(uint32_t), "images"));
+
+	const float stepX = float(srcResX)/destResX;
+	const float stepY = float(srcResY)/destResY;
+
+	#pragma omp parallel for schedule(static)
+	for (int iY = 0; iY < int(destResY); ++iY)
+	{
+		const int V = ftofp24(std::clamp((iY+0.5f)*stepY - 0.5f, 0.f, srcResY-1.f));
+		const unsigned V0 = unsigned(V >> 8);
+		const unsigned V1 = std::min(V0+1, srcResY-1);
+		const unsigned fracV = (V & 0xff) * 0x01010101;
+
+		uint32_t *pDestRow = pDest + size_t(iY)*destResX;
+		for (unsigned iX = 0; iX < destResX; ++iX)
+		{
+			const int U = ftofp24(std::clamp((iX+0.5f)*stepX - 0.5f, 0.f, srcResX-1.f));
+			const unsigned U0 = unsigned(U >> 8);
+			const unsigned U1 = std::min(U0+1, srcResX-1);
+			const unsigned fracU = (U & 0xff) * 0x01010101;
+
+			pDestRow[iX] = v2cISSE32(bsamp32_32(pSrc, U0, V0*srcResX, U1, V1*srcResX, fracU, fracV));
+		}
+	}
+
+	return pDest;
+}
+
+// loads 32-bit image at 'resX'*'resY' or, if zero, scaled by g_resScale (returns it's size), not collected
+static uint32_t *Image_Load32_Scaled(const std::string &path, unsigned &resX, unsigned &resY)
+{
+	unsigned srcResX, srcResY;
+	uint32_t *pPixels = static_cast<uint32_t *>(Image_Load(path, false, nullptr, true, &srcResX, &srcResY));
+	if (nullptr == pPixels)
+		return nullptr;
+
+	if (0 == resX || 0 == resY)
+	{
+		resX = unsigned(ToRes(int(srcResX)));
+		resY = unsigned(ToRes(int(srcResY)));
+	}
+
+	if (resX != srcResX || resY != srcResY)
+	{
+		uint32_t *pScaled = Resize32(pPixels, srcResX, srcResY, resX, resY);
+		freeLarge(pPixels);
+		pPixels = pScaled;
+	}
+
+	return pPixels;
+}
+
+uint32_t *Image_Load32_Res(const std::string &path)
+{
+	unsigned resX = 0, resY = 0;
+	uint32_t *pPixels = Image_Load32_Scaled(path, resX, resY);
+	if (nullptr != pPixels)
+		s_pGC.push_back(pPixels);
+
+	return pPixels;
+}
+
+uint32_t *Image_Load32_Size(const std::string &path, unsigned resX, unsigned resY)
+{
+	VIZ_ASSERT(resX > 0 && resY > 0);
+
+	uint32_t *pPixels = Image_Load32_Scaled(path, resX, resY);
+	if (nullptr != pPixels)
+		s_pGC.push_back(pPixels);
+
+	return pPixels;
+}
+
+uint32_t *Image_Load32_Crop(const std::string &path, Rect &rect)
+{
+	// load full (scaled) image (disposed of below)
+	unsigned resX = 0, resY = 0;
+	uint32_t *pFull = Image_Load32_Scaled(path, resX, resY);
+	if (nullptr == pFull)
+		return nullptr;
+
+	// find bounding box of non-transparent pixels
+	unsigned minX = resX, minY = resY, maxX = 0, maxY = 0;
+	for (unsigned iY = 0; iY < resY; ++iY)
+	{
+		const uint32_t *pLine = pFull + iY*resX;
+		for (unsigned iX = 0; iX < resX; ++iX)
+		{
+			if (0 != (pLine[iX] >> 24))
+			{
+				minX = std::min(minX, iX);
+				maxX = std::max(maxX, iX);
+				minY = std::min(minY, iY);
+				maxY = std::max(maxY, iY);
+			}
+		}
+	}
+
+	if (minX > maxX)
+	{
+		// entirely transparent: empty rectangle (blends will do nothing)
+		rect = { 0, 0, 0, 0 };
+	}
+	else
+		rect = { minX, minY, maxX-minX+1, maxY-minY+1 };
+
+	// copy bounding box (at least one pixel is allocated)
+	const size_t numPixels = std::max<size_t>(1, rect.resX*rect.resY);
+	uint32_t *pCropped = static_cast<uint32_t *>(mallocLarge(numPixels*sizeof(uint32_t), "images"));
+	for (unsigned iY = 0; iY < rect.resY; ++iY)
+		memcpy(pCropped + iY*rect.resX, pFull + RectOffset(rect, resX) + iY*resX, rect.resX*sizeof(uint32_t));
+
+	freeLarge(pFull);
+
+	s_pGC.push_back(pCropped);
+
+	return pCropped;
+}
@@ -15,4 +15,16 @@ uint8_t *Image_Load8(const std::string &path);
 // ** expects the alpha image to be a regular RGB JPEG **
 uint32_t *Image_Load32_CA(const std::string &pathC, const std::string &pathA);
 
+// loads 32-bit image authored at kAuthorResX*kAuthorResY and scales it (bilinear) to the production resolution,
+// i.e. by g_resScale (see main.h), use this for anything that's laid out on screen (overlays, logos, sprites)
+uint32_t *Image_Load32_Res(const std::string &path);
+
+// loads 32-bit image scaled (bilinear) to 'resX'*'resY', for maps made for a buffer of that size
+uint32_t *Image_Load32_Size(const std::string &path, unsigned resX, unsigned resY);
+
+// loads 32-bit image (like Image_Load32_Res()) cropped to it's non-transparent (alpha > 0) bounding box
+// - 'rect' receives the position and size of the box within the (scaled) image
+// - use with the ...R() blends (util.h) so only the part of the screen that is actually covered is touched
+uint32_t *Image_Load32_Crop(const std::string &path, Rect &rect);
+
 #endif // _IMAGE_H_
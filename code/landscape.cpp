@@ -2,7 +2,7 @@
 // cookiedough -- voxel landscape
 
 #include "main.h"
-// #include "landscape.h"
+#include "landscape.h"
 #include "image.h"
 #include "cspan.h"
 #include "bilinear.h"
@@ -28,7 +28,7 @@ SyncTrack trackWarpSpeed, trackWarpStrength;
 
 // -- voxel renderer --
 
-// adjust to map (FIXME: parametrize, document)
+// adjust to map (FIXME: parametrize, document), tilt & scale are in pixels (see ToRes())
 constexpr float kMapViewLenScale = kAspect*(kPI*0.1f);
 // constexpr int kMapViewHeight = 100;
 constexpr int kMapTilt = 90;
@@ -43,7 +43,8 @@ constexpr unsigned kMapShift = 10;
 // trace depth
 const unsigned int kRayLength = 512;
 
-static int s_mapTilt = kMapTilt;
+// pad input, integrated over frames (see landscape.h)
+static VoxelScapeState s_state;
 
 // sample height (filtered)
 VIZ_INLINE unsigned int vscape_shf(int U, int V)
@@ -53,10 +54,10 @@ VIZ_INLINE unsigned int vscape_shf(int U, int V)
 	return bsamp8(s_pHeightMap, U0, V0, U1, V1, fracU, fracV);
 }
 
-static void vscape_ray(uint32_t *pDest, int curX, int curY, int dX, int dY, float fishMul)
+static void vscape_ray(uint32_t *pDest, int curX, int curY, int dX, int dY, float fishMul, int mapTilt, int mapScale)
 {
-	int lastHeight = kResY;
-	int lastDrawnHeight = kResY;
+	int lastHeight = g_resY;
+	int lastDrawnHeight = g_resY;
 
 	const unsigned int U = (curX>>8) & kMapAnd, V = ((curY>>8) & kMapAnd) << kMapShift;
 	__m128i lastColor = c2vISSE16(s_pColorMap[U|V]);
@@ -86,9 +87,9 @@ static void vscape_ray(uint32_t *pDest, int curX, int curY, int dX, int dY, floa
 		int height = 255-mapHeight;		
 		height <<= 16;
 		height /= fpFishMul*(iStep+1);
-		height *= kMapScale;
+		height *= mapScale;
 		height >>= 8;
-		height += s_mapTilt;
+		height += mapTilt;
 
 		VIZ_ASSERT(height >= 0);
 
@@ -97,7 +98,7 @@ static void vscape_ray(uint32_t *pDest, int curX, int curY, int dX, int dY, floa
 		{
 			// draw span (vertical)
 			const unsigned int drawLength = lastDrawnHeight - height;
-			cspanISSE16(pDest + height*kResX, kResX, lastHeight - height, drawLength, color, lastColor);
+			cspanISSE16(pDest + height*g_resX, g_resX, lastHeight - height, drawLength, color, lastColor);
 			lastDrawnHeight = height;
 		}
 
@@ -106,74 +107,80 @@ static void vscape_ray(uint32_t *pDest, int curX, int curY, int dX, int dY, floa
 	}
 }
 
-static void vscape(uint32_t *pDest, float time, float delta)
+// integrates pad input (only) into the state
+static void vscape_update(VoxelScapeState &state, float delta)
 {
 	// grab gamepad input
 	PadState pad;
 	Gamepad_Update(pad);
 
-	// tilt (pad & sync.)
-	static float padTilt = 0.f;
+	// tilt
 	const float tiltStep = std::min(delta, 1.f);
-	if (padTilt < kMaxTiltDiff && pad.rightY > 0.f)
-		padTilt += tiltStep;
-	if (padTilt > -kMaxTiltDiff && pad.rightY < 0.f)
-		padTilt -= tiltStep;
-
-	const float tilt = clampf(-kMaxTiltDiff, kMaxTiltDiff, Rocket::getf(trackVoxelScapeTilt) + padTilt);
-	s_mapTilt = kMapTilt + int(tilt);
+	if (state.padTilt < kMaxTiltDiff && pad.rightY > 0.f)
+		state.padTilt += tiltStep;
+	if (state.padTilt > -kMaxTiltDiff && pad.rightY < 0.f)
+		state.padTilt -= tiltStep;
 
-	// calc. view angle + it's sine & cosine
-	static float viewAngle = 0.f;
+	// view angle
 //	constexpr float maxAng = kPI*2.f;
 	float viewMul = 1.f/kAspect;
 	viewMul *= delta*0.01f;
-//	if (viewAngle < maxAng)
-		viewAngle += viewMul*pad.lShoulder;
-//	if (viewAngle > -maxAng)
-		viewAngle -= viewMul*pad.rShoulder;
+//	if (state.viewAngle < maxAng)
+		state.viewAngle += viewMul*pad.lShoulder;
+//	if (state.viewAngle > -maxAng)
+		state.viewAngle -= viewMul*pad.rShoulder;
 
-	const float viewCos = cosf(viewAngle);
-	const float viewSin = sinf(viewAngle);
+	const float viewCos = cosf(state.viewAngle);
+	const float viewSin = sinf(state.viewAngle);
 
 	// strafe
-	static float strafeX = 0.f;
-	static float strafeY = 0.f;
 	if (pad.rightX != 0.f)
 	{
 		const float strafe = pad.rightX*delta;
-		strafeX += viewCos*strafe;
-		strafeY += viewSin*strafe;
+		state.strafeX += viewCos*strafe;
+		state.strafeY += viewSin*strafe;
 	}
 
-	// move (pad & sync.)
-	static float padMoveX = 0.f;
-	static float padMoveY = 0.f;
+	// move
 	const float padMove = (pad.leftY != 0.f) ? -pad.leftY*delta : 0.f;
-	padMoveX += -viewSin*padMove;
-	padMoveY +=  viewCos*padMove;
-	
+	state.padMoveX += -viewSin*padMove;
+	state.padMoveY +=  viewCos*padMove;
+}
+
+// a function of state and sync. only
+static void vscape(uint32_t *pDest, const VoxelScapeState &state)
+{
+	// tilt (pad & sync.)
+	const float tilt = clampf(-kMaxTiltDiff, kMaxTiltDiff, Rocket::getf(trackVoxelScapeTilt) + state.padTilt);
+	const int mapTilt = ToRes(kMapTilt + int(tilt));
+	const int mapScale = ToRes(kMapScale);
+
+	// view angle sine & cosine
+	const float viewCos = cosf(state.viewAngle);
+	const float viewSin = sinf(state.viewAngle);
+
+	// move (pad & sync.)
 	const float syncvMoveFwd = Rocket::getf(trackVoxelScapeForward);
 	float moveX = -viewSin*syncvMoveFwd;
 	float moveY =  viewCos*syncvMoveFwd;
 
-	moveX += padMoveX;
-	moveY += padMoveY;
+	moveX += state.padMoveX;
+	moveY += state.padMoveY;
 
 	// origin
-	float X1 = moveX+strafeX;
-	float Y1 = moveY+strafeY;
+	float X1 = moveX+state.strafeX;
+	float Y1 = moveY+state.strafeY;
 	const int fpX1 = ftofp24(X1);
 	const int fpY1 = ftofp24(Y1);
 
 	constexpr float rayY = kMapSize*kMapViewLenScale;
 
 	#pragma omp parallel for schedule(static)
-	for (unsigned iRay = 0; iRay < kResX; ++iRay)
+	for (unsigned iRay = 0; iRay < g_resX; ++iRay)
 	{
 		// FIXME: subpixel accuracy adj.
 
-		const float rayX = 0.25f*(iRay - kResX*0.5f); // FIXME: parameter?
+		const float rayX = (0.25f/g_resScale)*(iRay - g_resX*0.5f); // FIXME: parameter?
 
 		// FIXME: simplify
 		float rotRayX = rayX, rotRayY = rayY;
@@ -187,7 +194,7 @@ static void vscape(uint32_t *pDest, float time, float delta)
 		// counteract fisheye effect
 		/* const */ float fishMul = rayY / sqrtf(rotRayX*rotRayX + rotRayY*rotRayY);
 	
-		vscape_ray(pDest+iRay, fpX1, fpY1, ftofp24(dX), ftofp24(dY), fishMul);
+		vscape_ray(pDest+iRay, fpX1, fpY1, ftofp24(dX), ftofp24(dY), fishMul, mapTilt, mapScale);
 	}
 }
 
@@ -235,9 +242,20 @@ void Landscape_Draw(uint32_t *pDest, float time, float delta)
 		: pDest;
 
 	// render landscape
-	memset32(pWrite, s_pFogGradient[0], kResX*kResY);
-	vscape(pWrite, time, delta);
+	vscape_update(s_state, delta);
+	memset32(pWrite, s_pFogGradient[0], g_resX*g_resY);
+	vscape(pWrite, s_state);
 
 	if (true == warp)
-		TapeWarp32(pDest, pWrite, kResX, kResY, Rocket::getf(trackWarpSpeed), warpStrength);
+		TapeWarp32(pDest, pWrite, g_resX, g_resY, Rocket::getf(trackWarpSpeed), warpStrength);
+}
+
+VoxelScapeState Landscape_GetState()
+{
+	return s_state;
+}
+
+void Landscape_SetState(const VoxelScapeState &state)
+{
+	s_state = state;
 }
@@ -8,4 +8,18 @@ bool Landscape_Create();
 void Landscape_Destroy();
 void Landscape_Draw(uint32_t *pDest, float time, float delta);
 
+// all that Landscape_Draw() carries over from one frame to the next: gamepad input integrated over time
+// - without input it's all zero and a frame depends on sync. only
+// - snapshot & restore to render frames out of order
+struct VoxelScapeState
+{
+	float padTilt = 0.f;
+	float viewAngle = 0.f;
+	float strafeX = 0.f, strafeY = 0.f;
+	float padMoveX = 0.f, padMoveY = 0.f;
+};
+
+VoxelScapeState Landscape_GetState();
+void Landscape_SetState(const VoxelScapeState &state);
+
 #endif // _LANDSCAPE_H_
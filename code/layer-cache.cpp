@@ -0,0 +1,166 @@
+// cookiedough -- derived layer cache (memoized blends, blurs et cetera)
+
+#include "main.h"
+#include "alloc-large.h"
+#include "layer-cache.h"
+
+#include <list>
+#include <unordered_map>
+
+// FNV-1a (on 64-bit words)
+constexpr uint64_t kHashBasis = 14695981039346656037ull;
+constexpr uint64_t kHashPrime = 1099511628211ull;
+
+LayerKey::LayerKey(const char *operation) :
+	m_hash(kHashBasis)
+{
+	// by name, not by address (identical string literals aren't guaranteed to be merged)
+	uint64_t nameHash = kHashBasis;
+	for (const char *pChar = operation; 0 != *pChar; ++pChar)
+		nameHash = (nameHash ^ uint8_t(*pChar)) * kHashPrime;
+
+	Add(nameHash);
+}
+
+LayerKey &LayerKey::Source(const void *pSource)
+{
+	Add(uint64_t(reinterpret_cast<uintptr_t>(pSource)));
+	return *this;
+}
+
+LayerKey &LayerKey::Source(const LayerKey &source)
+{
+	for (uint64_t word : source.m_words)
+		Add(word);
+
+	return *this;
+}
+
+LayerKey &LayerKey::Param(int value)
+{
+	Add(uint64_t(int64_t(value)));
+	return *this;
+}
+
+void LayerKey::Add(uint64_t word)
+{
+	m_words.push_back(word);
+	m_hash = (m_hash ^ word) * kHashPrime;
+}
+
+struct Layer
+{
+	LayerKey key;
+	size_t bytes;
+	uint32_t *pPixels;
+	unsigned lastFrame;
+};
+
+// front is most recently used
+static std::list<Layer> s_layers;
+static std::unordered_multimap<uint64_t, std::list<Layer>::iterator> s_index;
+
+static size_t s_budget = 0, s_numBytes = 0;
+static unsigned s_frame = 0;
+static size_t s_numHits = 0, s_numBuilds = 0;
+
+static void Unindex(std::list<Layer>::iterator iLayer)
+{
+	auto range = s_index.equal_range(iLayer->key.GetHash());
+	for (auto iEntry = range.first; iEntry != range.second; ++iEntry)
+	{
+		if (iEntry->second == iLayer)
+		{
+			s_index.erase(iEntry);
+			break;
+		}
+	}
+}
+
+bool LayerCache_Create(size_t budget)
+{
+	s_budget = budget;
+	return true;
+}
+
+void LayerCache_Destroy()
+{
+	for (Layer &layer : s_layers)
+		freeLarge(layer.pPixels);
+
+	s_layers.clear();
+	s_index.clear();
+	s_numBytes = 0;
+}
+
+void LayerCache_NewFrame()
+{
+	++s_frame;
+}
+
+// evicts least recently used layers (not in use this frame) until 'bytes' fit, and returns a buffer of that size if
+// it came across one, so it doesn't have to be freed and allocated again
+static uint32_t *Evict(size_t bytes)
+{
+	while (s_numBytes + bytes > s_budget && false == s_layers.empty())
+	{
+		const auto iLast = std::prev(s_layers.end());
+		if (s_frame == iLast->lastFrame)
+			break; // the rest is in use too
+
+		uint32_t *pPixels = iLast->pPixels;
+		const size_t lastBytes = iLast->bytes;
+
+		Unindex(iLast);
+		s_layers.erase(iLast);
+		s_numBytes -= lastBytes;
+
+		if (bytes == lastBytes)
+			return pPixels;
+
+		freeLarge(pPixels);
+	}
+
+	return nullptr;
+}
+
+const uint32_t *LayerCache_Get(const LayerKey &key, unsigned resX, unsigned resY, const std::function<void(uint32_t *pDest)> &build)
+{
+	const size_t bytes = size_t(resX)*resY*sizeof(uint32_t);
+
+	auto range = s_index.equal_range(key.GetHash());
+	for (auto iEntry = range.first; iEntry != range.second; ++iEntry)
+	{
+		const auto iLayer = iEntry->second;
+		if (iLayer->key == key && iLayer->bytes == bytes)
+		{
+			// move to front
+			s_layers.splice(s_layers.begin(), s_layers, iLayer);
+			iLayer->lastFrame = s_frame;
+
+			++s_numHits;
+			return iLayer->pPixels;
+		}
+	}
+
+	uint32_t *pPixels = Evict(bytes);
+	if (nullptr == pPixels)
+		pPixels = static_cast<uint32_t*>(mallocLarge(bytes, "layer cache"));
+
+	build(pPixels);
+
+	s_layers.push_front({ key, bytes, pPixels, s_frame });
+	s_index.emplace(key.GetHash(), s_layers.begin());
+	s_numBytes += bytes;
+
+	++s_numBuilds;
+	return pPixels;
+}
+
+void LayerCache_ShowStats()
+{
+#if !defined(SYNC_PLAYER)
+	if (true == ImGuiIsVisible())
+		ImGui::Text("Layer cache: %zu layer(s), %.1f/%.1fMB, %zu hits, %zu builds", s_layers.size(), s_numBytes/(1024.f*1024.f), s_budget/(1024.f*1024.f), s_numHits, s_numBuilds);
+#endif
+}
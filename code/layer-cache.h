@@ -0,0 +1,56 @@
+// cookiedough -- derived layer cache (memoized blends, blurs et cetera)
+
+/*
+	Lots of layers are derived from static images by an operation with a few sync. parameters (blend 2 logos, blur a
+	credit) and those parameters only change on a fraction of frames; instead of rebuilding them every frame:
+
+	LayerKey key("credit blur");
+	key.Source(pLogo).Param(BoxBlurSpan(strength));
+
+	const uint32_t *pLayer = LayerCache_Get(key, kCredX, kCredY, [&](uint32_t *pDest) {
+		HorizontalBoxBlur32(pDest, pLogo, kCredX, kCredY, strength);
+	});
+
+	- key on parameters quantized to what the operation actually uses (e.g. the kernel span instead of the blur
+	  strength, the 8-bit factor instead of the float), so a cached layer is identical to a rebuilt one
+	- sources are keyed by address, so they must be static (images loaded at start); to derive from another cached
+	  layer pass it's key instead
+	- layers stay valid until the next LayerCache_NewFrame(); least recently used ones go first when memory runs out,
+	  but never the ones in use this frame (so it may exceed it's budget for a frame)
+	- not thread-safe (use it from the main/render thread, outside parallel regions)
+*/
+
+#pragma once
+
+#include <functional>
+
+class LayerKey
+{
+public:
+	explicit LayerKey(const char *operation);
+
+	LayerKey &Source(const void *pSource);
+	LayerKey &Source(const LayerKey &source); // for layers derived from cached layers (their address may be recycled)
+	LayerKey &Param(int value);
+
+	uint64_t GetHash() const { return m_hash; }
+	bool operator==(const LayerKey &key) const { return m_words == key.m_words; }
+
+private:
+	void Add(uint64_t word);
+
+	uint64_t m_hash;
+	std::vector<uint64_t> m_words; // to tell apart keys that share a hash
+};
+
+bool LayerCache_Create(size_t budget);
+void LayerCache_Destroy();
+
+// call at the top of each frame
+void LayerCache_NewFrame();
+
+// returns cached layer, or builds it (by calling 'build' with a buffer of 'resX' by 'resY' pixels) first
+const uint32_t *LayerCache_Get(const LayerKey &key, unsigned resX, unsigned resY, const std::function<void(uint32_t *pDest)> &build);
+
+// ImGui statistics
+void LayerCache_ShowStats();
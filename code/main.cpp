@@ -67,7 +67,8 @@
 // - executables are built to target/<arch> -- run from that directory!
 // - keep DLLs (for Windows, see above) up to date for each build
 // - (almost) always include main.h on top
-// - there's kResX/kResY and soforth telling you about the size of the output buffer
+// - there's g_resX/g_resY and soforth telling you about the size of the output buffer (picked at startup, see output.h)
+// - sizes and offsets in pixels are authored at 1280x720 (kAuthorResX/kAuthorResY), run them through ToRes()
 // - for other targets there are likewise constants
 // - the delta time is in MS so it can be sensibly applied to for example gamepad axis values
 // - could probably be using more streamed (WC) writes, but pick those battles carefully
@@ -80,7 +81,11 @@
 //   + module rows-per-pattern in audio.cpp  
 //   + module playback flags in audio.cpp
 // - stream playback details, also: audio.cpp
-// - main resolution in main.h (adjust target and effect map sizes in shared-resources.h and fx-blitter.h)
+// - supported resolutions in main.h (target and effect map sizes follow, see shared-resources.h and fx-blitter.h)
+// - output resolution can be picked on the command line (e.g. 'cookiedough 1920x1080'), see output.h
+// - to capture video pass '-y4m <path>' on the command line, see capture.h
+// - to spread a capture over multiple processes pass '-farm <N>' as well, see render-farm.h
+// - to cache frames while scrubbing in the editor pass '-frame-cache <MB>', see frame-cache.h
 // - when writing code that depends on a certain resolution it's wise to put a static_assert() along with it
 // - to enable playback mode (Rocket): rocket.h
 
@@ -92,8 +97,10 @@
 // define FPS_WARNING
 
 #include "main.h" // always include first!
+#include "alloc-large.h"
 
 #include <filesystem> // FIXME: might only be necessary for OSX
+#include <chrono>
 
 #if defined(_WIN32)
 	#include <windows.h>
@@ -104,6 +111,7 @@
 #include "../3rdparty/SDL2-2.28.5/include/SDL.h"
 
 #include "display.h"
+#include "triple-buffer.h"
 #include "timer.h"
 #include "image.h"
 #include "audio.h"
@@ -115,6 +123,11 @@
 #include "polar.h"
 #include "fx-blitter.h"
 #include "boxblur.h"
+#include "target-pool.h"
+#include "output.h"
+#include "capture.h"
+#include "render-farm.h"
+#include "frame-cache.h"
 
 // -- debug, display & audio config. --
 
@@ -125,6 +138,9 @@ static const char *kStream = "assets/audio/comatron - to the moon - final.wav";
 // when you're working on anything else than synchronization/demonstration
 constexpr bool kSilent = false; 
 
+// frame rate of '-y4m' captures (frames are captured as presented, so make sure you're hitting it)
+constexpr unsigned kCaptureFPS = 60;
+
 // enable this to receive derogatory comments
 // #define DISPLAY_AVG_FPS
 
@@ -209,6 +225,121 @@ static bool HandleEvents()
 	return true;
 }
 
+// -- pipelined rendering --
+
+/*
+	Demo_Draw() runs on it's own thread while the main thread handles events and presents, so the OpenMP team
+	doesn't sit idle during the texture upload & vertical sync and vice versa; finished frames are handed over
+	through a triple buffer, and the render thread is never more than a single frame ahead
+
+	can't be used along with ImGui, since that's bound to the main thread
+*/
+
+#if defined(SYNC_PLAYER)
+	constexpr bool kPipelined = true;
+#else
+	constexpr bool kPipelined = kFullScreen;
+#endif
+
+struct Frame
+{
+	uint32_t *pPixels = nullptr;
+	float audioTime = 0.f; // audio clock at submission (i.e. what Demo_Draw() rendered)
+};
+
+// returns number of frames presented (and total time spent, and avg. latency from submission to presentation)
+static size_t RunPipelined(Display &display, float &totTime, float &avgLatency)
+{
+	constexpr size_t kNumFrames = 3;
+
+	uint32_t *pBuffers[kNumFrames];
+	for (auto &pBuffer : pBuffers)
+	{
+		pBuffer = static_cast<uint32_t*>(mallocLarge(Output_GetBytes(), "frame buffers"));
+		memset32(pBuffer, 0, Output_GetSize());
+	}
+
+	TripleBuffer<Frame> frames;
+	std::atomic<bool> stop = false, done = false;
+
+	std::thread renderThread([&]()
+	{
+		Timer timer;
+
+		size_t numAssigned = 0;
+		float oldTime = 0.f, newTime = 0.f;
+		while (false == stop)
+		{
+			oldTime = newTime;
+			newTime = timer.Get();
+			const float delta = newTime-oldTime; // base delta on sys. time
+
+			// each of the 3 slots gets it's own buffer the first time around
+			Frame &frame = frames.Back();
+			if (nullptr == frame.pPixels)
+				frame.pPixels = pBuffers[numAssigned++];
+
+			frame.audioTime = Audio_Get_Pos_In_Sec();
+			if (false == Demo_Draw(frame.pPixels, frame.audioTime, delta * 100.f))
+				break; // Rocket track says we're done
+
+			Capture_Frame(frame.pPixels);
+
+			frames.WaitForFetch();
+			frames.Publish();
+		}
+
+		done = true;
+	});
+
+	Timer timer;
+
+	size_t numFrames = 0;
+	float latency = 0.f;
+	while (false == done && true == HandleEvents())
+	{
+		if (true == frames.Fetch())
+		{
+			const Frame &frame = frames.Front();
+			display.Update(frame.pPixels);
+
+			latency += Audio_Get_Pos_In_Sec()-frame.audioTime;
+			++numFrames;
+		}
+		else
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	totTime = timer.Get();
+	avgLatency = (0 != numFrames) ? latency/numFrames : 0.f;
+
+	// keep consuming until the render thread is out (it may be waiting for us)
+	stop = true;
+	while (false == done)
+	{
+		frames.Fetch();
+		std::this_thread::yield();
+	}
+
+	renderThread.join();
+
+	for (auto *pBuffer : pBuffers)
+		freeLarge(pBuffer);
+
+	return numFrames;
+}
+
+// picks up resolution if 'arg' reads like '1920x1080'
+static void ParseResolution(const char *arg, unsigned &resX, unsigned &resY)
+{
+	unsigned parsedX, parsedY;
+	if (2 == sscanf(arg, "%ux%u", &parsedX, &parsedY))
+	{
+		resX = parsedX;
+		resY = parsedY;
+	}
+}
+
 #if !defined(_WIN32)
 int main(int argc, char *argv[])
 #else
@@ -239,12 +370,64 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR cmdLine, int nCmdShow)
 		return 1;
 	}
 
-	// change path to target root (which is a dirty affair on Mac)
+	// command line:
+	// - output resolution, 1280x720 unless specified (see output.h)
+	// - '-y4m <path>' to capture to a YUV4MPEG2 file, or stdout if path is '-' (see capture.h)
+	// - '-farm <N>' to render said capture with N headless worker processes (see render-farm.h)
+	// - '-frame-cache <MB>' to keep rendered frames around for scrubbing in the editor (see frame-cache.h)
+	std::vector<std::string> args;
+#if !defined(_WIN32)
+	args.assign(argv+1, argv+argc);
+#else
+	args.assign(__argv+1, __argv+__argc); // already split (and unquoted) by the CRT
+#endif
+
+	unsigned outResX = kOutputModes[0].resX, outResY = kOutputModes[0].resY;
+	std::string capturePath;
+	unsigned numFarmWorkers = 0;
+	bool isFarmWorker = false;
+	FarmChunk farmChunk = {};
+	size_t frameCacheMB = 0;
+	for (size_t iArg = 0; iArg < args.size(); ++iArg)
+	{
+		if ("-y4m" == args[iArg] && iArg+1 < args.size())
+			capturePath = args[++iArg];
+		else if ("-farm" == args[iArg] && iArg+1 < args.size())
+			numFarmWorkers = unsigned(strtoul(args[++iArg].c_str(), nullptr, 10));
+		else if ("-frame-cache" == args[iArg] && iArg+1 < args.size())
+			frameCacheMB = size_t(strtoull(args[++iArg].c_str(), nullptr, 10));
+		else if (true == RenderFarm_ParseWorkerArgs(args, iArg, farmChunk))
+			isFarmWorker = true;
+		else
+			ParseResolution(args[iArg].c_str(), outResX, outResY);
+	}
+
+	if ((0 != numFarmWorkers || true == isFarmWorker) && true == capturePath.empty())
+	{
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, kTitle, "The render farm needs a capture to render to ('-y4m <path>').", nullptr);
+		return 1;
+	}
+
+	// before anything spins up an OpenMP team
+	if (true == isFarmWorker)
+		RenderFarm_PinWorker(farmChunk);
+
+	// before changing path, so a relative path is relative to where we were started from
+	if (false == capturePath.empty() && false == Capture_Create(capturePath, outResX, outResY, kCaptureFPS))
+	{
+		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, kTitle, s_lastErr.c_str(), nullptr);
+		return 1;
+	}
+
+	// change path to target root (which is a dirty affair on Mac), farm workers inherit it from the coordinator
+	if (false == isFarmWorker)
+	{
 #if defined(__APPLE__)
-	std::__fs::filesystem::current_path(OSX_GetExecutableDirectory() + "/..");
+		std::__fs::filesystem::current_path(OSX_GetExecutableDirectory() + "/..");
 #else // Windows and Linux
-    std::filesystem::current_path("..");
+		std::filesystem::current_path("..");
 #endif
+	}
 
 	printf("And today we'll be working from: %s\n", reinterpret_cast<const char *>(std::filesystem::current_path().c_str()));
 
@@ -272,92 +455,130 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR cmdLine, int nCmdShow)
 
 	bool utilInit = true;
 
+	// first, everything else is sized after it (and the Fx maps must be there before the polar tables)
+	utilInit &= Output_Create(outResX, outResY);
 	utilInit &= Image_Create();
 	utilInit &= Shared_Create();
-	utilInit &= Polar_Create();
 	utilInit &= FxBlitter_Create();
+	utilInit &= Polar_Create();
 	utilInit &= BoxBlur_Create();
+	utilInit &= TargetPool_Create();
+
+#if !defined(SYNC_PLAYER)
+	// opt-in, since it's a lot of memory at higher resolutions
+	utilInit &= FrameCache_Create(frameCacheMB*1024*1024);
+#endif
 
 	Gamepad_Create();
-	initialize_random_generator();
 
 	// utilInit &= Snatchtiler();
 
-	float avgFPS = 0.f;
+	float avgFPS = 0.f, avgLatency = 0.f;
 
 	if (utilInit && RunTests() /* just always run the functional tests, never want to run if they fail */)
 	{
 		if (Demo_Create())
 		{
-			HWND audioHWND = nullptr;
+			// on failure the farm sets the last error, which is reported (and exited on with 1) below
+			if (true == isFarmWorker)
+			{
+				if (false == RenderFarm_Work(farmChunk, kCaptureFPS) && true == s_lastErr.empty())
+					SetLastError("Render farm worker failed.");
+			}
+			else if (0 != numFarmWorkers)
+			{
+				const std::string resArg = std::to_string(outResX) + "x" + std::to_string(outResY);
+				if (false == RenderFarm_Coordinate(numFarmWorkers, kCaptureFPS, { resArg }))
+					SetLastError(s_lastErr + "\nCapture is incomplete: " + capturePath);
+				else
+					printf("Render farm: done, captured to: %s\n", capturePath.c_str());
+			}
+			else
+			{
+				HWND audioHWND = nullptr;
 
 #if defined(_WIN32)
-			audioHWND = GetForegroundWindow();
+				audioHWND = GetForegroundWindow();
 #endif
 
-			if (Audio_Create(-1, kStream, audioHWND, kSilent)) // FIXME: or is this just fine?
-			{
-				Display display;
-				if (display.Open(kTitle, kResX, kResY, kFullScreen))
+				if (Audio_Create(-1, kStream, audioHWND, kSilent)) // FIXME: or is this just fine?
 				{
-					if (true == kFullScreen)
-						SDL_ShowCursor(SDL_DISABLE);
-
-					// frame buffer
-					uint32_t* pDest = static_cast<uint32_t*>(mallocAligned(kOutputBytes, kAlignTo));
-					memset32(pDest, 0, kOutputSize);
-
-					Timer timer;
-
-					size_t numFrames = 0;
-					float oldTime = 0.f, newTime = 0.f, totTime = 0.f;
-					while (true == HandleEvents())
+					Display display;
+					if (display.Open(kTitle, Output_GetResX(), Output_GetResY(), kFullScreen))
 					{
-						oldTime = newTime;
-						newTime = timer.Get();
-						const float delta = newTime-oldTime; // base delta on sys. time
-
-#if !defined(SYNC_PLAYER)
-						if (ImGui::IsKeyReleased(ImGui::GetKeyIndex(ImGuiKey_Tab)) && !kFullScreen)
-							s_showImGui = !s_showImGui;
+						if (true == kFullScreen)
+							SDL_ShowCursor(SDL_DISABLE);
 
-						if (!kFullScreen)
+						if (true == kPipelined)
 						{
-							ImGui_ImplSDLRenderer2_NewFrame();
-							ImGui_ImplSDL2_NewFrame();
+							float totTime = 0.f;
+							const size_t numFrames = RunPipelined(display, totTime, avgLatency);
+							avgFPS = numFrames/totTime;
+						}
+						else
+						{
+							// frame buffer (used unless we can render straight into the display texture, see Display::Lock())
+							uint32_t* pDest = static_cast<uint32_t*>(mallocLarge(Output_GetBytes(), "frame buffers"));
+							memset32(pDest, 0, Output_GetSize());
+
+							Timer timer;
+
+							size_t numFrames = 0;
+							float oldTime = 0.f, newTime = 0.f, totTime = 0.f;
+							while (true == HandleEvents())
+							{
+								oldTime = newTime;
+								newTime = timer.Get();
+								const float delta = newTime-oldTime; // base delta on sys. time
+
+	#if !defined(SYNC_PLAYER)
+								if (ImGui::IsKeyReleased(ImGui::GetKeyIndex(ImGuiKey_Tab)) && !kFullScreen)
+									s_showImGui = !s_showImGui;
+
+								if (!kFullScreen)
+								{
+									ImGui_ImplSDLRenderer2_NewFrame();
+									ImGui_ImplSDL2_NewFrame();
 							
-							ImGui::NewFrame();
+									ImGui::NewFrame();
 							
-							if (ImGuiIsVisible())
-								ImGui::Begin("I'm ImGui!"); // dear lord Thorsten, that is a particularly wimpy introduction :D
-						}
-#endif
+									if (ImGuiIsVisible())
+										ImGui::Begin("I'm ImGui!"); // dear lord Thorsten, that is a particularly wimpy introduction :D
+								}
+	#endif
 
-						const float audioTime = Audio_Get_Pos_In_Sec();
-						if (false == Demo_Draw(pDest, audioTime, delta * 100.f))
-							break; // Rocket track says we're done
+								// capture reads the frame back, so don't render straight into the display texture then
+								uint32_t *pFrame = display.Lock(pDest, false == Capture_IsActive());
 
-#if !defined(SYNC_PLAYER)
-						if (!kFullScreen)
-						{
-							if (ImGuiIsVisible())
-								ImGui::End();
+								const float audioTime = Audio_Get_Pos_In_Sec();
+								if (false == Demo_Draw(pFrame, audioTime, delta * 100.f))
+									break; // Rocket track says we're done
+
+								Capture_Frame(pFrame);
+
+	#if !defined(SYNC_PLAYER)
+								if (!kFullScreen)
+								{
+									if (ImGuiIsVisible())
+										ImGui::End();
 							
-							ImGui::Render();
-						}
-#endif
+									ImGui::Render();
+								}
+	#endif
 
-						display.Update(pDest);
+								display.Present();
 
-						totTime += delta;
-						++numFrames;
-					}
+								totTime += delta;
+								++numFrames;
+							}
 
-					avgFPS = numFrames/totTime;
+							avgFPS = numFrames/totTime;
 
-					freeAligned(pDest);
-				}
+							freeLarge(pDest);
+						}
+					}
 
+				}
 			}
 		}
 	}
@@ -366,18 +587,27 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR cmdLine, int nCmdShow)
 
 	Audio_Destroy();
 	Demo_Destroy();
+	FrameCache_Destroy();
 
 	Image_Destroy();
 	Shared_Destroy();
 	Polar_Destroy();
 	FxBlitter_Destroy();
 	BoxBlur_Destroy();
+	TargetPool_Destroy();
+	Output_Destroy();
+	Capture_Destroy();
 
 	SDL_Quit();
 
 	if (false == s_lastErr.empty())
 	{
-		SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, kTitle, s_lastErr.c_str(), nullptr);
+		// workers are headless, their coordinator reports the failure
+		if (true == isFarmWorker)
+			fprintf(stderr, "%s\n", s_lastErr.c_str());
+		else
+			SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, kTitle, s_lastErr.c_str(), nullptr);
+
 		return 1;
 	}
 
@@ -391,7 +621,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR cmdLine, int nCmdShow)
 #endif
 
 	char fpsString[256];
-	snprintf(fpsString, 256, "\n *** Rough avg. FPS: %f ***\n", avgFPS);
+	if (false == kPipelined)
+		snprintf(fpsString, 256, "\n *** Rough avg. FPS: %f ***\n", avgFPS);
+	else
+		snprintf(fpsString, 256, "\n *** Rough avg. FPS: %f (latency: %.1fms) ***\n", avgFPS, avgLatency*1000.f);
 
 #if defined(DISPLAY_AVG_FPS)
 #if defined(_WIN32)
@@ -399,6 +632,16 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR cmdLine, int nCmdShow)
 #else
 	printf("%s", fpsString);
 #endif
+#endif
+
+#if defined(_DEBUG)
+	// large buffers per subsystem (peak is what counts, everything's been released by now)
+	const std::string allocReport = "\n" + LargeAlloc_Report();
+#if defined(_WIN32)
+	OutputDebugString(allocReport.c_str());
+#else
+	printf("%s", allocReport.c_str());
+#endif
 #endif
 
 	return 0;
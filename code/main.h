@@ -33,16 +33,44 @@
 // list of industry aspect ratios
 #include "../3rdparty/aspectratios.h"
 
-// output resolution
-constexpr size_t kResX = 1280;
-constexpr size_t kResY = 720;
-constexpr size_t kHalfResX = kResX/2;
-constexpr size_t kHalfResY = kResY/2;
-constexpr size_t kOutputSize = kResX*kResY;
-constexpr size_t kOutputBytes = kOutputSize*sizeof(uint32_t);
-constexpr float kAspect = (float)kResY/kResX;
+// supported production resolutions, one is picked at startup (see output.h) and everything is rendered natively at it
+struct OutputMode
+{
+	unsigned resX, resY;
+};
+
+constexpr unsigned kNumOutputModes = 3;
+constexpr OutputMode kOutputModes[kNumOutputModes] =
+{
+	{ 1280,  720 },
+	{ 1920, 1080 },
+	{ 3840, 2160 }
+};
+
+// the production is authored at the first mode: assets, sizes and offsets in pixels are made for it and
+// must be scaled by g_resScale (see ToRes() and Image_Load32_Res()), the aspect ratio is shared by all modes
+constexpr size_t kAuthorResX = kOutputModes[0].resX;
+constexpr size_t kAuthorResY = kOutputModes[0].resY;
+constexpr size_t kMaxResX = kOutputModes[kNumOutputModes-1].resX;
+constexpr size_t kMaxResY = kOutputModes[kNumOutputModes-1].resY;
+constexpr float kAspect = (float)kAuthorResY/kAuthorResX;
 constexpr float kOneOverAspect = 1.f/kAspect;
 
+// production resolution (set once by Output_Create(), treat as constants)
+extern size_t g_resX;
+extern size_t g_resY;
+extern size_t g_halfResX;
+extern size_t g_halfResY;
+extern size_t g_outputSize;
+extern size_t g_outputBytes;
+extern float g_resScale; // g_resX/kAuthorResX
+
+// size or offset in pixels at author resolution to production resolution
+inline int ToRes(int pixels)
+{
+	return int(lroundf(pixels*g_resScale));
+}
+
 constexpr bool kFullScreen = false;
 
 // set description on failure (reported on shutdown)
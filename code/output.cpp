@@ -0,0 +1,53 @@
+// cookiedough -- output resolution (picked at startup)
+
+#include "main.h"
+#include "output.h"
+
+// all modes must share the author aspect ratio, and be divisible by the polar tile size (32)
+static_assert(kOutputModes[1].resX*kAuthorResY == kOutputModes[1].resY*kAuthorResX);
+static_assert(kOutputModes[2].resX*kAuthorResY == kOutputModes[2].resY*kAuthorResX);
+static_assert(0 == (kOutputModes[0].resX&31) && 0 == (kOutputModes[1].resX&31) && 0 == (kOutputModes[2].resX&31));
+
+size_t g_resX = kAuthorResX;
+size_t g_resY = kAuthorResY;
+size_t g_halfResX = kAuthorResX/2;
+size_t g_halfResY = kAuthorResY/2;
+size_t g_outputSize = kAuthorResX*kAuthorResY;
+size_t g_outputBytes = kAuthorResX*kAuthorResY*sizeof(uint32_t);
+float g_resScale = 1.f;
+
+static unsigned s_mode = 0;
+
+bool Output_Create(unsigned resX, unsigned resY)
+{
+	for (unsigned iMode = 0; iMode < kNumOutputModes; ++iMode)
+	{
+		const OutputMode &mode = kOutputModes[iMode];
+		if (mode.resX == resX && mode.resY == resY)
+		{
+			s_mode = iMode;
+
+			g_resX = resX;
+			g_resY = resY;
+			g_halfResX = g_resX/2;
+			g_halfResY = g_resY/2;
+			g_outputSize = g_resX*g_resY;
+			g_outputBytes = g_outputSize*sizeof(uint32_t);
+			g_resScale = float(g_resX)/kAuthorResX;
+
+			return true;
+		}
+	}
+
+	SetLastError("Unsupported output resolution: " + std::to_string(resX) + "x" + std::to_string(resY));
+	return false;
+}
+
+void Output_Destroy() {}
+
+unsigned Output_GetMode() { return s_mode; }
+
+unsigned Output_GetResX() { return unsigned(g_resX); }
+unsigned Output_GetResY() { return unsigned(g_resY); }
+size_t Output_GetSize()   { return g_outputSize; }
+size_t Output_GetBytes()  { return g_outputBytes; }
@@ -0,0 +1,30 @@
+// cookiedough -- output resolution (picked at startup)
+
+/*
+	There's no scaling: everything is rendered natively at the output resolution, which is one of kOutputModes[]
+	(main.h) and sets g_resX, g_resY and friends:
+
+	- 1280x720 (the author resolution, assets and pixel constants are made for it)
+	- 1920x1080
+	- 3840x2160
+
+	The hot kernels (Fx map and polar blits) have an instance for each of these (sizes and steps are compile time
+	constants), one of which is picked once at creation, so there's no per-pixel cost to the choice. Fx maps, polar
+	tables and render targets are sized accordingly and assets are scaled on load (see Image_Load32_Res()).
+
+	Output_Create() must be called before anything else is created.
+*/
+
+#pragma once
+
+// fails (see SetLastError()) if resolution isn't supported
+bool Output_Create(unsigned resX, unsigned resY);
+void Output_Destroy();
+
+// index in kOutputModes[], for picking template instances
+unsigned Output_GetMode();
+
+unsigned Output_GetResX();
+unsigned Output_GetResY();
+size_t Output_GetSize();  // in pixels
+size_t Output_GetBytes();
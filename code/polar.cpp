@@ -6,28 +6,35 @@
 // - [ ] take out/optimize generic bilinear fetches
  
 #include "main.h"
+#include "alloc-large.h"
 #include "bilinear.h"
 #include "fx-blitter.h"
 #include "shared-resources.h"
+#include "polar.h"
+#include "output.h"
+
+unsigned g_polarNumBands = 0;
 
 static int *s_pMap        = nullptr;
 static int *s_pInvMap     = nullptr;
 static int *s_pMap2x2     = nullptr;
 static int *s_pInvMap2x2  = nullptr;
 
-static void CalculateMaps(int *pDest, int *pInvDest, unsigned srcResX, unsigned srcResY, unsigned destResX, unsigned destResY)
+// map rows are 'destPitch' entries (pairs) apart, matching the destination buffer
+static void CalculateMaps(int *pDest, int *pInvDest, unsigned srcResX, unsigned srcResY, unsigned destResX, unsigned destResY, unsigned destPitch)
 {
 	// ensure we can handle 4x4 blocks due to tiled blits
-	static_assert(0 == (kResX&3));
-	static_assert(0 == (kResY&3));
+	VIZ_ASSERT(0 == (destResX&3));
+	VIZ_ASSERT(0 == (destResY&3));
 
 	const float halfResX = destResX/2.f;
 	const float halfResY = destResY/2.f;
 
-	unsigned iPixel = 0;
+	unsigned iRow = 0;
 	const float maxDist = sqrtf(halfResX*halfResX + halfResY*halfResY);
-	for (float Y = -halfResY; Y < halfResY; Y += 1.f)
+	for (float Y = -halfResY; Y < halfResY; Y += 1.f, ++iRow)
 	{
+		unsigned iPixel = iRow*destPitch*2;
 		for (float X = -halfResX + kEpsilon; X < halfResX; X += 1.f)
 		{
 			const float distance = sqrtf(X*X + Y*Y) / maxDist;
@@ -58,25 +65,67 @@ static void CalculateMaps(int *pDest, int *pInvDest, unsigned srcResX, unsigned
 	}
 }
 
+// instances for the output mode (see output.h), picked by Polar_Create()
+static void (*s_blit)(uint32_t *pDest, const uint32_t *pSrc, bool inverse) = nullptr;
+static void (*s_blitA)(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, bool inverse) = nullptr;
+static void (*s_blitABand)(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, unsigned iBand) = nullptr;
+static void (*s_blit2x2)(uint32_t *pDest, const uint32_t *pSrc, bool inverse) = nullptr;
+
+template <unsigned kMode> static void Polar_Blit_Mode(uint32_t *pDest, const uint32_t *pSrc, bool inverse);
+template <unsigned kMode> static void Polar_BlitA_Mode(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, bool inverse);
+template <unsigned kMode> static void Polar_BlitA_Band_Mode(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, unsigned iBand);
+template <unsigned kMode> static void Polar_Blit_2x2_Mode(uint32_t *pDest, const uint32_t *pSrc, bool inverse);
+
+template <unsigned kMode>
+static void Polar_PickMode()
+{
+	s_blit = Polar_Blit_Mode<kMode>;
+	s_blitA = Polar_BlitA_Mode<kMode>;
+	s_blitABand = Polar_BlitA_Band_Mode<kMode>;
+	s_blit2x2 = Polar_Blit_2x2_Mode<kMode>;
+}
+
 bool Polar_Create()
 {
-	s_pMap       = static_cast<int*>(mallocAligned(kOutputSize*sizeof(int)*2, kAlignTo));
-	s_pInvMap    = static_cast<int*>(mallocAligned(kOutputSize*sizeof(int)*2, kAlignTo));
-	s_pMap2x2    = static_cast<int*>(mallocAligned(kFxMapSize*sizeof(int)*2, kAlignTo));
-	s_pInvMap2x2 = static_cast<int*>(mallocAligned(kFxMapSize*sizeof(int)*2, kAlignTo));
+	s_pMap       = static_cast<int*>(mallocLarge(g_outputSize*sizeof(int)*2, "polar"));
+	s_pInvMap    = static_cast<int*>(mallocLarge(g_outputSize*sizeof(int)*2, "polar"));
+	s_pMap2x2    = static_cast<int*>(mallocLarge(g_fxMapSize*sizeof(int)*2, "polar")); // g_fxMapSize includes row padding
+	s_pInvMap2x2 = static_cast<int*>(mallocLarge(g_fxMapSize*sizeof(int)*2, "polar"));
 
-	CalculateMaps(s_pMap, s_pInvMap, kTargetResX, kTargetResY, kResX, kResY);
-	CalculateMaps(s_pMap2x2, s_pInvMap2x2, kFxMapResX, kFxMapResY, kFxMapResX, kFxMapResY);
+	CalculateMaps(s_pMap, s_pInvMap, g_targetResX, g_targetResY, g_resX, g_resY, g_resX);
+	CalculateMaps(s_pMap2x2, s_pInvMap2x2, g_fxMapResX, g_fxMapResY, g_fxMapResX, g_fxMapResY, g_fxMapPitch);
+
+	g_polarNumBands = unsigned(g_resY + kPolarBandRows-1)/kPolarBandRows;
+
+	static_assert(3 == kNumOutputModes);
+	switch (Output_GetMode())
+	{
+	case 0:
+		Polar_PickMode<0>();
+		break;
+
+	case 1:
+		Polar_PickMode<1>();
+		break;
+
+	case 2:
+		Polar_PickMode<2>();
+		break;
+
+	default:
+		VIZ_ASSERT(false);
+		return false;
+	}
 
 	return true;
 }
 
 void Polar_Destroy() 
 {
-	freeAligned(s_pMap);
-	freeAligned(s_pInvMap);
-	freeAligned(s_pMap2x2);
-	freeAligned(s_pInvMap2x2);
+	freeLarge(s_pMap);
+	freeLarge(s_pInvMap);
+	freeLarge(s_pMap2x2);
+	freeLarge(s_pInvMap2x2);
 }
 
 VIZ_INLINE __m128i Fetch32(const int *pRead, const uint32_t *pSrc, const unsigned targetResX)
@@ -105,22 +154,28 @@ VIZ_INLINE __m128i Fetch16(const int *pRead, const uint32_t *pSrc, const unsigne
 	return bsamp32_16(pSrc, U0, V0, U0+1, V0+targetResX, fracU, fracV);
 }
 
-template <unsigned xRes>
+// tiles on the right & bottom edge are clipped (resolutions aren't necessarily a multiple of the tile size)
+// source, destination and map share 'pitch' (Fx maps are padded, see fx-blitter.h)
+template <unsigned xRes, unsigned yRes, unsigned pitch = xRes>
 CKD_INLINE static void Polar_Blit_Tile(uint32_t *pDest, const uint32_t *pSrc, const int *pRead, size_t tileSize, unsigned tY, unsigned tX)
 {
-	unsigned tileOffs = tY*xRes + tX;
+	static_assert(0 == (xRes&3));
+
+	unsigned tileOffs = tY*pitch + tX;
 
-	for (unsigned iY = tY; iY < tY + tileSize; ++iY)
+	const unsigned endX = std::min<unsigned>(unsigned(tileSize), xRes-tX);
+	const unsigned endY = std::min<unsigned>(tY + unsigned(tileSize), yRes);
+	for (unsigned iY = tY; iY < endY; ++iY)
 	{
 		uint32_t* pDLine = pDest + tileOffs;
 		const int* pMLine = pRead + (tileOffs<<1);
 
-		for (unsigned iX = 0; iX < tileSize; iX += 4)
+		for (unsigned iX = 0; iX < endX; iX += 4)
 		{
-			const __m128i A = Fetch32(pMLine + (iX+0)*2, pSrc, xRes);
-			const __m128i B = Fetch32(pMLine + (iX+1)*2, pSrc, xRes);
-			const __m128i C = Fetch32(pMLine + (iX+2)*2, pSrc, xRes);
-			const __m128i D = Fetch32(pMLine + (iX+3)*2, pSrc, xRes);
+			const __m128i A = Fetch32(pMLine + (iX+0)*2, pSrc, pitch);
+			const __m128i B = Fetch32(pMLine + (iX+1)*2, pSrc, pitch);
+			const __m128i C = Fetch32(pMLine + (iX+2)*2, pSrc, pitch);
+			const __m128i D = Fetch32(pMLine + (iX+3)*2, pSrc, pitch);
 
 			const __m128i AB = _mm_packus_epi32(A, B);
 			const __m128i CD = _mm_packus_epi32(C, D);
@@ -128,91 +183,150 @@ CKD_INLINE static void Polar_Blit_Tile(uint32_t *pDest, const uint32_t *pSrc, co
 			_mm_stream_si128(reinterpret_cast<__m128i*>(pDLine + iX), _mm_packus_epi16(AB, CD));
 		}
 
-		tileOffs += xRes;
+		tileOffs += pitch;
 	}
 }
 
-void Polar_Blit(uint32_t *pDest, const uint32_t *pSrc, bool inverse /* = false */)
+template <unsigned kMode>
+static void Polar_Blit_Mode(uint32_t *pDest, const uint32_t *pSrc, bool inverse)
 {
+	constexpr unsigned kModeResX = kOutputModes[kMode].resX;
+	constexpr unsigned kModeResY = kOutputModes[kMode].resY;
+
 	if (false == inverse) {
 		const size_t tileSize = 32;
 		#pragma omp parallel for collapse(2) schedule(static) // FIXME: measure -> schedule(guided, 4)
-		for (unsigned tY = 0; tY < kResY; tY += tileSize)
-			for (unsigned tX = 0; tX < kResX; tX += tileSize)
-				Polar_Blit_Tile<kTargetResX>(pDest, pSrc, s_pMap, tileSize, tY, tX);
+		for (unsigned tY = 0; tY < kModeResY; tY += tileSize)
+			for (unsigned tX = 0; tX < kModeResX; tX += tileSize)
+				Polar_Blit_Tile<kModeResX, kModeResY>(pDest, pSrc, s_pMap, tileSize, tY, tX);
 	}
 	else {
 		const size_t tileSize = 16; // anticipating more read cache misses
 		#pragma omp parallel for collapse(2) schedule(static)
-		for (unsigned tY = 0; tY < kResY; tY += tileSize)
-			for (unsigned tX = 0; tX < kResX; tX += tileSize)
-				Polar_Blit_Tile<kTargetResX>(pDest, pSrc, s_pInvMap, tileSize, tY, tX);
+		for (unsigned tY = 0; tY < kModeResY; tY += tileSize)
+			for (unsigned tX = 0; tX < kModeResX; tX += tileSize)
+				Polar_Blit_Tile<kModeResX, kModeResY>(pDest, pSrc, s_pInvMap, tileSize, tY, tX);
 		
 	}
 
 	CKD_FLANDERS(_mm_sfence();)
 }
 
+void Polar_Blit(uint32_t *pDest, const uint32_t *pSrc, bool inverse /* = false */)
+{
+	s_blit(pDest, pSrc, inverse);
+}
 
-CKD_INLINE static void Polar_Blit_TileA(uint32_t *pDest, const uint32_t *pSrc, const int *pRead, size_t tileSize, unsigned tY, unsigned tX)
+// 'pBack' may be 'pDest' (in place)
+template <unsigned g_targetResX, unsigned g_targetResY>
+CKD_INLINE static void Polar_Blit_TileA(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, const int *pRead, size_t tileSize, unsigned tY, unsigned tX)
 {
-	unsigned tileOffs = tY*kTargetResX + tX;
+	unsigned tileOffs = tY*g_targetResX + tX;
 
-	for (unsigned iY = tY; iY < tY + tileSize; ++iY)
+	const unsigned endY = std::min<unsigned>(tY + unsigned(tileSize), g_targetResY);
+	for (unsigned iY = tY; iY < endY; ++iY)
 	{
 		uint32_t *pDLine = pDest + tileOffs;
+		const uint32_t *pBLine = pBack + tileOffs;
 		const int *pMLine = pRead + (tileOffs<<1);
 
 		for (unsigned iX = 0; iX < tileSize; ++iX)
 		{
-			const __m128i srcColor = Fetch16(pMLine + (iX<<1), pSrc, kTargetResX);
+			const __m128i srcColor = Fetch16(pMLine + (iX<<1), pSrc, g_targetResX);
 			const __m128i alphaUnp = _mm_shufflelo_epi16(srcColor, 0xff);
-			const __m128i destColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pDLine[iX]), _mm_setzero_si128());
+			const __m128i destColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pBLine[iX]), _mm_setzero_si128());
 			const __m128i delta = _mm_mullo_epi16(alphaUnp, _mm_sub_epi16(srcColor, destColor));
 			const __m128i color = _mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(destColor, 8), delta), 8);
 			pDLine[iX] = _mm_cvtsi128_si32(_mm_packus_epi16(color, _mm_setzero_si128()));
 		}
 
-		tileOffs += kTargetResX;
+		tileOffs += g_targetResX;
 	}
 }
 
-void Polar_BlitA(uint32_t *pDest, const uint32_t *pSrc, bool inverse /* = false */)
+template <unsigned kMode>
+static void Polar_BlitA_Mode(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, bool inverse)
 {
+	constexpr unsigned kModeResX = kOutputModes[kMode].resX;
+	constexpr unsigned kModeResY = kOutputModes[kMode].resY;
+
 	if (false == inverse) {
 		const size_t tileSize = 32;
 		#pragma omp parallel for collapse(2) schedule(guided, 4)
-		for (unsigned tY = 0; tY < kResY; tY += tileSize)
-			for (unsigned tX = 0; tX < kResX; tX += tileSize)
-				Polar_Blit_TileA(pDest, pSrc, s_pMap, tileSize, tY, tX);
+		for (unsigned tY = 0; tY < kModeResY; tY += tileSize)
+			for (unsigned tX = 0; tX < kModeResX; tX += tileSize)
+				Polar_Blit_TileA<kModeResX, kModeResY>(pDest, pBack, pSrc, s_pMap, tileSize, tY, tX);
 	}
 	else {
 		const size_t tileSize = 16;
 		#pragma omp parallel for collapse(2) schedule(static)
-		for (unsigned tY = 0; tY < kResY; tY += tileSize)
-			for (unsigned tX = 0; tX < kResX; tX += tileSize)
-				Polar_Blit_TileA(pDest, pSrc, s_pInvMap, tileSize, tY, tX);
+		for (unsigned tY = 0; tY < kModeResY; tY += tileSize)
+			for (unsigned tX = 0; tX < kModeResX; tX += tileSize)
+				Polar_Blit_TileA<kModeResX, kModeResY>(pDest, pBack, pSrc, s_pInvMap, tileSize, tY, tX);
 	}
 
 	CKD_FLANDERS(_mm_sfence();)
 }
 
-void Polar_Blit_2x2(uint32_t *pDest, const uint32_t *pSrc, bool inverse /* = false */)
+void Polar_BlitA(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, bool inverse /* = false */)
 {
+	s_blitA(pDest, pBack, pSrc, inverse);
+}
+
+void Polar_BlitA(uint32_t *pDest, const uint32_t *pSrc, bool inverse /* = false */)
+{
+	Polar_BlitA(pDest, pDest, pSrc, inverse);
+}
+
+template <unsigned kMode>
+static void Polar_BlitA_Band_Mode(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, unsigned iBand)
+{
+	constexpr unsigned kModeResX = kOutputModes[kMode].resX;
+	constexpr unsigned kModeResY = kOutputModes[kMode].resY;
+
+	const unsigned tY = iBand*kPolarBandRows;
+	VIZ_ASSERT(tY < kModeResY);
+
+	for (unsigned tX = 0; tX < kModeResX; tX += kPolarBandRows)
+		Polar_Blit_TileA<kModeResX, kModeResY>(pDest, pBack, pSrc, s_pMap, kPolarBandRows, tY, tX);
+}
+
+void Polar_BlitA_Band(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, unsigned iBand)
+{
+	s_blitABand(pDest, pBack, pSrc, iBand);
+}
+
+void Polar_BlitA_Band(uint32_t *pDest, const uint32_t *pSrc, unsigned iBand)
+{
+	Polar_BlitA_Band(pDest, pDest, pSrc, iBand);
+}
+
+template <unsigned kMode>
+static void Polar_Blit_2x2_Mode(uint32_t *pDest, const uint32_t *pSrc, bool inverse)
+{
+	constexpr unsigned kMapResX = unsigned(FxMapResX(kOutputModes[kMode].resX));
+	constexpr unsigned kMapResY = unsigned(FxMapResY(kOutputModes[kMode].resY));
+	constexpr unsigned kMapPitch = unsigned(FxMapPitch(kOutputModes[kMode].resX));
+
 	if (false == inverse) {
-		const size_t tileSize = 64; // kFxMapRes is about half the size, so double up default tile size
+		const size_t tileSize = 64; // g_fxMapRes is about half the size, so double up default tile size
 		#pragma omp parallel for collapse(2) schedule(static) // FIXME: measure -> schedule(guided, 4)
-		for (unsigned tY = 0; tY < kFxMapResY; tY += tileSize)
-			for (unsigned tX = 0; tX < kFxMapResX; tX += tileSize)
-				Polar_Blit_Tile<kFxMapResX>(pDest, pSrc, s_pMap2x2, tileSize, tY, tX);
+		for (unsigned tY = 0; tY < kMapResY; tY += tileSize)
+			for (unsigned tX = 0; tX < kMapResX; tX += tileSize)
+				Polar_Blit_Tile<kMapResX, kMapResY, kMapPitch>(pDest, pSrc, s_pMap2x2, tileSize, tY, tX);
 	}
 	else {
 		const size_t tileSize = 32; // anticipating more read cache misses
 		#pragma omp parallel for collapse(2) schedule(static)
-			for (unsigned tY = 0; tY < kFxMapResY; tY += tileSize)
-				for (unsigned tX = 0; tX < kFxMapResX; tX += tileSize)
-					Polar_Blit_Tile<kFxMapResX>(pDest, pSrc, s_pInvMap2x2, tileSize, tY, tX);
+			for (unsigned tY = 0; tY < kMapResY; tY += tileSize)
+				for (unsigned tX = 0; tX < kMapResX; tX += tileSize)
+					Polar_Blit_Tile<kMapResX, kMapResY, kMapPitch>(pDest, pSrc, s_pInvMap2x2, tileSize, tY, tX);
 	}
 
 	CKD_FLANDERS(_mm_sfence();)
 }
+
+void Polar_Blit_2x2(uint32_t *pDest, const uint32_t *pSrc, bool inverse /* = false */)
+{
+	s_blit2x2(pDest, pSrc, inverse);
+}
@@ -4,14 +4,22 @@
 #ifndef _POLAR_H_
 #define _POLAR_H_
 
+// tables follow the output resolution and the Fx map size, so call after Output_Create() and FxBlitter_Create()
 bool Polar_Create();
 void Polar_Destroy();
 
 // render target to output resolution
 void Polar_Blit(uint32_t *pDest, const uint32_t *pSrc, bool inverse = false);
 
-// blend by source image alpha
+// blend by source image alpha (on top of 'pDest' or, out-of-place, on top of 'pBack' so it needn't be copied first)
 void Polar_BlitA(uint32_t *pDest, const uint32_t *pSrc, bool inverse = false);
+void Polar_BlitA(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, bool inverse = false);
+
+// Polar_BlitA() (not inverse) one band of kPolarBandRows rows at a time, for use in a task graph
+constexpr unsigned kPolarBandRows = 32;
+extern unsigned g_polarNumBands; // for the output resolution (set by Polar_Create())
+void Polar_BlitA_Band(uint32_t *pDest, const uint32_t *pSrc, unsigned iBand);
+void Polar_BlitA_Band(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, unsigned iBand);
 
 // for 2x2 effect map
 void Polar_Blit_2x2(uint32_t *pDest, const uint32_t *pSrc, bool inverse = false);
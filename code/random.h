@@ -1,26 +1,61 @@
-
-// cookiedough -- Mersenne-Twister random generator
-
-// FIXME (see Github issue): 
-// - this isn't thread-safe (pulled from the GR-1 codebase)
-// - as of 03/03/2026 that's not an issue, but it can be given the heavy OpenMP parallelization
+// cookiedough -- stateless, counter-based random generator
 
 #if !defined(RANDOM_H)
 #define RANDOM_H
 
-#include "../3rdparty/tinymt/tinymt32.h"
-#include "../3rdparty/tinymt/tinymt64.h"
-
-void initialize_random_generator();
-
-// these return between epsilon and one, never zero
-float mt_rand_norm_f();
-double mt_rand_norm();
-
-uint32_t mt_randu32();
-int32_t mt_rand32();
-
-uint64_t mt_randu64();
-int64_t mt_rand64();
+/*
+	Each number is a hash of (key, counter), so it's thread-safe and gives the same result regardless of thread
+	count or the order pixels are processed in. Derive a key per effect (seed) and frame, then use the pixel index
+	(or whatever you're iterating) as counter.
+
+	The hash is Chris Wellons' 'lowbias32', applied twice; 4 lanes at a time with SSE 4.1 (_mm_mullo_epi32).
+*/
+
+CKD_INLINE static uint32_t ctr_hash(uint32_t x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+CKD_INLINE static uint32_t ctr_rand_key(uint32_t seed, uint32_t frame) {
+	return ctr_hash(seed ^ ctr_hash(frame + 0x9e3779b9u));
+}
+
+CKD_INLINE static uint32_t ctr_randu32(uint32_t key, uint32_t counter) {
+	return ctr_hash(ctr_hash(counter ^ key) + key);
+}
+
+// between epsilon and one, never zero
+CKD_INLINE static float ctr_rand_norm_f(uint32_t key, uint32_t counter) {
+	return float((ctr_randu32(key, counter) >> 8) + 1) * (1.f/16777216.f);
+}
+
+CKD_INLINE static __m128i ctr_hash4(__m128i x)
+{
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+	x = _mm_mullo_epi32(x, _mm_set1_epi32(0x7feb352d));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 15));
+	x = _mm_mullo_epi32(x, _mm_set1_epi32(int(0x846ca68bu)));
+	x = _mm_xor_si128(x, _mm_srli_epi32(x, 16));
+	return x;
+}
+
+// counters [counter, counter+3]
+CKD_INLINE static __m128i ctr_randu32x4(uint32_t key, uint32_t counter)
+{
+	const __m128i vKey = _mm_set1_epi32(int(key));
+	const __m128i counters = _mm_add_epi32(_mm_set1_epi32(int(counter)), _mm_setr_epi32(0, 1, 2, 3));
+	return ctr_hash4(_mm_add_epi32(ctr_hash4(_mm_xor_si128(counters, vKey)), vKey));
+}
+
+CKD_INLINE static __m128 ctr_rand_norm_fx4(uint32_t key, uint32_t counter)
+{
+	const __m128i bits = _mm_add_epi32(_mm_srli_epi32(ctr_randu32x4(key, counter), 8), _mm_set1_epi32(1));
+	return _mm_mul_ps(_mm_cvtepi32_ps(bits), _mm_set1_ps(1.f/16777216.f));
+}
 
 #endif // RANDOM_H
@@ -0,0 +1,380 @@
+// cookiedough -- local render farm (headless, multi-process captures)
+
+#include "main.h"
+#include "alloc-large.h"
+#include "render-farm.h"
+#include "audio.h"
+#include "rocket.h"
+#include "demo.h"
+#include "capture.h"
+#include "fx-governor.h"
+#include "gamepad.h"
+
+#include <filesystem>
+
+#if defined(_WIN32)
+	#include <windows.h>
+#else
+	#include <spawn.h>
+	#include <sys/wait.h>
+	#include <unistd.h>
+	extern char **environ;
+#endif
+
+#if defined(__linux__)
+	#include <sched.h>
+#elif defined(__APPLE__)
+	#include <mach-o/dyld.h>
+#endif
+
+static const char *kWorkerSwitch = "-farm-worker";
+
+//
+// Processes.
+//
+
+#if defined(_WIN32)
+	typedef HANDLE Process;
+#else
+	typedef pid_t Process;
+#endif
+
+static std::string GetExecutablePath()
+{
+#if defined(_WIN32)
+	char path[MAX_PATH];
+	const DWORD length = GetModuleFileNameA(nullptr, path, MAX_PATH);
+	return (0 != length && MAX_PATH != length) ? path : "";
+#elif defined(__APPLE__)
+	char path[4096];
+	uint32_t size = sizeof(path);
+	return (0 == _NSGetExecutablePath(path, &size)) ? path : "";
+#else
+	std::error_code error;
+	const std::filesystem::path path = std::filesystem::read_symlink("/proc/self/exe", error);
+	return (!error) ? path.string() : "";
+#endif
+}
+
+static bool Launch(const std::string &exePath, const std::vector<std::string> &args, Process &process)
+{
+#if defined(_WIN32)
+	std::string cmdLine = "\"" + exePath + "\"";
+	for (const std::string &arg : args)
+		cmdLine += " \"" + arg + "\"";
+
+	STARTUPINFOA startupInfo = { sizeof(STARTUPINFOA) };
+	PROCESS_INFORMATION processInfo;
+	if (FALSE == CreateProcessA(exePath.c_str(), cmdLine.data(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startupInfo, &processInfo))
+		return false;
+
+	CloseHandle(processInfo.hThread);
+	process = processInfo.hProcess;
+	return true;
+#else
+	std::vector<char *> argv;
+	argv.push_back(const_cast<char *>(exePath.c_str()));
+	for (const std::string &arg : args)
+		argv.push_back(const_cast<char *>(arg.c_str()));
+	argv.push_back(nullptr);
+
+	return 0 == posix_spawn(&process, exePath.c_str(), nullptr, nullptr, argv.data(), environ);
+#endif
+}
+
+// true if process exited without error
+static bool Wait(Process process)
+{
+#if defined(_WIN32)
+	WaitForSingleObject(process, INFINITE);
+	DWORD exitCode = 1;
+	GetExitCodeProcess(process, &exitCode);
+	CloseHandle(process);
+	return 0 == exitCode;
+#else
+	int status;
+	if (process != waitpid(process, &status, 0))
+		return false;
+
+	return WIFEXITED(status) && 0 == WEXITSTATUS(status);
+#endif
+}
+
+//
+// Worker.
+//
+
+// DemoState goes over the command line as hex, bit for bit (it's all floats)
+static std::string StateToHex(const DemoState &state)
+{
+	static const char *kHex = "0123456789abcdef";
+
+	const uint8_t *pBytes = reinterpret_cast<const uint8_t *>(&state);
+	std::string hex;
+	for (size_t iByte = 0; iByte < sizeof(DemoState); ++iByte)
+	{
+		hex += kHex[pBytes[iByte]>>4];
+		hex += kHex[pBytes[iByte]&15];
+	}
+
+	return hex;
+}
+
+static bool HexToState(const std::string &hex, DemoState &state)
+{
+	if (hex.size() != sizeof(DemoState)*2)
+		return false;
+
+	uint8_t *pBytes = reinterpret_cast<uint8_t *>(&state);
+	for (size_t iByte = 0; iByte < sizeof(DemoState); ++iByte)
+	{
+		char *pEnd;
+		const std::string digits = hex.substr(iByte*2, 2);
+		pBytes[iByte] = uint8_t(strtoul(digits.c_str(), &pEnd, 16));
+		if (pEnd != digits.c_str()+2)
+			return false;
+	}
+
+	return true;
+}
+
+bool RenderFarm_ParseWorkerArgs(const std::vector<std::string> &args, size_t &iArg, FarmChunk &chunk)
+{
+	if (kWorkerSwitch != args[iArg] || iArg+5 >= args.size())
+		return false;
+
+	auto next = [&]() { return unsigned(strtoul(args[++iArg].c_str(), nullptr, 10)); };
+	chunk.firstFrame = next();
+	chunk.numFrames = next();
+
+	if (false == HexToState(args[++iArg], chunk.state))
+		return false;
+
+	chunk.firstCore = next();
+	chunk.numCores = next();
+
+	return true;
+}
+
+static std::vector<std::string> GetWorkerArgs(const FarmChunk &chunk)
+{
+	return {
+		kWorkerSwitch,
+		std::to_string(chunk.firstFrame),
+		std::to_string(chunk.numFrames),
+		StateToHex(chunk.state),
+		std::to_string(chunk.firstCore),
+		std::to_string(chunk.numCores)
+	};
+}
+
+void RenderFarm_PinWorker(const FarmChunk &chunk)
+{
+	if (0 == chunk.numCores)
+		return;
+
+	omp_set_num_threads(int(chunk.numCores));
+
+	// threads created from here on inherit this
+#if defined(__linux__)
+	cpu_set_t cores;
+	CPU_ZERO(&cores);
+	for (unsigned iCore = chunk.firstCore; iCore < chunk.firstCore+chunk.numCores; ++iCore)
+		CPU_SET(iCore, &cores);
+
+	sched_setaffinity(0, sizeof(cores), &cores);
+#elif defined(_WIN32)
+	DWORD_PTR mask = 0;
+	for (unsigned iCore = chunk.firstCore; iCore < chunk.firstCore+chunk.numCores && iCore < 64; ++iCore)
+		mask |= DWORD_PTR(1) << iCore;
+
+	SetProcessAffinityMask(GetCurrentProcess(), mask);
+#endif
+
+	// OSX: no affinity to speak of, thread count will have to do
+}
+
+bool RenderFarm_Work(const FarmChunk &chunk, unsigned fps)
+{
+#if !defined(SYNC_PLAYER)
+	SetLastError("The render farm only works with player (SYNC_PLAYER) builds.");
+	return false;
+#else
+	VIZ_ASSERT(true == Capture_IsActive());
+
+	// output may not depend on how long things take, nor on input
+	FxGovernor_Enable(false);
+	Gamepad_Enable(false);
+
+	// start where a sequential render would
+	Demo_SetState(chunk.state);
+
+	uint32_t *pRender = static_cast<uint32_t*>(mallocLarge(g_outputBytes, "frame buffers"));
+
+	// delta is (as in main.cpp) in 1/100th of a second
+	const float delta = 100.f/fps;
+
+	// every chunk but the first starts with the frame before it, which the coordinator checks against the one the
+	// previous chunk ended with (and then drops)
+	const unsigned firstFrame = (chunk.firstFrame > 0) ? chunk.firstFrame-1 : 0;
+
+	bool success = true;
+	const unsigned endFrame = chunk.firstFrame + chunk.numFrames;
+	for (unsigned iFrame = firstFrame; iFrame < endFrame; ++iFrame)
+	{
+		const double time = double(iFrame)/fps;
+		Audio_Set_Offline_Pos(time);
+
+		if (false == Demo_Draw(pRender, float(time), delta))
+			break; // it's over
+
+		// if state carried over between frames changes without input, chunks can't start from it (and would differ)
+		const DemoState state = Demo_GetState();
+		if (0 != memcmp(&state, &chunk.state, sizeof(DemoState)))
+		{
+			SetLastError("Demo state changed during a headless render (frame " + std::to_string(iFrame) + "), render farm chunks can't start from it.");
+			success = false;
+			break;
+		}
+
+		Capture_Frame(pRender);
+	}
+
+	freeLarge(pRender);
+
+	return success;
+#endif
+}
+
+//
+// Coordinator.
+//
+
+bool RenderFarm_Coordinate(unsigned numWorkers, unsigned fps, const std::vector<std::string> &workerArgs)
+{
+#if !defined(SYNC_PLAYER)
+	SetLastError("The render farm only works with player (SYNC_PLAYER) builds.");
+	return false;
+#else
+	VIZ_ASSERT(numWorkers > 0 && true == Capture_IsActive());
+
+	const double endRow = Rocket::GetEndRow();
+	if (endRow < 0.0)
+	{
+		SetLastError("Can't split the timeline into chunks: 'demo:quit' has no key that ends it.");
+		return false;
+	}
+
+	const std::string exePath = GetExecutablePath();
+	if (true == exePath.empty())
+	{
+		SetLastError("Can't find our own executable to launch workers.");
+		return false;
+	}
+
+	// rows to frames (one extra, the worker with the last chunk stops by itself)
+	const unsigned numFrames = unsigned(ceil(endRow/Audio_Get_Row_Rate()*fps)) + 1;
+	numWorkers = std::min(numWorkers, numFrames);
+
+	const unsigned numCores = std::max(1u, std::thread::hardware_concurrency());
+	const unsigned coresPerWorker = std::max(1u, numCores/numWorkers);
+
+	struct Worker
+	{
+		FarmChunk chunk;
+		std::string path;
+		Process process;
+		bool launched;
+	};
+
+	std::vector<Worker> workers(numWorkers);
+
+	// what a sequential render starts from (nothing's been drawn yet)
+	const DemoState state = Demo_GetState();
+
+	std::error_code error;
+	const std::filesystem::path tempDir = std::filesystem::temp_directory_path(error);
+	const std::string tag = std::to_string(uintptr_t(&workers)) + "-" + std::to_string(time(nullptr));
+
+	bool success = true;
+	for (unsigned iWorker = 0; iWorker < numWorkers; ++iWorker)
+	{
+		Worker &worker = workers[iWorker];
+
+		FarmChunk &chunk = worker.chunk;
+		chunk.firstFrame = uint64_t(numFrames)*iWorker/numWorkers;
+		chunk.numFrames = unsigned(uint64_t(numFrames)*(iWorker+1)/numWorkers) - chunk.firstFrame;
+		chunk.state = state;
+		chunk.firstCore = (coresPerWorker*iWorker) % numCores;
+		chunk.numCores = (numWorkers <= numCores) ? coresPerWorker : 0;
+
+		worker.path = (tempDir / ("cookiedough-farm-" + tag + "-" + std::to_string(iWorker) + ".y4m")).string();
+
+		std::vector<std::string> args = workerArgs;
+		args.push_back("-y4m");
+		args.push_back(worker.path);
+
+		const std::vector<std::string> chunkArgs = GetWorkerArgs(chunk);
+		args.insert(args.end(), chunkArgs.begin(), chunkArgs.end());
+
+		worker.launched = Launch(exePath, args, worker.process);
+		if (false == worker.launched)
+		{
+			SetLastError("Can't launch render farm worker: " + exePath);
+			success = false;
+			break;
+		}
+
+		printf("Render farm: worker %u renders frames %u-%u on core(s) %u-%u\n", iWorker, chunk.firstFrame, chunk.firstFrame+chunk.numFrames-1, chunk.firstCore, chunk.firstCore+coresPerWorker-1);
+	}
+
+	// always wait for whatever was launched
+	for (Worker &worker : workers)
+	{
+		if (true == worker.launched && false == Wait(worker.process))
+		{
+			SetLastError("Render farm worker failed on frames starting at: " + std::to_string(worker.chunk.firstFrame));
+			success = false;
+		}
+	}
+
+	// reassemble in order, checking that each chunk boundary is seamless: the frame before a chunk, rendered by it's
+	// worker from the chunk's state, must be identical to the one the previous worker rendered (after all it's frames)
+	std::vector<uint8_t> boundary, last, previousLast;
+	int previousAppended = 0;
+	for (unsigned iWorker = 0; iWorker < numWorkers; ++iWorker)
+	{
+		Worker &worker = workers[iWorker];
+
+		if (true == success && true == worker.launched)
+		{
+			const unsigned numSkip = (iWorker > 0) ? 1 : 0;
+			boundary.clear();
+			last.clear();
+
+			const int numAppended = Capture_Append(worker.path, numSkip, &boundary, &last);
+			if (numAppended < 0)
+				success = false;
+			else
+			{
+				// previous worker may have stopped short (demo was over), then there's nothing to compare
+				const bool comparable = iWorker > 0 && unsigned(previousAppended) == workers[iWorker-1].chunk.numFrames && false == boundary.empty();
+				if (true == comparable && boundary != previousLast)
+				{
+					SetLastError("Render farm output is not identical to a sequential render at frame: " + std::to_string(worker.chunk.firstFrame-1));
+					success = false;
+				}
+
+				printf("Render farm: appended %d frame(s) from worker at frame %u\n", numAppended, worker.chunk.firstFrame);
+			}
+
+			previousAppended = numAppended;
+			previousLast.swap(last);
+		}
+
+		std::filesystem::remove(worker.path, error);
+	}
+
+	return success;
+#endif
+}
@@ -0,0 +1,44 @@
+// cookiedough -- local render farm (headless, multi-process captures)
+
+/*
+	For final captures (see capture.h) at high resolution: instead of one process rendering every frame in sequence,
+	'-farm <N>' splits the timeline (up to the end row in the 'demo:quit' track) into N chunks of frames and launches
+	N headless workers of this same executable, each pinned to it's own set of cores, that render their chunk to a
+	temporary .y4m file. Once all are done the chunks are appended, in order, to the capture.
+
+	cookiedough 3840x2160 -farm 4 -y4m capture.y4m
+
+	- headless means: offline clock (frame N is rendered at N/fps seconds, see Audio_Set_Offline_Pos()), fixed delta
+	  time, no display, no audio, no input (Gamepad_Enable()) and no dynamic resolution (FxGovernor_Enable())
+	- every chunk starts from the DemoState (see demo.h) a sequential render starts from, passed on by the coordinator;
+	  without input that state is constant, which each worker checks after every frame (and fails if it isn't)
+	- parts may not keep anything else from one frame to the next that changes what they render (caches are fine if
+	  a hit is identical to a rebuild), so the output is identical to '-farm 1' (a sequential render)
+	- checked at every chunk boundary: each worker but the first also renders the frame before it's chunk, which must
+	  be identical to the previous worker's last frame, or the capture fails
+	- player (SYNC_PLAYER) builds only
+*/
+
+#pragma once
+
+#include "demo.h"
+
+struct FarmChunk
+{
+	unsigned firstFrame, numFrames;
+	DemoState state; // to start from
+	unsigned firstCore, numCores; // affinity (numCores 0 means: leave it be)
+};
+
+// worker: Demo_Create() and Capture_Create() must have succeeded
+bool RenderFarm_Work(const FarmChunk &chunk, unsigned fps);
+
+// coordinator: Demo_Create() (for the sync. tracks) and Capture_Create() must have succeeded
+// 'workerArgs' are passed on to each worker (e.g. resolution)
+bool RenderFarm_Coordinate(unsigned numWorkers, unsigned fps, const std::vector<std::string> &workerArgs);
+
+// worker command line: if args[iArg] is the worker switch, parses the chunk (advancing 'iArg' past it) and returns true
+bool RenderFarm_ParseWorkerArgs(const std::vector<std::string> &args, size_t &iArg, FarmChunk &chunk);
+
+// call as early as possible in a worker (before any OpenMP parallel region), so all threads end up on the right cores
+void RenderFarm_PinWorker(const FarmChunk &chunk);
@@ -22,7 +22,17 @@ namespace retro3D
 		Vector2 UV;
 	};
 
+	// sub-pixel precision of projected vertices (28.4 fixed point)
+	constexpr unsigned kSubPixelBits = 4;
+	constexpr int kSubPixelOne = 1<<kSubPixelBits;
+
+	CKD_INLINE static int ToSubPixel(float value) {
+		return int(lrintf(value*kSubPixelOne));
+	}
+
 	// triangle filler vertex (post projection)
+	// - iX & iY are in pixels (28.4 fixed point, see ToSubPixel()), pixel centers are at .5
+	// - projZ is 1/Z (view space, so larger is closer), used for the depth test and perspective correct UVs
 	struct Projected
 	{
 		int iX, iY;
@@ -30,6 +40,24 @@ namespace retro3D
 		uint32_t ARGB;
 		Vector2 UV;
 	};
+
+	// how UVs are interpolated
+	enum class Mapping
+	{
+		kNone,       // Gouraud only
+		kAffine,     // linear in screen space (cheap, wobbles like it's 1996)
+		kPerspective // linear in view space
+	};
+
+	// texels are modulated by the (Gouraud) vertex colors, use white for plain texture mapping
+	struct Material
+	{
+		Mapping mapping = Mapping::kNone;
+		const uint32_t *pTexture = nullptr;
+		unsigned texResX = 0, texResY = 0; // powers of 2 (UVs wrap)
+		bool depthTest = true;             // test & write
+		bool cullBackfaces = true;         // front faces are clockwise (on screen)
+	};
 }
 
 #endif // CKD_RETRO3D_PRIMITIVES
@@ -6,5 +6,6 @@
 
 #include "primitives.h"
 #include "tri-filler.h"
+#include "vertex-stage.h"
 
 #endif
@@ -0,0 +1,681 @@
+// cookiedough -- half-space triangle filler(s)
+
+#include "../main.h"
+#include "../alloc-large.h"
+#include "tri-filler.h"
+
+namespace retro3D
+{
+	// faces per set up & binning tile
+	constexpr size_t kChunkFaces = 1024;
+
+	// 'value = base + dX*x + dY*y' (x & y in pixels)
+	struct Plane
+	{
+		float base, dX, dY;
+
+		// values of 4 horizontally adjacent pixel centers, starting at (iX, iY)
+		CKD_INLINE __m128 Get4(unsigned iX, unsigned iY) const
+		{
+			const __m128 offsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+			const __m128 X = _mm_add_ps(_mm_set1_ps(float(iX)), offsets);
+			return _mm_add_ps(_mm_set1_ps(base + dY*(iY+0.5f)), _mm_mul_ps(_mm_set1_ps(dX), X));
+		}
+
+		// range over pixel centers in a rectangle (inclusive)
+		CKD_INLINE void GetRange(int minX, int minY, int maxX, int maxY, float &minValue, float &maxValue) const
+		{
+			const float X0 = dX*(minX+0.5f), X1 = dX*(maxX+0.5f);
+			const float Y0 = dY*(minY+0.5f), Y1 = dY*(maxY+0.5f);
+			minValue = base + std::min(X0, X1) + std::min(Y0, Y1);
+			maxValue = base + std::max(X0, X1) + std::max(Y0, Y1);
+		}
+	};
+
+	struct TriFiller::Triangle
+	{
+		// edge functions: 'A*X + B*Y + C' (28.4), inside if not negative (fill rule bias included)
+		int64_t edgeA[3], edgeB[3], edgeC[3];
+
+		// pixels (inclusive, on screen)
+		int minX, minY, maxX, maxY;
+
+		// projZ, A/R/G/B (Gouraud), U & V (or U/Z & V/Z if perspective correct)
+		Plane Z, color[4], U, V;
+
+		const Material *pMaterial;
+	};
+
+	// vertex in pixels (for clipping & set up)
+	struct SetUpVertex
+	{
+		float X, Y;
+		float Z;
+		float color[4]; // A, R, G, B
+		float U, V;     // divided by Z if perspective correct
+	};
+
+	static SetUpVertex ToSetUp(const Projected &vertex, Mapping mapping)
+	{
+		SetUpVertex result;
+		result.X = float(vertex.iX)*(1.f/kSubPixelOne);
+		result.Y = float(vertex.iY)*(1.f/kSubPixelOne);
+		result.Z = vertex.projZ;
+
+		for (int iChannel = 0; iChannel < 4; ++iChannel)
+			result.color[iChannel] = float((vertex.ARGB >> (24 - iChannel*8)) & 0xff);
+
+		const float perspective = (Mapping::kPerspective == mapping) ? vertex.projZ : 1.f;
+		result.U = vertex.UV.x*perspective;
+		result.V = vertex.UV.y*perspective;
+
+		return result;
+	}
+
+	// everything is linear in screen space, at least after the division by Z
+	static SetUpVertex Lerp(const SetUpVertex &from, const SetUpVertex &to, float t)
+	{
+		SetUpVertex result;
+		result.X = lerpf(from.X, to.X, t);
+		result.Y = lerpf(from.Y, to.Y, t);
+		result.Z = lerpf(from.Z, to.Z, t);
+
+		for (int iChannel = 0; iChannel < 4; ++iChannel)
+			result.color[iChannel] = lerpf(from.color[iChannel], to.color[iChannel], t);
+
+		result.U = lerpf(from.U, to.U, t);
+		result.V = lerpf(from.V, to.V, t);
+
+		return result;
+	}
+
+	static Plane SetUpPlane(const SetUpVertex &V0, float value0, const SetUpVertex &V1, float value1, const SetUpVertex &V2, float value2, float invArea)
+	{
+		const float E1X = V1.X-V0.X, E1Y = V1.Y-V0.Y;
+		const float E2X = V2.X-V0.X, E2Y = V2.Y-V0.Y;
+		const float delta1 = value1-value0, delta2 = value2-value0;
+
+		Plane plane;
+		plane.dX = (delta1*E2Y - delta2*E1Y)*invArea;
+		plane.dY = (delta2*E1X - delta1*E2X)*invArea;
+		plane.base = value0 - plane.dX*V0.X - plane.dY*V0.Y;
+		return plane;
+	}
+
+	TriFiller::TriFiller() :
+		m_graph("retro3D")
+	{
+	}
+
+	TriFiller::~TriFiller()
+	{
+		freeLarge(m_pDepth);
+	}
+
+	void TriFiller::Begin(uint32_t *pDest, unsigned resX, unsigned resY)
+	{
+		VIZ_ASSERT(nullptr != pDest && 0 == (resX & 3));
+
+		m_pDest = pDest;
+		m_resX = resX;
+		m_resY = resY;
+		m_numTilesX = NumBands(resX, kTileResX);
+		m_numTilesY = NumBands(resY, kTileResY);
+
+		const size_t depthSize = size_t(resX)*resY;
+		if (depthSize > m_depthSize)
+		{
+			freeLarge(m_pDepth);
+			m_pDepth = static_cast<float*>(mallocLarge(depthSize*sizeof(float), "retro3D"));
+			m_depthSize = depthSize;
+		}
+
+		// keep last frame's hierarchy for IsOccluded() unless the resolution changed
+		const unsigned numBlocksX = NumBands(resX, kBlockRes), numBlocksY = NumBands(resY, kBlockRes);
+		if (numBlocksX != m_numBlocksX || numBlocksY != m_numBlocksY)
+		{
+			m_numBlocksX = numBlocksX;
+			m_numBlocksY = numBlocksY;
+			m_blockMin.assign(numBlocksX*numBlocksY, 0.f);
+			m_blockMax.assign(numBlocksX*numBlocksY, 0.f);
+		}
+
+		m_tileStats.resize(m_numTilesX*m_numTilesY);
+
+		m_batches.clear();
+		m_numFaces = 0;
+	}
+
+	void TriFiller::Add(const Projected *pVertices, const Face *pFaces, size_t numFaces, const Material &material)
+	{
+		VIZ_ASSERT(nullptr != m_pDest);
+		VIZ_ASSERT(Mapping::kNone == material.mapping || nullptr != material.pTexture);
+		VIZ_ASSERT(Mapping::kNone == material.mapping || (0 == (material.texResX & (material.texResX-1)) && 0 == (material.texResY & (material.texResY-1))));
+
+		if (0 == numFaces)
+			return;
+
+		m_batches.push_back({ pVertices, pFaces, m_numFaces, &material });
+		m_numFaces += numFaces;
+	}
+
+	void TriFiller::SetUp(const Projected &A, const Projected &B, const Projected &C, const Material &material, Chunk &chunk)
+	{
+		// trivial reject (off screen)
+		const int minX = std::min(A.iX, std::min(B.iX, C.iX)), maxX = std::max(A.iX, std::max(B.iX, C.iX));
+		const int minY = std::min(A.iY, std::min(B.iY, C.iY)), maxY = std::max(A.iY, std::max(B.iY, C.iY));
+		if (maxX < 0 || maxY < 0 || minX >= int(m_resX)<<kSubPixelBits || minY >= int(m_resY)<<kSubPixelBits)
+			return;
+
+		SetUpVertex polygon[9] = { ToSetUp(A, material.mapping), ToSetUp(B, material.mapping), ToSetUp(C, material.mapping) };
+		unsigned numVertices = 3;
+
+		const int guardMin = -kGuardBand<<kSubPixelBits;
+		const int guardMaxX = (int(m_resX)+kGuardBand)<<kSubPixelBits, guardMaxY = (int(m_resY)+kGuardBand)<<kSubPixelBits;
+		if (minX < guardMin || minY < guardMin || maxX > guardMaxX || maxY > guardMaxY)
+		{
+			// clip to guard band (Sutherland-Hodgman): 'inside' is the signed distance to a side (negative is outside)
+			const float guardLeft = -float(kGuardBand), guardTop = -float(kGuardBand);
+			const float guardRight = float(m_resX+kGuardBand), guardBottom = float(m_resY+kGuardBand);
+
+			auto clip = [&](auto inside)
+			{
+				SetUpVertex clipped[9];
+				unsigned numClipped = 0;
+
+				for (unsigned iVertex = 0; iVertex < numVertices; ++iVertex)
+				{
+					const SetUpVertex &from = polygon[iVertex];
+					const SetUpVertex &to = polygon[(iVertex+1) % numVertices];
+					const float fromIn = inside(from), toIn = inside(to);
+
+					if (fromIn >= 0.f)
+						clipped[numClipped++] = from;
+
+					if ((fromIn >= 0.f) != (toIn >= 0.f))
+						clipped[numClipped++] = Lerp(from, to, fromIn/(fromIn-toIn));
+				}
+
+				std::copy(clipped, clipped+numClipped, polygon);
+				numVertices = numClipped;
+			};
+
+			clip([=](const SetUpVertex &vertex) { return vertex.X-guardLeft; });
+			clip([=](const SetUpVertex &vertex) { return guardRight-vertex.X; });
+			clip([=](const SetUpVertex &vertex) { return vertex.Y-guardTop; });
+			clip([=](const SetUpVertex &vertex) { return guardBottom-vertex.Y; });
+		}
+
+		// (fan of) triangle(s)
+		for (unsigned iVertex = 2; iVertex < numVertices; ++iVertex)
+		{
+			const SetUpVertex *pVertices[3] = { &polygon[0], &polygon[iVertex-1], &polygon[iVertex] };
+
+			int64_t X[3], Y[3];
+			for (int iCorner = 0; iCorner < 3; ++iCorner)
+			{
+				X[iCorner] = ToSubPixel(pVertices[iCorner]->X);
+				Y[iCorner] = ToSubPixel(pVertices[iCorner]->Y);
+			}
+
+			// clockwise (on screen) is positive
+			int64_t area = (X[1]-X[0])*(Y[2]-Y[0]) - (X[2]-X[0])*(Y[1]-Y[0]);
+			if (0 == area || (area < 0 && true == material.cullBackfaces))
+				continue;
+
+			if (area < 0)
+			{
+				std::swap(X[1], X[2]);
+				std::swap(Y[1], Y[2]);
+				std::swap(pVertices[1], pVertices[2]);
+				area = -area;
+			}
+
+			Triangle triangle;
+			triangle.pMaterial = &material;
+
+			// pixels whose center is inside the bounding box
+			const int64_t boxMinX = std::min(X[0], std::min(X[1], X[2])), boxMaxX = std::max(X[0], std::max(X[1], X[2]));
+			const int64_t boxMinY = std::min(Y[0], std::min(Y[1], Y[2])), boxMaxY = std::max(Y[0], std::max(Y[1], Y[2]));
+			constexpr int64_t kHalf = kSubPixelOne>>1;
+			triangle.minX = std::max(0, int((boxMinX - kHalf + kSubPixelOne-1) >> kSubPixelBits));
+			triangle.minY = std::max(0, int((boxMinY - kHalf + kSubPixelOne-1) >> kSubPixelBits));
+			triangle.maxX = std::min(int(m_resX)-1, int((boxMaxX - kHalf) >> kSubPixelBits));
+			triangle.maxY = std::min(int(m_resY)-1, int((boxMaxY - kHalf) >> kSubPixelBits));
+			if (triangle.minX > triangle.maxX || triangle.minY > triangle.maxY)
+				continue;
+
+			for (int iEdge = 0; iEdge < 3; ++iEdge)
+			{
+				const int iFrom = iEdge, iTo = (iEdge+1) % 3;
+				const int64_t dX = X[iTo]-X[iFrom], dY = Y[iTo]-Y[iFrom];
+
+				// top-left fill rule: pixel centers exactly on an edge belong to the triangle if it's a top or left edge
+				const bool topLeft = dY < 0 || (0 == dY && dX > 0);
+
+				triangle.edgeA[iEdge] = -dY;
+				triangle.edgeB[iEdge] = dX;
+				triangle.edgeC[iEdge] = dY*X[iFrom] - dX*Y[iFrom] - (topLeft ? 0 : 1);
+			}
+
+			const SetUpVertex &V0 = *pVertices[0], &V1 = *pVertices[1], &V2 = *pVertices[2];
+			const float invArea = float(kSubPixelOne*kSubPixelOne)/float(area);
+
+			triangle.Z = SetUpPlane(V0, V0.Z, V1, V1.Z, V2, V2.Z, invArea);
+
+			for (int iChannel = 0; iChannel < 4; ++iChannel)
+				triangle.color[iChannel] = SetUpPlane(V0, V0.color[iChannel], V1, V1.color[iChannel], V2, V2.color[iChannel], invArea);
+
+			triangle.U = triangle.V = { 0.f, 0.f, 0.f };
+			if (Mapping::kNone != material.mapping)
+			{
+				triangle.U = SetUpPlane(V0, V0.U, V1, V1.U, V2, V2.U, invArea);
+				triangle.V = SetUpPlane(V0, V0.V, V1, V1.V, V2, V2.V, invArea);
+			}
+
+			chunk.triangles.push_back(triangle);
+			Bin(chunk.triangles.back(), unsigned(chunk.triangles.size()-1), chunk);
+		}
+	}
+
+	// largest value of edge function over pixel centers in a rectangle (inclusive)
+	CKD_INLINE static int64_t EdgeMax(int64_t A, int64_t B, int64_t C, int minX, int minY, int maxX, int maxY)
+	{
+		constexpr int64_t kHalf = kSubPixelOne>>1;
+		const int64_t X0 = (int64_t(minX)<<kSubPixelBits) + kHalf, X1 = (int64_t(maxX)<<kSubPixelBits) + kHalf;
+		const int64_t Y0 = (int64_t(minY)<<kSubPixelBits) + kHalf, Y1 = (int64_t(maxY)<<kSubPixelBits) + kHalf;
+		return C + std::max(A*X0, A*X1) + std::max(B*Y0, B*Y1);
+	}
+
+	CKD_INLINE static int64_t EdgeMin(int64_t A, int64_t B, int64_t C, int minX, int minY, int maxX, int maxY)
+	{
+		return -EdgeMax(-A, -B, -C, minX, minY, maxX, maxY);
+	}
+
+	void TriFiller::Bin(const Triangle &triangle, unsigned index, Chunk &chunk)
+	{
+		const unsigned firstTileX = triangle.minX/kTileResX, lastTileX = triangle.maxX/kTileResX;
+		const unsigned firstTileY = triangle.minY/kTileResY, lastTileY = triangle.maxY/kTileResY;
+
+		for (unsigned iTileY = firstTileY; iTileY <= lastTileY; ++iTileY)
+		{
+			const int tileMinY = std::max<int>(iTileY*kTileResY, triangle.minY);
+			const int tileMaxY = std::min<int>((iTileY+1)*kTileResY-1, triangle.maxY);
+
+			for (unsigned iTileX = firstTileX; iTileX <= lastTileX; ++iTileX)
+			{
+				const int tileMinX = std::max<int>(iTileX*kTileResX, triangle.minX);
+				const int tileMaxX = std::min<int>((iTileX+1)*kTileResX-1, triangle.maxX);
+
+				// big triangles cover lots of tiles in their bounding box that they don't touch
+				bool touches = true;
+				for (int iEdge = 0; iEdge < 3 && true == touches; ++iEdge)
+					touches = EdgeMax(triangle.edgeA[iEdge], triangle.edgeB[iEdge], triangle.edgeC[iEdge], tileMinX, tileMinY, tileMaxX, tileMaxY) >= 0;
+
+				if (true == touches)
+					chunk.bins[iTileY*m_numTilesX + iTileX].push_back(index);
+			}
+		}
+	}
+
+	// nearest texel, wrapped
+	CKD_INLINE static __m128i Texel4(const Material &material, __m128 U, __m128 V, int mask)
+	{
+		const __m128i texU = _mm_and_si128(_mm_cvttps_epi32(_mm_floor_ps(_mm_mul_ps(U, _mm_set1_ps(float(material.texResX))))), _mm_set1_epi32(material.texResX-1));
+		const __m128i texV = _mm_and_si128(_mm_cvttps_epi32(_mm_floor_ps(_mm_mul_ps(V, _mm_set1_ps(float(material.texResY))))), _mm_set1_epi32(material.texResY-1));
+		const __m128i indices = _mm_add_epi32(_mm_mullo_epi32(texV, _mm_set1_epi32(material.texResX)), texU);
+
+		alignas(16) int index[4];
+		alignas(16) uint32_t texels[4] = { 0 };
+		_mm_store_si128(reinterpret_cast<__m128i*>(index), indices);
+
+		for (int iLane = 0; iLane < 4; ++iLane)
+			if (mask & (1 << iLane))
+				texels[iLane] = material.pTexture[index[iLane]];
+
+		return _mm_load_si128(reinterpret_cast<const __m128i*>(texels));
+	}
+
+	// conservative margin for depth hierarchy tests (corners versus interpolated per pixel)
+	constexpr float kHiZMargin = 1e-5f;
+
+	// fills (part of) an 8x8 block, only tests edges in 'activeEdges' (bits), returns true if any pixel was written
+	bool TriFiller::FillBlock(const Triangle &triangle, unsigned activeEdges, int minX, int minY, int maxX, int maxY, bool testDepth)
+	{
+		const Material &material = *triangle.pMaterial;
+		const bool textured = Mapping::kNone != material.mapping;
+		const bool perspective = Mapping::kPerspective == material.mapping;
+
+		// edge functions at (minX, minY) and per group of 4 and per row steps (all within 32 bits, see kGuardBand)
+		const __m128i laneSteps = _mm_setr_epi32(0, 1, 2, 3);
+		__m128i rowEdges[3], groupSteps[3], rowSteps[3];
+		for (int iEdge = 0; iEdge < 3; ++iEdge)
+		{
+			int edge = 0, stepX = 0, stepY = 0;
+			if (activeEdges & (1 << iEdge))
+			{
+				constexpr int64_t kHalf = kSubPixelOne>>1;
+				const int64_t A = triangle.edgeA[iEdge], B = triangle.edgeB[iEdge], C = triangle.edgeC[iEdge];
+				edge = int(A*((int64_t(minX)<<kSubPixelBits) + kHalf) + B*((int64_t(minY)<<kSubPixelBits) + kHalf) + C);
+				stepX = int(A<<kSubPixelBits);
+				stepY = int(B<<kSubPixelBits);
+			}
+
+			rowEdges[iEdge] = _mm_add_epi32(_mm_set1_epi32(edge), _mm_mullo_epi32(laneSteps, _mm_set1_epi32(stepX)));
+			groupSteps[iEdge] = _mm_set1_epi32(stepX*4);
+			rowSteps[iEdge] = _mm_set1_epi32(stepY);
+		}
+
+		const __m128 groupStepZ = _mm_set1_ps(triangle.Z.dX*4.f);
+		const __m128 groupStepU = _mm_set1_ps(triangle.U.dX*4.f), groupStepV = _mm_set1_ps(triangle.V.dX*4.f);
+		__m128 groupStepsColor[4];
+		for (int iChannel = 0; iChannel < 4; ++iChannel)
+			groupStepsColor[iChannel] = _mm_set1_ps(triangle.color[iChannel].dX*4.f);
+
+		bool written = false;
+
+		for (int iY = minY; iY <= maxY; ++iY)
+		{
+			uint32_t *pDest = m_pDest + iY*m_resX;
+			float *pDepth = m_pDepth + iY*m_resX;
+
+			__m128i E0 = rowEdges[0], E1 = rowEdges[1], E2 = rowEdges[2];
+
+			__m128 Z = triangle.Z.Get4(minX, iY);
+			__m128 U = _mm_setzero_ps(), V = _mm_setzero_ps();
+			if (true == textured)
+			{
+				U = triangle.U.Get4(minX, iY);
+				V = triangle.V.Get4(minX, iY);
+			}
+
+			__m128 colors[4];
+			for (int iChannel = 0; iChannel < 4; ++iChannel)
+				colors[iChannel] = triangle.color[iChannel].Get4(minX, iY);
+
+			for (int iX = minX; iX <= maxX; iX += 4)
+			{
+				// inside if none of the edge functions is negative
+				__m128i inside = _mm_cmpgt_epi32(_mm_or_si128(_mm_or_si128(E0, E1), E2), _mm_set1_epi32(-1));
+
+				if (true == material.depthTest)
+				{
+					const __m128 depth = _mm_loadu_ps(pDepth+iX);
+					if (true == testDepth)
+						inside = _mm_and_si128(inside, _mm_castps_si128(_mm_cmpgt_ps(Z, depth)));
+
+					_mm_storeu_ps(pDepth+iX, _mm_blendv_ps(depth, Z, _mm_castsi128_ps(inside)));
+				}
+
+				const int mask = _mm_movemask_ps(_mm_castsi128_ps(inside));
+				if (0 != mask)
+				{
+					__m128 A = colors[0], R = colors[1], G = colors[2], B = colors[3];
+
+					if (true == textured)
+					{
+						__m128 texU = U, texV = V;
+						if (true == perspective)
+						{
+							texU = _mm_div_ps(U, Z);
+							texV = _mm_div_ps(V, Z);
+						}
+
+						// modulate
+						const __m128i texels = Texel4(material, texU, texV, mask);
+						const __m128 scale = _mm_set1_ps(1.f/255.f);
+						const __m128i channelMask = _mm_set1_epi32(0xff);
+						A = _mm_mul_ps(_mm_mul_ps(A, scale), _mm_cvtepi32_ps(_mm_srli_epi32(texels, 24)));
+						R = _mm_mul_ps(_mm_mul_ps(R, scale), _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 16), channelMask)));
+						G = _mm_mul_ps(_mm_mul_ps(G, scale), _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(texels, 8), channelMask)));
+						B = _mm_mul_ps(_mm_mul_ps(B, scale), _mm_cvtepi32_ps(_mm_and_si128(texels, channelMask)));
+					}
+
+					// to 8-bit (rounded, clamped since pixel centers may lie a hair outside the triangle)
+					auto toChannel = [](__m128 value)
+					{
+						value = _mm_min_ps(_mm_max_ps(_mm_add_ps(value, _mm_set1_ps(0.5f)), _mm_setzero_ps()), _mm_set1_ps(255.f));
+						return _mm_cvttps_epi32(value);
+					};
+
+					const __m128i pixels = _mm_or_si128(
+						_mm_or_si128(_mm_slli_epi32(toChannel(A), 24), _mm_slli_epi32(toChannel(R), 16)),
+						_mm_or_si128(_mm_slli_epi32(toChannel(G), 8), toChannel(B)));
+
+					__m128i *pPixels = reinterpret_cast<__m128i*>(pDest+iX);
+					_mm_storeu_si128(pPixels, _mm_blendv_epi8(_mm_loadu_si128(pPixels), pixels, inside));
+
+					written = true;
+				}
+
+				E0 = _mm_add_epi32(E0, groupSteps[0]);
+				E1 = _mm_add_epi32(E1, groupSteps[1]);
+				E2 = _mm_add_epi32(E2, groupSteps[2]);
+
+				Z = _mm_add_ps(Z, groupStepZ);
+				if (true == textured)
+				{
+					U = _mm_add_ps(U, groupStepU);
+					V = _mm_add_ps(V, groupStepV);
+				}
+
+				for (int iChannel = 0; iChannel < 4; ++iChannel)
+					colors[iChannel] = _mm_add_ps(colors[iChannel], groupStepsColor[iChannel]);
+			}
+
+			for (int iEdge = 0; iEdge < 3; ++iEdge)
+				rowEdges[iEdge] = _mm_add_epi32(rowEdges[iEdge], rowSteps[iEdge]);
+		}
+
+		return written;
+	}
+
+	void TriFiller::FillTile(unsigned iTile)
+	{
+		const int tileMinX = (iTile % m_numTilesX)*kTileResX, tileMinY = (iTile / m_numTilesX)*kTileResY;
+		const int tileMaxX = std::min<int>(tileMinX+kTileResX, m_resX)-1, tileMaxY = std::min<int>(tileMinY+kTileResY, m_resY)-1;
+
+		// clear depth (zero is infinitely far away)
+		for (int iY = tileMinY; iY <= tileMaxY; ++iY)
+			std::fill(m_pDepth + iY*m_resX + tileMinX, m_pDepth + iY*m_resX + tileMaxX+1, 0.f);
+
+		// and it's hierarchy
+		for (int iBlockY = tileMinY/kBlockRes; iBlockY <= tileMaxY/kBlockRes; ++iBlockY)
+		{
+			for (int iBlockX = tileMinX/kBlockRes; iBlockX <= tileMaxX/kBlockRes; ++iBlockX)
+			{
+				const size_t iBlock = iBlockY*m_numBlocksX + iBlockX;
+				m_blockMin[iBlock] = m_blockMax[iBlock] = 0.f;
+			}
+		}
+
+		// farthest depth in tile (lower bound)
+		float tileMin = 0.f;
+
+		OcclusionStats &stats = m_tileStats[iTile];
+		stats = { 0 };
+
+		for (const Chunk &chunk : m_chunks)
+		{
+			for (unsigned index : chunk.bins[iTile])
+			{
+				const Triangle &triangle = chunk.triangles[index];
+				const bool depthTest = triangle.pMaterial->depthTest;
+
+				// rectangle to fill, whole groups of 4 pixels (which stay within the tile & screen)
+				const int minX = std::max(tileMinX, triangle.minX) & ~3, maxX = std::min(tileMaxX, triangle.maxX) | 3;
+				const int minY = std::max(tileMinY, triangle.minY), maxY = std::min(tileMaxY, triangle.maxY);
+
+				// entirely behind what's in the tile?
+				float minZ, maxZ;
+				triangle.Z.GetRange(minX, minY, maxX, maxY, minZ, maxZ);
+				if (true == depthTest && maxZ*(1.f+kHiZMargin) <= tileMin)
+				{
+					++stats.numTriangles;
+					continue;
+				}
+
+				unsigned activeEdges = 0;
+				bool rejected = false;
+				for (int iEdge = 0; iEdge < 3; ++iEdge)
+				{
+					const int64_t A = triangle.edgeA[iEdge], B = triangle.edgeB[iEdge], C = triangle.edgeC[iEdge];
+
+					if (EdgeMax(A, B, C, minX, minY, maxX, maxY) < 0)
+					{
+						rejected = true;
+						break;
+					}
+
+					// not trivially inside?
+					if (EdgeMin(A, B, C, minX, minY, maxX, maxY) < 0)
+						activeEdges |= 1 << iEdge;
+				}
+
+				if (true == rejected)
+					continue;
+
+				// 8x8 blocks
+				bool raised = false;
+				for (int blockY = minY & ~(kBlockRes-1); blockY <= maxY; blockY += kBlockRes)
+				{
+					for (int blockX = minX & ~(kBlockRes-1); blockX <= maxX; blockX += kBlockRes)
+					{
+						const int blockMinX = std::max(blockX, minX), blockMaxX = std::min(blockX+kBlockRes-1, maxX);
+						const int blockMinY = std::max(blockY, minY), blockMaxY = std::min(blockY+kBlockRes-1, maxY);
+
+						const size_t iBlock = (blockY/kBlockRes)*m_numBlocksX + blockX/kBlockRes;
+						float &blockMin = m_blockMin[iBlock], &blockMax = m_blockMax[iBlock];
+
+						float blockMinZ, blockMaxZ;
+						triangle.Z.GetRange(blockMinX, blockMinY, blockMaxX, blockMaxY, blockMinZ, blockMaxZ);
+						if (true == depthTest && blockMaxZ*(1.f+kHiZMargin) <= blockMin)
+						{
+							++stats.numBlocks;
+							continue;
+						}
+
+						unsigned blockEdges = 0;
+						bool outside = false;
+						for (int iEdge = 0; iEdge < 3 && false == outside; ++iEdge)
+						{
+							if (activeEdges & (1 << iEdge))
+							{
+								const int64_t A = triangle.edgeA[iEdge], B = triangle.edgeB[iEdge], C = triangle.edgeC[iEdge];
+								outside = EdgeMax(A, B, C, blockMinX, blockMinY, blockMaxX, blockMaxY) < 0;
+								if (EdgeMin(A, B, C, blockMinX, blockMinY, blockMaxX, blockMaxY) < 0)
+									blockEdges |= 1 << iEdge;
+							}
+						}
+
+						if (true == outside)
+							continue;
+
+						// entirely in front of what's in the block: skip the test
+						const bool testDepth = true == depthTest && blockMinZ*(1.f-kHiZMargin) <= blockMax;
+
+						if (true == FillBlock(triangle, blockEdges, blockMinX, blockMinY, blockMaxX, blockMaxY, testDepth) && true == depthTest)
+						{
+							blockMax = std::max(blockMax, blockMaxZ*(1.f+kHiZMargin));
+
+							// covers the entire block: nothing in it is farther away than the triangle now
+							const bool covers = 0 == blockEdges &&
+								blockMinX == blockX && blockMaxX == std::min(blockX+kBlockRes-1, tileMaxX) &&
+								blockMinY == blockY && blockMaxY == std::min(blockY+kBlockRes-1, tileMaxY);
+
+							if (true == covers && blockMinZ*(1.f-kHiZMargin) > blockMin)
+							{
+								blockMin = blockMinZ*(1.f-kHiZMargin);
+								raised = true;
+							}
+						}
+					}
+				}
+
+				if (true == raised)
+				{
+					tileMin = std::numeric_limits<float>::max();
+					for (int iBlockY = tileMinY/kBlockRes; iBlockY <= tileMaxY/kBlockRes; ++iBlockY)
+						for (int iBlockX = tileMinX/kBlockRes; iBlockX <= tileMaxX/kBlockRes; ++iBlockX)
+							tileMin = std::min(tileMin, m_blockMin[iBlockY*m_numBlocksX + iBlockX]);
+				}
+			}
+		}
+	}
+
+	void TriFiller::Flush()
+	{
+		VIZ_ASSERT(nullptr != m_pDest);
+
+		const unsigned numTiles = m_numTilesX*m_numTilesY;
+		const unsigned numChunks = std::max(1u, NumBands(m_numFaces, kChunkFaces)); // tiles must be filled (depth cleared) regardless
+
+		// keeps allocations around from frame to frame
+		if (m_chunks.size() < numChunks)
+			m_chunks.resize(numChunks);
+
+		for (Chunk &chunk : m_chunks)
+		{
+			chunk.triangles.clear();
+			chunk.bins.resize(numTiles);
+			for (auto &bin : chunk.bins)
+				bin.clear();
+		}
+
+		const auto binned = m_graph.Add("set up & bin", numChunks, [this](unsigned iChunk)
+		{
+			Chunk &chunk = m_chunks[iChunk];
+
+			const size_t firstFace = iChunk*kChunkFaces;
+			const size_t endFace = std::min(firstFace+kChunkFaces, m_numFaces);
+			if (firstFace >= endFace)
+				return;
+
+			// find first batch
+			auto iBatch = std::upper_bound(m_batches.begin(), m_batches.end(), firstFace, [](size_t face, const Batch &batch) { return face < batch.firstFace; }) - 1;
+
+			for (size_t iFace = firstFace; iFace < endFace; ++iFace)
+			{
+				while (iBatch+1 != m_batches.end() && iFace >= (iBatch+1)->firstFace)
+					++iBatch;
+
+				const Face &face = iBatch->pFaces[iFace - iBatch->firstFace];
+				const Projected *pVertices = iBatch->pVertices;
+				SetUp(pVertices[face.iA], pVertices[face.iB], pVertices[face.iC], *iBatch->pMaterial, chunk);
+			}
+		});
+
+		m_graph.Add("fill", numTiles, [this](unsigned iTile) { FillTile(iTile); }, { binned });
+
+		m_graph.Run();
+
+		m_occlusionStats = { 0 };
+		for (const OcclusionStats &stats : m_tileStats)
+		{
+			m_occlusionStats.numTriangles += stats.numTriangles;
+			m_occlusionStats.numBlocks += stats.numBlocks;
+		}
+	}
+
+	bool TriFiller::IsOccluded(int minX, int minY, int maxX, int maxY, float maxProjZ) const
+	{
+		minX = std::max(minX, 0);
+		minY = std::max(minY, 0);
+		maxX = std::min(maxX, int(m_resX)-1);
+		maxY = std::min(maxY, int(m_resY)-1);
+
+		// off screen is as good as occluded
+		if (minX > maxX || minY > maxY)
+			return true;
+
+		if (true == m_blockMin.empty())
+			return false;
+
+		for (int iBlockY = minY/kBlockRes; iBlockY <= maxY/kBlockRes; ++iBlockY)
+			for (int iBlockX = minX/kBlockRes; iBlockX <= maxX/kBlockRes; ++iBlockX)
+				if (maxProjZ > m_blockMin[iBlockY*m_numBlocksX + iBlockX])
+					return false;
+
+		return true;
+	}
+}
@@ -1,11 +1,130 @@
-
 // cookiedough -- half-space triangle filler(s)
 
+/*
+	Tile-binned half-space rasterizer:
+
+	TriFiller filler;
+	filler.Begin(pDest, g_resX, g_resY);
+	filler.Add(pVertices, pFaces, numFaces, material); // as often as you like
+	filler.Flush();
+
+	- Flush() does triangle setup & binning (in chunks of triangles) and then fills each screen tile (kTileResX by
+	  kTileResY pixels) on a single thread, in a task graph (see task-graph.h), so threads never share a tile and work
+	  is stolen when tiles are uneven
+	- within a tile triangles are filled in the order they were added, so without depth test it's painter's algorithm
+	- edge functions are exact (28.4 fixed point, see primitives.h) and follow the top-left fill rule: shared edges
+	  are filled exactly once, no cracks
+	- 4 pixels at a time: edge functions, depth (1/Z), Gouraud (ARGB) and affine or perspective correct UVs
+	- triangles are clipped to a guard band (kGuardBand pixels around the screen), but not to the near plane: projZ
+	  must be positive
+	- all buffers (vertices, faces, materials) must stay put until Flush() returns
+	- depth buffer is owned by the filler, Flush() clears it (per tile)
+	- occlusion: each tile keeps the depth range of it's 8x8 blocks (kBlockRes) while filling, so triangles and blocks
+	  that lie entirely behind what's been drawn are skipped before anything is interpolated, and blocks entirely in
+	  front of it skip the depth test; submit front to back (roughly) to make the most of it
+	- IsOccluded() tests a screen rectangle against that hierarchy as it was after the last Flush(), i.e. last frame
+	  (see IsOccluded() in vertex-stage.h for objects)
+*/
+
 #if !defined(CKD_RETRO3D_TRI_FILLER)
 #define CKD_RETRO3D_TRI_FILLER
 
+#include "primitives.h"
+#include "../task-graph.h"
+
 namespace retro3D
 {
+	constexpr unsigned kTileResX = 64;
+	constexpr unsigned kTileResY = 32;
+
+	// depth hierarchy block size (tiles are a multiple of it)
+	constexpr int kBlockRes = 8;
+
+	// keeps edge functions within 32 bits inside a tile
+	constexpr int kGuardBand = 4096;
+
+	class TriFiller
+	{
+	public:
+		TriFiller();
+		~TriFiller();
+
+		struct OcclusionStats
+		{
+			size_t numTriangles; // rejected per tile
+			size_t numBlocks;
+		};
+
+		TriFiller(const TriFiller &) = delete;
+		TriFiller &operator=(const TriFiller &) = delete;
+
+		// resolution: multiple of 4 horizontally ('pDest' is 'resX' pixels wide)
+		void Begin(uint32_t *pDest, unsigned resX, unsigned resY);
+
+		void Add(const Projected *pVertices, const Face *pFaces, size_t numFaces, const Material &material);
+		void Flush();
+
+		// valid after Flush(), until next Begin()
+		const float *GetDepth() const { return m_pDepth; }
+
+		unsigned GetResX() const { return m_resX; }
+		unsigned GetResY() const { return m_resY; }
+
+		unsigned GetNumTilesX() const { return m_numTilesX; }
+		unsigned GetNumTilesY() const { return m_numTilesY; }
+
+		// true if nothing in this rectangle (in pixels, inclusive) was farther away than 'maxProjZ' (nearest point of
+		// whatever you'd like to draw) after the last Flush()
+		bool IsOccluded(int minX, int minY, int maxX, int maxY, float maxProjZ) const;
+
+		const TaskGraph::Stats &GetStats() const { return m_graph.GetStats(); }
+		const OcclusionStats &GetOcclusionStats() const { return m_occlusionStats; }
+
+	private:
+		// post setup (edge functions & attribute planes)
+		struct Triangle;
+
+		struct Batch
+		{
+			const Projected *pVertices;
+			const Face *pFaces;
+			size_t firstFace; // in all faces added
+			const Material *pMaterial;
+		};
+
+		// a range of faces that's set up & binned as one
+		struct Chunk
+		{
+			std::vector<Triangle> triangles;
+			std::vector<std::vector<unsigned>> bins; // per tile, indices into 'triangles'
+		};
+
+		void SetUp(const Projected &A, const Projected &B, const Projected &C, const Material &material, Chunk &chunk);
+		void Bin(const Triangle &triangle, unsigned index, Chunk &chunk);
+		void FillTile(unsigned iTile);
+		bool FillBlock(const Triangle &triangle, unsigned activeEdges, int minX, int minY, int maxX, int maxY, bool testDepth);
+
+		uint32_t *m_pDest = nullptr;
+		float *m_pDepth = nullptr;
+		size_t m_depthSize = 0;
+
+		unsigned m_resX = 0, m_resY = 0;
+		unsigned m_numTilesX = 0, m_numTilesY = 0;
+
+		std::vector<Batch> m_batches;
+		size_t m_numFaces = 0;
+
+		std::vector<Chunk> m_chunks;
+
+		// depth hierarchy (per block): farthest (lower bound) & nearest (upper bound)
+		unsigned m_numBlocksX = 0, m_numBlocksY = 0;
+		std::vector<float> m_blockMin, m_blockMax;
+
+		std::vector<OcclusionStats> m_tileStats;
+		OcclusionStats m_occlusionStats = { 0 };
+
+		TaskGraph m_graph;
+	};
 }
 
 #endif // CKD_RETRO3D_TRI_FILLER
@@ -0,0 +1,384 @@
+// cookiedough -- vertex stage (transform, clip & project)
+
+#include "../main.h"
+#include "vertex-stage.h"
+#include "tri-filler.h" // for kGuardBand
+
+namespace retro3D
+{
+	// faces per band
+	constexpr size_t kBandFaces = 4096;
+
+	// face index refers to a vertex made by clipping (in the band)
+	constexpr unsigned kBandVertex = 1u<<31;
+
+	// outcodes
+	constexpr uint8_t kLeft   = 1;
+	constexpr uint8_t kRight  = 2;
+	constexpr uint8_t kBottom = 4;
+	constexpr uint8_t kTop    = 8;
+	constexpr uint8_t kNear   = 16;
+	constexpr uint8_t kFar    = 32;
+	constexpr uint8_t kGuard  = 64; // outside guard band (any side)
+
+	constexpr uint8_t kFrustum = kLeft|kRight|kBottom|kTop|kNear|kFar;
+	constexpr uint8_t kMustClip = kNear|kGuard;
+
+	void VertexStage::Process(
+		const Vertex *pVertices, size_t numVertices,
+		const Face *pFaces, size_t numFaces,
+		const Matrix44 &transform,
+		unsigned resX, unsigned resY,
+		const Material &material)
+	{
+		VIZ_ASSERT(nullptr != pVertices && nullptr != pFaces);
+		VIZ_ASSERT(numVertices < kBandVertex);
+
+		m_resX = resX;
+		m_resY = resY;
+
+		// a pixel is 2/res in clip space, so the guard band edge is at 1 + 2*guard/res
+		m_guardX = 1.f + 2.f*kGuardBand/resX;
+		m_guardY = 1.f + 2.f*kGuardBand/resY;
+
+		Transform(pVertices, numVertices, transform);
+
+		const unsigned numBands = NumBands(numFaces, kBandFaces);
+		if (m_bands.size() < numBands)
+			m_bands.resize(numBands);
+
+		#pragma omp parallel for schedule(static)
+		for (int iBand = 0; iBand < int(numBands); ++iBand)
+		{
+			const size_t firstFace = iBand*kBandFaces;
+			ProcessFaces(pVertices, pFaces+firstFace, std::min(kBandFaces, numFaces-firstFace), material, m_bands[iBand]);
+		}
+
+		// merge bands (in order)
+		m_faces.clear();
+		m_stats = { 0 };
+
+		for (unsigned iBand = 0; iBand < numBands; ++iBand)
+		{
+			const Band &band = m_bands[iBand];
+			const unsigned offset = unsigned(m_projected.size());
+
+			m_projected.insert(m_projected.end(), band.vertices.begin(), band.vertices.end());
+
+			for (Face face : band.faces)
+			{
+				for (unsigned *pIndex : { &face.iA, &face.iB, &face.iC })
+					if (*pIndex & kBandVertex)
+						*pIndex = offset + (*pIndex & ~kBandVertex);
+
+				m_faces.push_back(face);
+			}
+
+			m_stats.numRejected += band.stats.numRejected;
+			m_stats.numClipped += band.stats.numClipped;
+			m_stats.numBackfaces += band.stats.numBackfaces;
+			m_stats.numSmall += band.stats.numSmall;
+			m_stats.numEmitted += band.stats.numEmitted;
+		}
+	}
+
+	void VertexStage::Transform(const Vertex *pVertices, size_t numVertices, const Matrix44 &transform)
+	{
+		m_X.resize(numVertices);
+		m_Y.resize(numVertices);
+		m_Z.resize(numVertices);
+		m_W.resize(numVertices);
+		m_outcodes.resize(numVertices);
+
+		// clipped vertices are appended later (and Projected isn't default constructible)
+		if (m_projected.size() > numVertices)
+			m_projected.erase(m_projected.begin()+numVertices, m_projected.end());
+		else
+			m_projected.insert(m_projected.end(), numVertices-m_projected.size(), { 0, 0, 0.f, 0, Vector2(0.f, 0.f) });
+
+		if (0 == numVertices)
+			return;
+
+		const Vector4 *rows = transform.rows;
+
+		const __m128 halfResX = _mm_set1_ps(m_resX*0.5f), halfResY = _mm_set1_ps(m_resY*0.5f);
+		const __m128 subPixelOne = _mm_set1_ps(float(kSubPixelOne));
+		const __m128 guardX = _mm_set1_ps(m_guardX), guardY = _mm_set1_ps(m_guardY);
+
+		const int numBlocks = int(NumBands(numVertices, 4));
+
+		#pragma omp parallel for schedule(static)
+		for (int iBlock = 0; iBlock < numBlocks; ++iBlock)
+		{
+			// last block repeats last vertex
+			size_t indices[4];
+			for (int iLane = 0; iLane < 4; ++iLane)
+				indices[iLane] = std::min<size_t>(iBlock*4 + iLane, numVertices-1);
+
+			// AoS to SoA
+			const Vector3 &P0 = pVertices[indices[0]].position, &P1 = pVertices[indices[1]].position;
+			const Vector3 &P2 = pVertices[indices[2]].position, &P3 = pVertices[indices[3]].position;
+			const __m128 PX = _mm_setr_ps(P0.x, P1.x, P2.x, P3.x);
+			const __m128 PY = _mm_setr_ps(P0.y, P1.y, P2.y, P3.y);
+			const __m128 PZ = _mm_setr_ps(P0.z, P1.z, P2.z, P3.z);
+
+			auto dot = [&](const Vector4 &row)
+			{
+				const __m128 XY = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row.x), PX), _mm_mul_ps(_mm_set1_ps(row.y), PY));
+				const __m128 ZW = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(row.z), PZ), _mm_set1_ps(row.w));
+				return _mm_add_ps(XY, ZW);
+			};
+
+			const __m128 X = dot(rows[0]), Y = dot(rows[1]), Z = dot(rows[2]), W = dot(rows[3]);
+			const __m128 negW = _mm_sub_ps(_mm_setzero_ps(), W);
+
+			// outcodes
+			const int leftMask   = _mm_movemask_ps(_mm_cmplt_ps(X, negW));
+			const int rightMask  = _mm_movemask_ps(_mm_cmpgt_ps(X, W));
+			const int bottomMask = _mm_movemask_ps(_mm_cmplt_ps(Y, negW));
+			const int topMask    = _mm_movemask_ps(_mm_cmpgt_ps(Y, W));
+			const int nearMask   = _mm_movemask_ps(_mm_cmplt_ps(Z, _mm_setzero_ps()));
+			const int farMask    = _mm_movemask_ps(_mm_cmpgt_ps(Z, W));
+
+			const __m128 absX = _mm_andnot_ps(_mm_set1_ps(-0.f), X), absY = _mm_andnot_ps(_mm_set1_ps(-0.f), Y);
+			const int guardMask  = _mm_movemask_ps(_mm_or_ps(_mm_cmpgt_ps(absX, _mm_mul_ps(guardX, W)), _mm_cmpgt_ps(absY, _mm_mul_ps(guardY, W))));
+
+			// project (only meaningful for vertices in front, inside guard band; the rest gets clipped)
+			const __m128 invW = _mm_div_ps(_mm_set1_ps(1.f), W);
+			const __m128 screenX = _mm_add_ps(halfResX, _mm_mul_ps(_mm_mul_ps(X, invW), halfResX));
+			const __m128 screenY = _mm_sub_ps(halfResY, _mm_mul_ps(_mm_mul_ps(Y, invW), halfResY));
+			const __m128i iX = _mm_cvtps_epi32(_mm_mul_ps(screenX, subPixelOne));
+			const __m128i iY = _mm_cvtps_epi32(_mm_mul_ps(screenY, subPixelOne));
+
+			alignas(16) float soaX[4], soaY[4], soaZ[4], soaW[4], projZ[4];
+			alignas(16) int soaIX[4], soaIY[4];
+			_mm_store_ps(soaX, X);
+			_mm_store_ps(soaY, Y);
+			_mm_store_ps(soaZ, Z);
+			_mm_store_ps(soaW, W);
+			_mm_store_ps(projZ, invW);
+			_mm_store_si128(reinterpret_cast<__m128i*>(soaIX), iX);
+			_mm_store_si128(reinterpret_cast<__m128i*>(soaIY), iY);
+
+			for (int iLane = 0; iLane < 4; ++iLane)
+			{
+				const size_t index = iBlock*4 + iLane;
+				if (index >= numVertices)
+					break;
+
+				m_X[index] = soaX[iLane];
+				m_Y[index] = soaY[iLane];
+				m_Z[index] = soaZ[iLane];
+				m_W[index] = soaW[iLane];
+
+				const int bit = 1 << iLane;
+				m_outcodes[index] = uint8_t(
+					((leftMask & bit) ? kLeft : 0) | ((rightMask & bit) ? kRight : 0) |
+					((bottomMask & bit) ? kBottom : 0) | ((topMask & bit) ? kTop : 0) |
+					((nearMask & bit) ? kNear : 0) | ((farMask & bit) ? kFar : 0) |
+					((guardMask & bit) ? kGuard : 0));
+
+				const Vertex &vertex = pVertices[index];
+				m_projected[index] = { soaIX[iLane], soaIY[iLane], projZ[iLane], vertex.ARGB, vertex.UV };
+			}
+		}
+	}
+
+	VertexStage::ClipVertex VertexStage::ToClip(const Vertex &vertex, size_t index) const
+	{
+		ClipVertex result;
+		result.X = m_X[index];
+		result.Y = m_Y[index];
+		result.Z = m_Z[index];
+		result.W = m_W[index];
+
+		for (int iChannel = 0; iChannel < 4; ++iChannel)
+			result.color[iChannel] = float((vertex.ARGB >> (24 - iChannel*8)) & 0xff);
+
+		result.U = vertex.UV.x;
+		result.V = vertex.UV.y;
+		return result;
+	}
+
+	Projected VertexStage::Project(const ClipVertex &vertex) const
+	{
+		const float invW = 1.f/vertex.W;
+		const float halfResX = m_resX*0.5f, halfResY = m_resY*0.5f;
+
+		uint32_t ARGB = 0;
+		for (int iChannel = 0; iChannel < 4; ++iChannel)
+			ARGB = (ARGB << 8) | uint32_t(std::min(255.f, vertex.color[iChannel] + 0.5f));
+
+		return {
+			ToSubPixel(halfResX + vertex.X*invW*halfResX),
+			ToSubPixel(halfResY - vertex.Y*invW*halfResY),
+			invW,
+			ARGB,
+			Vector2(vertex.U, vertex.V)
+		};
+	}
+
+	// returns false if culled
+	bool VertexStage::Emit(const Projected &A, const Projected &B, const Projected &C, const Material &material, Stats &stats) const
+	{
+		// clockwise (on screen) is positive (as in TriFiller)
+		const int64_t area = int64_t(B.iX-A.iX)*(C.iY-A.iY) - int64_t(C.iX-A.iX)*(B.iY-A.iY);
+		if (area < 0 && true == material.cullBackfaces)
+		{
+			++stats.numBackfaces;
+			return false;
+		}
+
+		// covers no pixel center at all?
+		constexpr int kHalf = kSubPixelOne>>1;
+		const int minX = std::min(A.iX, std::min(B.iX, C.iX)), maxX = std::max(A.iX, std::max(B.iX, C.iX));
+		const int minY = std::min(A.iY, std::min(B.iY, C.iY)), maxY = std::max(A.iY, std::max(B.iY, C.iY));
+		if (0 == area ||
+			((minX - kHalf + kSubPixelOne-1) >> kSubPixelBits) > ((maxX - kHalf) >> kSubPixelBits) ||
+			((minY - kHalf + kSubPixelOne-1) >> kSubPixelBits) > ((maxY - kHalf) >> kSubPixelBits))
+		{
+			++stats.numSmall;
+			return false;
+		}
+
+		++stats.numEmitted;
+		return true;
+	}
+
+	void VertexStage::ProcessFaces(const Vertex *pVertices, const Face *pFaces, size_t numFaces, const Material &material, Band &band) const
+	{
+		band.faces.clear();
+		band.vertices.clear();
+		band.stats = { 0 };
+
+		for (size_t iFace = 0; iFace < numFaces; ++iFace)
+		{
+			const Face &face = pFaces[iFace];
+			const uint8_t codeA = m_outcodes[face.iA], codeB = m_outcodes[face.iB], codeC = m_outcodes[face.iC];
+
+			// all on the wrong side of the same plane?
+			if (0 != (codeA & codeB & codeC & kFrustum))
+			{
+				++band.stats.numRejected;
+				continue;
+			}
+
+			if (0 == ((codeA | codeB | codeC) & kMustClip))
+			{
+				if (true == Emit(m_projected[face.iA], m_projected[face.iB], m_projected[face.iC], material, band.stats))
+					band.faces.push_back(face);
+
+				continue;
+			}
+
+			++band.stats.numClipped;
+
+			// clip in homogeneous space (Sutherland-Hodgman), 'inside' is the signed distance to a plane
+			ClipVertex polygon[8] = { ToClip(pVertices[face.iA], face.iA), ToClip(pVertices[face.iB], face.iB), ToClip(pVertices[face.iC], face.iC) };
+			unsigned numVertices = 3;
+
+			auto clip = [&](auto inside)
+			{
+				ClipVertex clipped[8];
+				unsigned numClipped = 0;
+
+				for (unsigned iVertex = 0; iVertex < numVertices; ++iVertex)
+				{
+					const ClipVertex &from = polygon[iVertex];
+					const ClipVertex &to = polygon[(iVertex+1) % numVertices];
+					const float fromIn = inside(from), toIn = inside(to);
+
+					if (fromIn >= 0.f)
+						clipped[numClipped++] = from;
+
+					if ((fromIn >= 0.f) != (toIn >= 0.f))
+					{
+						const float t = fromIn/(fromIn-toIn);
+
+						ClipVertex &vertex = clipped[numClipped++];
+						vertex.X = lerpf(from.X, to.X, t);
+						vertex.Y = lerpf(from.Y, to.Y, t);
+						vertex.Z = lerpf(from.Z, to.Z, t);
+						vertex.W = lerpf(from.W, to.W, t);
+
+						for (int iChannel = 0; iChannel < 4; ++iChannel)
+							vertex.color[iChannel] = lerpf(from.color[iChannel], to.color[iChannel], t);
+
+						vertex.U = lerpf(from.U, to.U, t);
+						vertex.V = lerpf(from.V, to.V, t);
+					}
+				}
+
+				std::copy(clipped, clipped+numClipped, polygon);
+				numVertices = numClipped;
+			};
+
+			const float guardX = m_guardX, guardY = m_guardY;
+			clip([](const ClipVertex &vertex) { return vertex.Z; });
+			clip([=](const ClipVertex &vertex) { return vertex.X + guardX*vertex.W; });
+			clip([=](const ClipVertex &vertex) { return guardX*vertex.W - vertex.X; });
+			clip([=](const ClipVertex &vertex) { return vertex.Y + guardY*vertex.W; });
+			clip([=](const ClipVertex &vertex) { return guardY*vertex.W - vertex.Y; });
+
+			if (numVertices < 3)
+				continue;
+
+			const unsigned first = unsigned(band.vertices.size());
+			for (unsigned iVertex = 0; iVertex < numVertices; ++iVertex)
+				band.vertices.push_back(Project(polygon[iVertex]));
+
+			// fan
+			const Projected *pProjected = &band.vertices[first];
+			bool added = false;
+			for (unsigned iVertex = 2; iVertex < numVertices; ++iVertex)
+			{
+				if (true == Emit(pProjected[0], pProjected[iVertex-1], pProjected[iVertex], material, band.stats))
+				{
+					band.faces.push_back({ kBandVertex | first, kBandVertex | (first+iVertex-1), kBandVertex | (first+iVertex) });
+					added = true;
+				}
+			}
+
+			if (false == added)
+				band.vertices.erase(band.vertices.begin()+first, band.vertices.end());
+		}
+	}
+
+	bool IsOccluded(const TriFiller &filler, const Matrix44 &transform, const Vector3 &boxMin, const Vector3 &boxMax)
+	{
+		const float halfResX = filler.GetResX()*0.5f, halfResY = filler.GetResY()*0.5f;
+
+		float minX = std::numeric_limits<float>::max(), maxX = -minX;
+		float minY = minX, maxY = -minX;
+		float maxProjZ = 0.f;
+
+		for (int iCorner = 0; iCorner < 8; ++iCorner)
+		{
+			const Vector4 corner(
+				(iCorner & 1) ? boxMax.x : boxMin.x,
+				(iCorner & 2) ? boxMax.y : boxMin.y,
+				(iCorner & 4) ? boxMax.z : boxMin.z,
+				1.f);
+
+			const Vector4 clip = transform*corner;
+
+			// crosses the near plane: assume it's visible
+			if (clip.z < 0.f)
+				return false;
+
+			const float invW = 1.f/clip.w;
+			const float screenX = halfResX + clip.x*invW*halfResX;
+			const float screenY = halfResY - clip.y*invW*halfResY;
+
+			minX = std::min(minX, screenX);
+			maxX = std::max(maxX, screenX);
+			minY = std::min(minY, screenY);
+			maxY = std::max(maxY, screenY);
+			maxProjZ = std::max(maxProjZ, invW);
+		}
+
+		// stay clear of int. overflow, anything beyond the screen is clamped anyway
+		auto toPixel = [](float value) { return int(std::clamp(value, -1.f, 65536.f)); };
+		return filler.IsOccluded(toPixel(floorf(minX)), toPixel(floorf(minY)), toPixel(ceilf(maxX)), toPixel(ceilf(maxY)), maxProjZ);
+	}
+}
@@ -0,0 +1,97 @@
+// cookiedough -- vertex stage (transform, clip & project)
+
+/*
+	Batch vertex stage that feeds TriFiller:
+
+	VertexStage stage;
+	stage.Process(pVertices, numVertices, pFaces, numFaces, projection*view*model, g_resX, g_resY, material);
+	filler.Add(stage.GetVertices(), stage.GetFaces(), stage.GetNumFaces(), material);
+
+	- positions are converted to SoA and transformed 4 at a time (SSE), faces are processed in parallel bands
+	- Matrix44 is expected to include a Matrix44::Perspective() projection (clip space Z in [0, W], W is view Z)
+	- faces entirely outside the frustum are rejected, those crossing the near plane or the guard band (see
+	  kGuardBand) are clipped in homogeneous space (new vertices are appended to the output)
+	- back faces (if the material says so) and triangles that don't cover a single pixel center are culled
+	- output stays valid until the next Process(), so use a stage per mesh until TriFiller::Flush() is done
+	- IsOccluded() tests an object's bounding box against last frame's depth hierarchy, to skip it entirely; it's
+	  conservative, save for the fact that the camera and objects may have moved since
+*/
+
+#if !defined(CKD_RETRO3D_VERTEX_STAGE)
+#define CKD_RETRO3D_VERTEX_STAGE
+
+#include "primitives.h"
+
+namespace retro3D
+{
+	class TriFiller;
+
+	class VertexStage
+	{
+	public:
+		struct Stats
+		{
+			size_t numRejected;     // outside frustum
+			size_t numClipped;      // near plane or guard band
+			size_t numBackfaces;
+			size_t numSmall;        // no pixel center covered
+			size_t numEmitted;
+		};
+
+		void Process(
+			const Vertex *pVertices, size_t numVertices,
+			const Face *pFaces, size_t numFaces,
+			const Matrix44 &transform,
+			unsigned resX, unsigned resY,
+			const Material &material);
+
+		const Projected *GetVertices() const { return m_projected.data(); }
+		const Face *GetFaces() const { return m_faces.data(); }
+		size_t GetNumFaces() const { return m_faces.size(); }
+
+		const Stats &GetStats() const { return m_stats; }
+
+	private:
+		// vertex in clip space
+		struct ClipVertex
+		{
+			float X, Y, Z, W;
+			float color[4]; // A, R, G, B
+			float U, V;
+		};
+
+		// per band of faces, merged after
+		struct Band
+		{
+			std::vector<Face> faces;          // indices with kBandVertex set refer to 'vertices'
+			std::vector<Projected> vertices;  // made by clipping
+			Stats stats;
+		};
+
+		void Transform(const Vertex *pVertices, size_t numVertices, const Matrix44 &transform);
+		void ProcessFaces(const Vertex *pVertices, const Face *pFaces, size_t numFaces, const Material &material, Band &band) const;
+
+		ClipVertex ToClip(const Vertex &vertex, size_t index) const;
+		Projected Project(const ClipVertex &vertex) const;
+		bool Emit(const Projected &A, const Projected &B, const Projected &C, const Material &material, Stats &stats) const;
+
+		unsigned m_resX = 0, m_resY = 0;
+		float m_guardX = 0.f, m_guardY = 0.f; // guard band in clip space ('X <= guard*W')
+
+		// SoA, in clip space
+		std::vector<float> m_X, m_Y, m_Z, m_W;
+		std::vector<uint8_t> m_outcodes;
+
+		std::vector<Band> m_bands;
+
+		std::vector<Projected> m_projected;
+		std::vector<Face> m_faces;
+
+		Stats m_stats = { 0 };
+	};
+
+	// true if the bounding box (object space) is entirely hidden according to TriFiller::IsOccluded()
+	bool IsOccluded(const TriFiller &filler, const Matrix44 &transform, const Vector3 &boxMin, const Vector3 &boxMax);
+}
+
+#endif // CKD_RETRO3D_VERTEX_STAGE
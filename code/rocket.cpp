@@ -4,8 +4,21 @@
 #include "main.h"
 #include "rocket.h"
 #include "audio.h"
+#include "sync-bundle.h"
+
+#include <deque>
+#include <atomic>
+#include <mutex>
+#include <chrono>
+
+#include "triple-buffer.h"
+
+extern "C" {
+	#include "../3rdparty/rocket-stripped/lib/track.h"
+}
 
 static const char *kHost = "localhost";
+static const char *kSyncBase = "sync/";
 
 static sync_device *s_hRocket = nullptr;
 
@@ -21,11 +34,117 @@ static sync_cb s_rocketCallbacks = {
 
 namespace Rocket
 {
-	const sync_track *s_stopTrack;
+	struct Track
+	{
+		const sync_track *pTrack;
+		size_t index; // into Snapshot
+	};
+
+	// deque, so pointers (SyncTrack) stay put
+	static std::deque<Track> s_tracks;
+
+	// evaluated by Boost()
+	static Snapshot s_snapshot;
+
+	SyncTrack s_stopTrack;
+
+#if !defined(SYNC_PLAYER)
+
+	// editor: all networking (sync_update(), reconnecting) is done by a separate thread so a slow or stalled editor connection
+	// does not stall rendering; it publishes key edits as a full copy of all keys through a lock-free triple buffer, which
+	// means Boost() (and thus the render thread) always evaluates a consistent set of keys
+
+	typedef std::vector<std::vector<track_key>> KeySet;
+
+	static TripleBuffer<KeySet> s_keySets;
+	static KeySet s_publishedKeys; // network thread's copy of what it published last
+
+	static std::thread s_networkThread;
+	static std::atomic<bool> s_stopNetwork = false;
+	static std::atomic<int> s_editorRow = 0;
+	static bool s_keysEdited = false;
+	static bool s_keysFetched = false; // by AddTrack(), in between Boost() calls
+
+	// the device is shared between the network thread and AddTrack()
+	static std::mutex s_deviceMutex;
+
+	constexpr auto kNetworkInterval = std::chrono::milliseconds(1);
+	constexpr auto kReconnectInterval = std::chrono::milliseconds(500);
+
+	// publish keys if anything changed since last time (call with device locked)
+	static void PublishKeys()
+	{
+		bool changed = s_publishedKeys.size() != s_tracks.size();
+		s_publishedKeys.resize(s_tracks.size());
+
+		for (size_t iTrack = 0; iTrack < s_tracks.size(); ++iTrack)
+		{
+			const sync_track *pTrack = s_tracks[iTrack].pTrack;
+			std::vector<track_key> &keys = s_publishedKeys[iTrack];
+
+			// a few KB at most, so this is cheap enough to do every time around
+			if (keys.size() != size_t(pTrack->num_keys) || (0 != pTrack->num_keys && 0 != memcmp(keys.data(), pTrack->keys, keys.size()*sizeof(track_key))))
+			{
+				keys.assign(pTrack->keys, pTrack->keys + pTrack->num_keys);
+				changed = true;
+			}
+		}
+
+		if (true == changed)
+		{
+			s_keySets.Back() = s_publishedKeys;
+			s_keySets.Publish();
+		}
+	}
+
+	// render thread: publish keys right away and pick them up (call with device locked)
+	// this way every track has its keys from the get go instead of reading zero until the network thread gets around to it
+	static void PublishAndFetchKeys()
+	{
+		PublishKeys();
+		if (true == s_keySets.Fetch())
+			s_keysFetched = true;
+	}
+
+	// network thread: the Audio_Rocket_*() callbacks are thus called from here, which is fine since BASS is thread-safe
+	static void NetworkThread()
+	{
+		auto lastAttempt = std::chrono::steady_clock::now();
+
+		while (false == s_stopNetwork)
+		{
+			{
+				std::lock_guard<std::mutex> lock(s_deviceMutex);
+
+				if (0 != sync_update(s_hRocket, s_editorRow, &s_rocketCallbacks, nullptr))
+				{
+					// lost the editor: retry every now and then
+					const auto now = std::chrono::steady_clock::now();
+					if (now-lastAttempt >= kReconnectInterval)
+					{
+						sync_tcp_connect(s_hRocket, kHost, SYNC_DEFAULT_PORT);
+						lastAttempt = now;
+					}
+				}
+
+				PublishKeys();
+			}
+
+			std::this_thread::sleep_for(kNetworkInterval);
+		}
+	}
+
+#endif // !SYNC_PLAYER
 
 	bool Launch()
 	{
-		s_hRocket = sync_create_device("sync/");
+		s_hRocket = sync_create_device(kSyncBase);
+
+	#if defined(SYNC_PLAYER)
+		// if there's an up to date bundle all tracks are served from it (otherwise they're loaded one by one)
+		if (true == SyncBundle_Open(kSyncBundlePath))
+			sync_set_io_cb(s_hRocket, SyncBundle_GetIOCallbacks());
+	#endif
 
 	#if !defined(SYNC_PLAYER)
 		if (sync_tcp_connect(s_hRocket, kHost, SYNC_DEFAULT_PORT) != 0)
@@ -39,18 +158,82 @@ namespace Rocket
 		// there are more elegant ways to do this but it worked in 'hot stuff' so it'll work now just as well
 		s_stopTrack = AddTrack("demo:quit");
 
+	#if !defined(SYNC_PLAYER)
+		{
+			std::lock_guard<std::mutex> lock(s_deviceMutex);
+			PublishAndFetchKeys();
+		}
+
+		s_stopNetwork = false;
+		s_networkThread = std::thread(NetworkThread);
+	#endif
+
 		return true;
 	}
 
+#if !defined(SYNC_PLAYER)
+
+	// packs all tracks (in '.track' file format) for the player
+	static void PackBundle()
+	{
+		std::vector<SyncBundleTrack> tracks;
+		for (const Track &track : s_tracks)
+		{
+			const sync_track *pTrack = track.pTrack;
+
+			SyncBundleTrack packed;
+			packed.name = pTrack->name;
+
+			auto write = [&packed](const void *pData, size_t size) {
+				const uint8_t *pBytes = static_cast<const uint8_t *>(pData);
+				packed.data.insert(packed.data.end(), pBytes, pBytes+size);
+			};
+
+			// see save_track() in device.c
+			write(&pTrack->num_keys, sizeof(int));
+			for (int iKey = 0; iKey < pTrack->num_keys; ++iKey)
+			{
+				const track_key &key = pTrack->keys[iKey];
+				const char type = char(key.type);
+				write(&key.row, sizeof(int));
+				write(&key.value, sizeof(float));
+				write(&type, sizeof(char));
+			}
+
+			tracks.emplace_back(std::move(packed));
+		}
+
+		// not fatal: the player falls back to the loose tracks
+		SyncBundle_Pack(kSyncBundlePath, kSyncBase, tracks);
+	}
+
+#endif
+
 	void Land()
 	{
 	#if !defined(SYNC_PLAYER)
+		if (true == s_networkThread.joinable())
+		{
+			s_stopNetwork = true;
+			s_networkThread.join();
+		}
+
 		// taken from TPB-06; this way the tracks saved to disk are always up to date
 		sync_save_tracks(s_hRocket);
+
+		// and so is the bundle
+		PackBundle();
 	#endif
 
 		if (nullptr != s_hRocket)
 			sync_destroy_device(s_hRocket);
+
+	#if defined(SYNC_PLAYER)
+		SyncBundle_Close();
+	#endif
+
+		s_tracks.clear();
+		s_snapshot = Snapshot();
 	}
 
 	double s_rocketRow = 0.0;
@@ -71,23 +254,190 @@ namespace Rocket
 		s_rocketRow = Audio_Rocket_Sync(modOrder, modRow, modRowAlpha);
 
 	#if !defined(SYNC_PLAYER)
-		if (sync_update(s_hRocket, int(floor(s_rocketRow)), &s_rocketCallbacks, nullptr))
-			sync_tcp_connect(s_hRocket, "localhost", SYNC_DEFAULT_PORT);
+		// hand row to network thread and pick up the latest keys it published (if any)
+		s_editorRow = int(floor(s_rocketRow));
+		s_keysEdited = s_keySets.Fetch() || s_keysFetched;
+		s_keysFetched = false;
 	#endif
 
+		Evaluate(s_rocketRow, s_snapshot);
+
 		if (0.0 != get(s_stopTrack))
 			return false;
 
 		return true;
 	}
 
-	const sync_track *AddTrack(const char *name)
+	SyncTrack AddTrack(const char *name)
+	{
+	#if !defined(SYNC_PLAYER)
+		std::lock_guard<std::mutex> lock(s_deviceMutex);
+	#endif
+
+		const sync_track *pTrack = sync_get_track(s_hRocket, name);
+
+		for (const Track &track : s_tracks)
+			if (track.pTrack == pTrack)
+				return &track;
+
+		s_tracks.push_back({ pTrack, s_tracks.size() });
+
+	#if !defined(SYNC_PLAYER)
+		PublishAndFetchKeys();
+	#endif
+
+		// so it's valid right away
+		Evaluate(s_rocketRow, s_snapshot);
+
+		return &s_tracks.back();
+	}
+
+	// keys as seen by Boost() and Evaluate()
+	static void GetKeys(size_t iTrack, const track_key *&pKeys, int &numKeys)
+	{
+	#if defined(SYNC_PLAYER)
+		const sync_track *pTrack = s_tracks[iTrack].pTrack;
+		pKeys = pTrack->keys;
+		numKeys = pTrack->num_keys;
+	#else
+		const KeySet &keySet = s_keySets.Front();
+		if (iTrack < keySet.size())
+		{
+			pKeys = keySet[iTrack].data();
+			numKeys = int(keySet[iTrack].size());
+		}
+		else
+		{
+			// not published yet
+			pKeys = nullptr;
+			numKeys = 0;
+		}
+	#endif
+	}
+
+	// index of last key at or before row (-1 if there isn't one), same as key_idx_floor() (track.h)
+	static int FindKeyFloor(const track_key *pKeys, int numKeys, int row)
+	{
+		const track_key *pKey = std::upper_bound(pKeys, pKeys+numKeys, row, [](int row, const track_key &key) { return row < key.row; });
+		return int(pKey-pKeys) - 1;
+	}
+
+	// does exactly what sync_get_val() (track.c) does, but starts off at the key (cursor) found last time instead of a binary search
+	static double EvaluateTrack(const track_key *pKeys, int numKeys, double row, int &cursor)
+	{
+		// no keys at all: constant zero
+		if (0 == numKeys)
+		{
+			cursor = -1;
+			return 0.0;
+		}
+
+		const int iRow = int(floor(row));
+
+		// the cursor is the floor key index (-1 if before first key), it's validated as keys may change in editor mode
+		if (cursor < -1 || cursor >= numKeys || (cursor >= 0 && pKeys[cursor].row > iRow))
+		{
+			// went back in time (or keys were deleted)
+			cursor = FindKeyFloor(pKeys, numKeys, iRow);
+		}
+		else
+		{
+			// forward: usually a key at most, if it's a larger leap search instead
+			unsigned numSteps = 0;
+			while (cursor+1 < numKeys && pKeys[cursor+1].row <= iRow)
+			{
+				if (++numSteps > 4)
+				{
+					cursor = FindKeyFloor(pKeys, numKeys, iRow);
+					break;
+				}
+
+				++cursor;
+			}
+		}
+
+		// at the edges, return the first/last value
+		if (cursor < 0)
+			return pKeys[0].value;
+		if (cursor > numKeys-2)
+			return pKeys[numKeys-1].value;
+
+		// interpolate according to key type
+		const track_key *pKey = pKeys + cursor;
+		const double t = (row - pKey[0].row) / (pKey[1].row - pKey[0].row);
+		switch (pKey[0].type)
+		{
+		case KEY_STEP:
+			return pKey[0].value;
+
+		case KEY_LINEAR:
+			return pKey[0].value + (pKey[1].value - pKey[0].value) * t;
+
+		case KEY_SMOOTH:
+			return pKey[0].value + (pKey[1].value - pKey[0].value) * (t * t * (3 - 2 * t));
+
+		case KEY_RAMP:
+			return pKey[0].value + (pKey[1].value - pKey[0].value) * pow(t, 2.0);
+
+		default:
+			VIZ_ASSERT(false);
+			return 0.0;
+		}
+	}
+
+	void Evaluate(double row, Snapshot &snapshot)
+	{
+		const size_t numTracks = s_tracks.size();
+		snapshot.cursors.resize(numTracks, -1);
+		snapshot.values.resize(numTracks, 0.0);
+		snapshot.row = row;
+
+		for (size_t iTrack = 0; iTrack < numTracks; ++iTrack)
+		{
+			const track_key *pKeys;
+			int numKeys;
+			GetKeys(iTrack, pKeys, numKeys);
+			snapshot.values[iTrack] = EvaluateTrack(pKeys, numKeys, row, snapshot.cursors[iTrack]);
+		}
+	}
+
+	double get(const Snapshot &snapshot, SyncTrack track)
+	{
+		VIZ_ASSERT(nullptr != track && track->index < snapshot.values.size());
+		return snapshot.values[track->index];
+	}
+
+	double get(SyncTrack track)
 	{
-		return sync_get_track(s_hRocket, name);
+		return get(s_snapshot, track);
 	}
 
-	double get(const sync_track *track)
+	const Snapshot &GetSnapshot()
 	{
-		return sync_get_val(track, s_rocketRow);
+		return s_snapshot;
+	}
+
+	bool KeysEdited()
+	{
+	#if !defined(SYNC_PLAYER)
+		return s_keysEdited;
+	#else
+		return false;
+	#endif
+	}
+
+	double GetEndRow()
+	{
+		const track_key *pKeys;
+		int numKeys;
+		GetKeys(s_stopTrack->index, pKeys, numKeys);
+
+		for (int iKey = 0; iKey < numKeys; ++iKey)
+		{
+			if (0.f != pKeys[iKey].value)
+				return pKeys[iKey].row;
+		}
+
+		return -1.0;
 	}
 }
@@ -1,11 +1,15 @@
-
 // cookiedough -- Rocket wrapper (sync. tool for demos, read up on it in /3rdparty)
 
 #pragma once
 
 #include "../3rdparty/rocket-stripped/lib/sync.h"
 
-typedef const sync_track* SyncTrack;
+namespace Rocket
+{
+	struct Track; // registered track (opaque)
+}
+
+typedef const Rocket::Track* SyncTrack;
 
 namespace Rocket
 {
@@ -15,16 +19,41 @@ namespace Rocket
 	bool Boost();
 
 	// define a SyncTrack anywhere you like, register it here and it will show up in GNU Rocket
-	const sync_track *AddTrack(const char *name);
+	SyncTrack AddTrack(const char *name);
 
 	// from there on out you use these to grab the values
-	double get(const sync_track *track);
+	// - all tracks are evaluated once per Boost() into a flat array, so these are just a lookup (call them as often as you like)
+	double get(SyncTrack track);
 
-	CKD_INLINE float getf(const sync_track *track) { 
+	CKD_INLINE float getf(SyncTrack track) { 
 		return (float) get(track); 
 	}
 
-	CKD_INLINE int geti(const sync_track *track) { 
+	CKD_INLINE int geti(SyncTrack track) { 
 		return int(roundf(getf(track)));
 	}
+
+	// compiled snapshot of all tracks at a given row, which is what Boost() uses internally
+	// - keep one per thread if you want to evaluate other rows (ahead of time, in parallel)
+	// - each track keeps a key cursor, so evaluating rows in (mostly) forward order is cheapest
+	// - in editor mode keys are edited by Boost() on the main thread, so do not evaluate concurrently with it
+	struct Snapshot
+	{
+		double row = 0.0;
+		std::vector<int> cursors;
+		std::vector<double> values;
+	};
+
+	void Evaluate(double row, Snapshot &snapshot);
+	double get(const Snapshot &snapshot, SyncTrack track);
+
+	// the one evaluated by Boost()
+	const Snapshot &GetSnapshot();
+
+	// editor: true if the last Boost() picked up edited keys (set, deleted, tracks added), always false in player mode
+	bool KeysEdited();
+
+	// row of first key that says the demo is over (Boost() returns false from around there), or -1 if there is none
+	// - might be a little late if the key before it interpolates towards it
+	double GetEndRow();
 }
@@ -106,8 +106,8 @@ namespace Shadertoy
 	{
 		float fX = (float) iX;
 		float fY = (float) iY;
-		fX *= 1.f/kResX;
-		fY *= 1.f/kResY;
+		fX *= 1.f/g_resX;
+		fY *= 1.f/g_resY;
 		return Vector2((fX-0.5f)*scale*kOneOverAspect, (fY-0.5f)*scale);
 	}
 
@@ -115,17 +115,18 @@ namespace Shadertoy
 	{
 		float fX = (float) iX;
 		float fY = (float) iY;
-		fX *= 1.f/kTargetResX;
-		fY *= 1.f/kTargetResY;
+		fX *= 1.f/g_targetResX;
+		fY *= 1.f/g_targetResY;
 		return Vector2((fX-0.5f)*scale*kOneOverAspect, (fY-0.5f)*scale);
 	}
 
-	VIZ_INLINE const Vector2 ToUV_FxMap(unsigned iX, unsigned iY, float scale = 2.f)
+	// pass 'res' if the map is rendered at another resolution (see FxGovernor)
+	VIZ_INLINE const Vector2 ToUV_FxMap(unsigned iX, unsigned iY, float scale = 2.f, const FxMapRes &res = g_fxMapRes[0])
 	{
 		float fX = (float) iX;
 		float fY = (float) iY;
-		fX *= 1.f/kFxMapResX;
-		fY *= 1.f/kFxMapResY;
+		fX *= res.toU;
+		fY *= res.toV;
 		return Vector2((fX-0.5f)*scale*kOneOverAspect, (fY-0.5f)*scale);
 	}
 
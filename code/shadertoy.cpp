@@ -17,6 +17,7 @@
 */
 
 #include "main.h"
+#include "alloc-large.h"
 // #include "shadertoy.h"
 #include "image.h"
 #include "bilinear.h"
@@ -24,6 +25,8 @@
 #include "deprecated/boxblur.h"
 #include "rocket.h"
 #include "polar.h"
+#include "task-graph.h"
+#include "fx-governor.h"
 
 // --- Sync. tracks ---
 
@@ -94,6 +97,13 @@ SyncTrack
 static uint32_t *s_pFDTunnelTex = nullptr;
 static uint32_t *s_pFDTunnelTexHighlights = nullptr;
 
+// Tunnel tables: texture U & V (both layers) and fog per map pixel (see Tunnel_Draw())
+static float *s_pTunnelU = nullptr;
+static float *s_pTunnelV = nullptr;
+static float *s_pTunnelU2 = nullptr;
+static float *s_pTunnelV2 = nullptr;
+static float *s_pTunnelShade = nullptr;
+
 // Blur mask(s) for 'spikey close-up'
 static uint32_t *s_pSpikeBlurMaps[2]= { nullptr };
 static uint32_t *s_pSpikeBlurMap = nullptr;
@@ -176,20 +186,42 @@ bool Shadertoy_Create()
 	if (nullptr == s_pFDTunnelTex || nullptr == s_pFDTunnelTexHighlights)
 		return false;
 
-	// IMPORTANT: these *must* be kFxMapRes size!
-	s_pSpikeBlurMaps[0] = Image_Load32("assets/shadertoy/close-up-blur-map-1.png");
-	s_pSpikeBlurMaps[1] = Image_Load32("assets/shadertoy/close-up-blur-map-2.png");
-	if (nullptr == s_pSpikeBlurMaps[0] || nullptr == s_pSpikeBlurMaps[1])
+	// IMPORTANT: these *must* be g_fxMapRes size (they're made for the author resolution, so they're scaled to fit)
+	const uint32_t *pSpikeBlurMaps[2];
+	pSpikeBlurMaps[0] = Image_Load32_Size("assets/shadertoy/close-up-blur-map-1.png", unsigned(g_fxMapResX), unsigned(g_fxMapResY));
+	pSpikeBlurMaps[1] = Image_Load32_Size("assets/shadertoy/close-up-blur-map-2.png", unsigned(g_fxMapResX), unsigned(g_fxMapResY));
+	if (nullptr == pSpikeBlurMaps[0] || nullptr == pSpikeBlurMaps[1])
 		return false;
 
-	s_pSpikeBlurMap = static_cast<uint32_t*>(mallocAligned((1280*720)/2 * sizeof(uint32_t), kAlignTo));
+	// images are tightly packed, Fx maps aren't (see g_fxMapPitch)
+	for (unsigned iMap = 0; iMap < 2; ++iMap)
+	{
+		s_pSpikeBlurMaps[iMap] = static_cast<uint32_t*>(mallocLarge(g_fxMapBytes, "shadertoy"));
+		for (unsigned iY = 0; iY < g_fxMapResY; ++iY)
+			memcpy(s_pSpikeBlurMaps[iMap] + iY*g_fxMapPitch, pSpikeBlurMaps[iMap] + iY*g_fxMapResX, g_fxMapResX*sizeof(uint32_t));
+	}
+
+	s_pSpikeBlurMap = static_cast<uint32_t*>(mallocLarge(g_fxMapBytes, "shadertoy"));
+
+	s_pTunnelU = static_cast<float*>(mallocLarge(g_fxMapSize*sizeof(float), "shadertoy"));
+	s_pTunnelV = static_cast<float*>(mallocLarge(g_fxMapSize*sizeof(float), "shadertoy"));
+	s_pTunnelU2 = static_cast<float*>(mallocLarge(g_fxMapSize*sizeof(float), "shadertoy"));
+	s_pTunnelV2 = static_cast<float*>(mallocLarge(g_fxMapSize*sizeof(float), "shadertoy"));
+	s_pTunnelShade = static_cast<float*>(mallocLarge(g_fxMapSize*sizeof(float), "shadertoy"));
 
 	return true;
 }
 
 void Shadertoy_Destroy()
 {
-	freeAligned(s_pSpikeBlurMap);
+	freeLarge(s_pSpikeBlurMaps[0]);
+	freeLarge(s_pSpikeBlurMaps[1]);
+	freeLarge(s_pSpikeBlurMap);
+	freeLarge(s_pTunnelU);
+	freeLarge(s_pTunnelV);
+	freeLarge(s_pTunnelU2);
+	freeLarge(s_pTunnelV2);
+	freeLarge(s_pTunnelShade);
 }
 
 //
@@ -228,11 +260,11 @@ static void RenderPlasmaMap(uint32_t *pDest, float time)
 	const float dirSin = lutsinf(angle);
 
 	#pragma omp parallel for schedule(dynamic)
-	for (unsigned iY = 0; iY < kFxMapResY; ++iY)
+	for (unsigned iY = 0; iY < g_fxMapResY; ++iY)
 	{
-		const auto yIndex = iY*kFxMapResX;
+		const auto yIndex = iY*g_fxMapPitch;
 
-		for (unsigned iX = 0; iX < kFxMapResX; iX += 4)
+		for (unsigned iX = 0; iX < g_fxMapResX; iX += 4)
 		{	
 			__m128 colors[4];
 			for (int iColor = 0; iColor < 4; ++iColor)
@@ -285,11 +317,11 @@ void Plasma_Draw(uint32_t *pDest, float time, float delta)
 // Definitely a keeper. He was OK with that.
 //
 
-static Vector3 fNautilus_global;
-VIZ_INLINE float fNautilus(const Vector3 &position, float time)
+// per frame parameters are passed along (a function of time, see RenderNautilusMap_2x2())
+VIZ_INLINE float fNautilus(const Vector3 &position, float time, const Vector3 &params)
 {
-	const float cosX = lutcosf(lutcosf(position.x + fNautilus_global.x)*position.x - lutcosf(position.y + fNautilus_global.y)*position.y);
-	const float cosY = lutcosf(position.z*0.33f*position.x - fNautilus_global.z*position.y);
+	const float cosX = lutcosf(lutcosf(position.x + params.x)*position.x - lutcosf(position.y + params.y)*position.y);
+	const float cosY = lutcosf(position.z*0.33f*position.x - params.z*position.y);
 	const float cosZ = lutcosf(position.x + position.y + position.z*0.8f + time);
 
 	const float dotted = cosX*cosX + cosY*cosY + cosZ*cosZ;
@@ -297,7 +329,7 @@ VIZ_INLINE float fNautilus(const Vector3 &position, float time)
 	return dotted*0.5f - .7f;
 };
 
-static void RenderNautilusMap_2x2(uint32_t *pDest, float time) 
+static void RenderNautilusMap_2x2(uint32_t *pDest, float time, const FxMapRes &res)
 {
 	__m128i *pDest128 = reinterpret_cast<__m128i*>(pDest);
 
@@ -308,9 +340,10 @@ static void RenderNautilusMap_2x2(uint32_t *pDest, float time)
 
 	time = time*speed;
 
-	fNautilus_global.x = time*0.125f;
-	fNautilus_global.y = time/9.f;
-	fNautilus_global.z = lutcosf(time*0.1428f);
+	const Vector3 fNautilus_params(
+		time*0.125f,
+		time/9.f,
+		lutcosf(time*0.1428f));
 
 	// slightly different from MichielPal() for some reason
 	const Vector3 colorization(
@@ -326,18 +359,18 @@ static void RenderNautilusMap_2x2(uint32_t *pDest, float time)
 	const float funkCos = lutcosf(time*kGoldenRatio*0.1f);
 
 	#pragma omp parallel for schedule(dynamic)
-	for (unsigned iY = 0; iY < kFxMapResY; ++iY)
+	for (unsigned iY = 0; iY < res.resY; ++iY)
 	{
-		const int yIndex = iY*kFxMapResX;
+		const int yIndex = iY*g_fxMapPitch;
 
-		for (unsigned iX = 0; iX < kFxMapResX; iX += 4)
+		for (unsigned iX = 0; iX < res.resX; iX += 4)
 		{	
 			const int destIndex = (yIndex+iX)>>2;
 
 			__m128 colors[4];
 			for (int iColor = 0; iColor < 4; ++iColor)
 			{
-				const auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY, 2.f);
+				const auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY, 2.f, res);
 
 				Vector3 direction(UV.x*kAspect, UV.y, 1.f); 
 				Shadertoy::rotZ(roll*time, direction.x, direction.y);
@@ -353,16 +386,16 @@ static void RenderNautilusMap_2x2(uint32_t *pDest, float time)
 					hit.y = direction.y*total;
 					hit.z = direction.z*total;
 					
-					march = fNautilus(hit, time);
+					march = fNautilus(hit, time, fNautilus_params);
 
 					total += march*0.628f;
 				}
 
 				constexpr float nOffs = 0.15f;
 				Vector3 normal(
-					march-fNautilus(Vector3(hit.x+nOffs, hit.y, hit.z), time),
-					march-fNautilus(Vector3(hit.x, hit.y+nOffs, hit.z), time),
-					march-fNautilus(Vector3(hit.x, hit.y, hit.z+nOffs), time));
+					march-fNautilus(Vector3(hit.x+nOffs, hit.y, hit.z), time, fNautilus_params),
+					march-fNautilus(Vector3(hit.x, hit.y+nOffs, hit.z), time, fNautilus_params),
+					march-fNautilus(Vector3(hit.x, hit.y, hit.z+nOffs), time, fNautilus_params));
 				Shadertoy::vFastNorm3(normal);
 
 				// I will leave the calculations here as written by Michiel (rust in vrede):
@@ -372,9 +405,9 @@ static void RenderNautilusMap_2x2(uint32_t *pDest, float time)
 				constexpr float nOffs2 = 0.15f;
 				Vector3 hitOffs = hit + cosHitOffs;
 				Vector3 funk(
-					march-fNautilus(Vector3(hitOffs.x+nOffs2, hitOffs.y,        hitOffs.z), time),
-					march-fNautilus(Vector3(hitOffs.x,        hitOffs.y+nOffs2, hitOffs.z), time),
-					march-fNautilus(Vector3(hitOffs.x,        hitOffs.y,        hitOffs.z+nOffs2), time));
+					march-fNautilus(Vector3(hitOffs.x+nOffs2, hitOffs.y,        hitOffs.z), time, fNautilus_params),
+					march-fNautilus(Vector3(hitOffs.x,        hitOffs.y+nOffs2, hitOffs.z), time, fNautilus_params),
+					march-fNautilus(Vector3(hitOffs.x,        hitOffs.y,        hitOffs.z+nOffs2), time, fNautilus_params));
 				Shadertoy::vFastNorm3(funk);
 
 				const float yMod = fracf(hit.y*0.3f + funk.x*0.628f + funk.y*funkCos);
@@ -392,18 +425,22 @@ static void RenderNautilusMap_2x2(uint32_t *pDest, float time)
 	}
 }
 
+static FxGovernor s_nautilusGovernor("Nautilus");
+
 void Nautilus_Draw(uint32_t *pDest, float time, float delta)
 {
-	RenderNautilusMap_2x2(g_pFxMap[0], time);
+	const FxMapRes &res = s_nautilusGovernor.Begin();
+	RenderNautilusMap_2x2(g_pFxMap[0], time, res);
+	s_nautilusGovernor.End();
 
 	const float blur = BoxBlurScale(Rocket::getf(trackNautilusBlur));
 	if (0.f != blur)
 	{
-		Fx_Blit_2x2(pDest, g_pFxMap[0]);
-		BoxBlur32(pDest, pDest, kResX, kResY, blur);
+		Fx_Blit(pDest, g_pFxMap[0], res);
+		BoxBlur32(pDest, pDest, g_resX, g_resY, blur);
 	}
 	else
-		Fx_Blit_2x2(pDest, g_pFxMap[0]);
+		Fx_Blit(pDest, g_pFxMap[0], res);
 }
 
 //
@@ -413,23 +450,22 @@ void Nautilus_Draw(uint32_t *pDest, float time, float delta)
 // - colored specular perhaps?
 //
 
-static Vector4 fSpike_global;
-
-VIZ_INLINE float fSpikey1(const Vector3 &position) 
+// per frame parameters are passed along (X: time, Y & Z: frequencies)
+VIZ_INLINE float fSpikey1(const Vector3 &position, const Vector4 &params)
 {
 	constexpr float scale = kGoldenAngle*0.1f;
-	const float radius = 1.35f + scale*lutcosf(fSpike_global.y*position.y - fSpike_global.x) + scale*lutcosf(fSpike_global.z*position.x + fSpike_global.x);
+	const float radius = 1.35f + scale*lutcosf(params.y*position.y - params.x) + scale*lutcosf(params.z*position.x + params.x);
 	return Shadertoy::vFastLen3(position) - radius; 
 }
 
-VIZ_INLINE float fSpikey2(const Vector3 &position) 
+VIZ_INLINE float fSpikey2(const Vector3 &position, const Vector4 &params)
 {
 	constexpr float scale = kGoldenRatio*0.1f;
-	const float radius = 1.35f + scale*lutcosf(fSpike_global.y*position.y - fSpike_global.x) + scale*lutcosf(fSpike_global.z*position.x + fSpike_global.x);
+	const float radius = 1.35f + scale*lutcosf(params.y*position.y - params.x) + scale*lutcosf(params.z*position.x + params.x);
 	return Shadertoy::vFastLen3(position) - radius; // return position.Length() - radius;
 }
 
-static void RenderSpikeyMap_2x2_Close(uint32_t *pDest, float time)
+static void RenderSpikeyMap_2x2_Close(uint32_t *pDest, float time, const FxMapRes &res)
 {
 	__m128i *pDest128 = reinterpret_cast<__m128i*>(pDest);
 
@@ -452,22 +488,23 @@ static void RenderSpikeyMap_2x2_Close(uint32_t *pDest, float time)
 	const Vector3 colorization = Shadertoy::MichielPal(hue);
 	const __m128 diffColor = Shadertoy::Desaturate(colorization, desaturation);
 
+	Vector4 fSpike_params;
 	if (false == aspectMul)
-		fSpike_global = Vector4(speed*time, 16.f*scale, 22.f*scale, 0.f);
+		fSpike_params = Vector4(speed*time, 16.f*scale, 22.f*scale, 0.f);
 	else
-		fSpike_global = Vector4(speed*time, 16.f*scale, kAspect*22.f*scale, 0.f);
+		fSpike_params = Vector4(speed*time, 16.f*scale, kAspect*22.f*scale, 0.f);
 
 	#pragma omp parallel for schedule(dynamic)
-	for (unsigned iY = 0; iY < kFxMapResY; ++iY)
+	for (unsigned iY = 0; iY < res.resY; ++iY)
 	{
-		const int yIndex = iY*kFxMapResX;
+		const int yIndex = iY*g_fxMapPitch;
 
-		for (unsigned iX = 0; iX < kFxMapResX; iX += 4)
+		for (unsigned iX = 0; iX < res.resX; iX += 4)
 		{	
 			__m128 colors[4];
 			for (int iColor = 0; iColor < 4; ++iColor)
 			{
-				const auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY, 2.f); 
+				const auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY, 2.f, res); 
 
 				Vector3 origin(0.2f, 0.f, -2.23f); // FIXME: nice parameters too!
 				Vector3 direction((UV.x+xOffs)*kAspect, UV.y + yOffs, 1.f + zOffsFinal); 
@@ -484,7 +521,7 @@ static void RenderSpikeyMap_2x2_Close(uint32_t *pDest, float time)
 					hit.y = origin.y + direction.y*total;
 					hit.z = origin.z + direction.z*total;
 
-					march = fSpikey1(hit);
+					march = fSpikey1(hit, fSpike_params);
 
 					// in this case it looks better to not scale march other than to, well: march
 					total += march*(0.05f*kPI);
@@ -492,9 +529,9 @@ static void RenderSpikeyMap_2x2_Close(uint32_t *pDest, float time)
 
 				const float nOffs = normalGrain; 
 				Vector3 normal(
-					march-fSpikey1(Vector3(hit.x+nOffs, hit.y, hit.z)),
-					march-fSpikey1(Vector3(hit.x, hit.y+nOffs, hit.z)),
-					march-fSpikey1(Vector3(hit.x, hit.y, hit.z+nOffs)));
+					march-fSpikey1(Vector3(hit.x+nOffs, hit.y, hit.z), fSpike_params),
+					march-fSpikey1(Vector3(hit.x, hit.y+nOffs, hit.z), fSpike_params),
+					march-fSpikey1(Vector3(hit.x, hit.y, hit.z+nOffs), fSpike_params));
 				Shadertoy::vFastNorm3(normal);
 
 				/* const */ float diffuse = normal.z;
@@ -522,7 +559,7 @@ static void RenderSpikeyMap_2x2_Close(uint32_t *pDest, float time)
 	}
 }
 
-static void RenderSpikeyMap_2x2_Distant(uint32_t *pDest, float time)
+static void RenderSpikeyMap_2x2_Distant(uint32_t *pDest, float time, const FxMapRes &res)
 {
 	__m128i *pDest128 = reinterpret_cast<__m128i*>(pDest);
 
@@ -539,21 +576,21 @@ static void RenderSpikeyMap_2x2_Distant(uint32_t *pDest, float time)
 	const Vector3 colorization = Shadertoy::MichielPal(hue);
 	const __m128 diffColor = Shadertoy::Desaturate(colorization, desaturation); 
 
-	fSpike_global = Vector4(speed*time, 16.f, 16.f, kEpsilon);
+	const Vector4 fSpike_params(speed*time, 16.f, 16.f, kEpsilon);
 
 	const Vector3 origin(0.f, 0.f, -2.614f + zOffs);
 
 	#pragma omp parallel for schedule(dynamic)
-	for (unsigned iY = 0; iY < kFxMapResY; ++iY)
+	for (unsigned iY = 0; iY < res.resY; ++iY)
 	{
-		const int yIndex = iY*kFxMapResX;
+		const int yIndex = iY*g_fxMapPitch;
 
-		for (unsigned iX = 0; iX < kFxMapResX; iX += 4)
+		for (unsigned iX = 0; iX < res.resX; iX += 4)
 		{	
 			__m128 colors[4];
 			for (int iColor = 0; iColor < 4; ++iColor)
 			{
-				auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY, 2.f);
+				auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY, 2.f, res);
 				
 				Vector3 direction(UV.x + xOffs, UV.y + yOffs, 1.f); 
 				Shadertoy::rotZ(roll, direction.x, direction.y);
@@ -569,7 +606,7 @@ static void RenderSpikeyMap_2x2_Distant(uint32_t *pDest, float time)
 					hit.y = origin.y + direction.y*total;
 					hit.z = origin.z + direction.z*total;
 
-					march = fSpikey2(hit);
+					march = fSpikey2(hit, fSpike_params);
 					march *= 0.314f;
 
 					total += march; 
@@ -577,9 +614,9 @@ static void RenderSpikeyMap_2x2_Distant(uint32_t *pDest, float time)
 
 				constexpr float nOffs = kPI*0.02f;
 				Vector3 normal(
-					march-fSpikey2(Vector3(hit.x+nOffs, hit.y, hit.z)),
-					march-fSpikey2(Vector3(hit.x, hit.y+nOffs, hit.z)),
-					march-fSpikey2(Vector3(hit.x, hit.y, hit.z+nOffs)));
+					march-fSpikey2(Vector3(hit.x+nOffs, hit.y, hit.z), fSpike_params),
+					march-fSpikey2(Vector3(hit.x, hit.y+nOffs, hit.z), fSpike_params),
+					march-fSpikey2(Vector3(hit.x, hit.y, hit.z+nOffs), fSpike_params));
 				Shadertoy::vFastNorm3(normal);
 
 				const float diffuse = std::max<float>(0.f, normal.z*0.8f + normal.y*0.2f);
@@ -597,7 +634,7 @@ static void RenderSpikeyMap_2x2_Distant(uint32_t *pDest, float time)
 	}
 }
 
-static void RenderSpikeyMap_2x2_Distant_SpecularOnly(uint32_t *pDest, float time, float warmup)
+static void RenderSpikeyMap_2x2_Distant_SpecularOnly(uint32_t *pDest, float time, float warmup, const FxMapRes &res)
 {
 	__m128i *pDest128 = reinterpret_cast<__m128i*>(pDest);
 
@@ -605,19 +642,19 @@ static void RenderSpikeyMap_2x2_Distant_SpecularOnly(uint32_t *pDest, float time
 	const float roll = Rocket::getf(trackSpikeRoll);
 	const float specPow = Rocket::getf(trackSpikeSpecular);
 
-	fSpike_global = Vector4(speed*time, 8.f, 16.f, 0.f);
+	const Vector4 fSpike_params(speed*time, 8.f, 16.f, 0.f);
 
 	#pragma omp parallel for schedule(dynamic)
-	for (unsigned iY = 0; iY < kFxMapResY; ++iY)
+	for (unsigned iY = 0; iY < res.resY; ++iY)
 	{
-		const int yIndex = iY*kFxMapResX;
+		const int yIndex = iY*g_fxMapPitch;
 
-		for (unsigned iX = 0; iX < kFxMapResX; iX += 4)
+		for (unsigned iX = 0; iX < res.resX; iX += 4)
 		{	
 			__m128 colors[4];
 			for (int iColor = 0; iColor < 4; ++iColor)
 			{
-				const auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY, kGoldenRatio);
+				const auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY, kGoldenRatio, res);
 
 				const Vector3 origin(0.f, 0.f, -3.314f);
 				Vector3 direction(UV.x*kAspect, UV.y, 1.f); 
@@ -633,16 +670,16 @@ static void RenderSpikeyMap_2x2_Distant_SpecularOnly(uint32_t *pDest, float time
 					hit.y = origin.y + direction.y*total;
 					hit.z = origin.z + direction.z*total;
 
-					march = fSpikey2(hit);
+					march = fSpikey2(hit, fSpike_params);
 
 					total += march*0.075f*kGoldenRatio;
 				}
 
 				constexpr float nOffs = 0.01f;
 				Vector3 normal(
-					march-fSpikey2(Vector3(hit.x+nOffs, hit.y, hit.z)),
-					march-fSpikey2(Vector3(hit.x, hit.y+nOffs, hit.z)),
-					march-fSpikey2(Vector3(hit.x, hit.y, hit.z+nOffs)));
+					march-fSpikey2(Vector3(hit.x+nOffs, hit.y, hit.z), fSpike_params),
+					march-fSpikey2(Vector3(hit.x, hit.y+nOffs, hit.z), fSpike_params),
+					march-fSpikey2(Vector3(hit.x, hit.y, hit.z+nOffs), fSpike_params));
 				Shadertoy::vFastNorm3(normal);
 
 				const float distance = hit.z-origin.z;
@@ -658,17 +695,24 @@ static void RenderSpikeyMap_2x2_Distant_SpecularOnly(uint32_t *pDest, float time
 	}
 }
 
+static FxGovernor s_spikeyCloseGovernor("Spikey (close)");
+static FxGovernor s_spikeyDistantGovernor("Spikey (distant)");
+
 void Spikey_Draw(uint32_t *pDest, float time, float delta, bool close /* = true */)
 {
 	if (close)
 	{
+		// the trick below relies on blur maps made for g_fxMapRes, so no scaling while it's used
+		const float mbOpacity = saturatef(Rocket::getf(trackCloseMixBlurOpacity));
+
 		// render close-up
-		RenderSpikeyMap_2x2_Close(g_pFxMap[0], time);
+		const FxMapRes &res = s_spikeyCloseGovernor.Begin(0.f == mbOpacity);
+		RenderSpikeyMap_2x2_Close(g_pFxMap[0], time, res);
+		s_spikeyCloseGovernor.End();
 
 		// and now we'll be performing a little trick to make things more interesting
-		const float mbOpacity = saturatef(Rocket::getf(trackCloseMixBlurOpacity));
 
-		// if the following causes grief, immediately check if the maps (s_pSpikeBlurMaps[]) are still the sam res. as kFxMapRes
+		// if the following causes grief, immediately check if the maps (s_pSpikeBlurMaps[]) are still the sam res. as g_fxMapRes
 		if (mbOpacity > 0.f)
 		{
 			// grab remaining Rocket parameters
@@ -678,36 +722,36 @@ void Spikey_Draw(uint32_t *pDest, float time, float delta, bool close /* = true
 
 			// get the right (blended) spike blur map in there
 			if (0.f == mbMap)
-				memcpy(s_pSpikeBlurMap, s_pSpikeBlurMaps[0], kFxMapBytes);
+				memcpy(s_pSpikeBlurMap, s_pSpikeBlurMaps[0], g_fxMapBytes);
 			else if (1.f == mbMap)
-				memcpy(s_pSpikeBlurMap, s_pSpikeBlurMaps[1], kFxMapBytes);
+				memcpy(s_pSpikeBlurMap, s_pSpikeBlurMaps[1], g_fxMapBytes);
 			else
 			{
-				memcpy(s_pSpikeBlurMap, s_pSpikeBlurMaps[0], kFxMapBytes);
-				Mix32(s_pSpikeBlurMap, s_pSpikeBlurMaps[1], kFxMapSize, unsigned(mbMap*255.f));
+				memcpy(s_pSpikeBlurMap, s_pSpikeBlurMaps[0], g_fxMapBytes);
+				Mix32(s_pSpikeBlurMap, s_pSpikeBlurMaps[1], g_fxMapSize, unsigned(mbMap*255.f));
 			}
 
 			// OK - this is fun, so let's first copy our FX map
-			memcpy(g_pFxMap[1], g_pFxMap[0], kFxMapBytes);
+			memcpy(g_pFxMap[1], g_pFxMap[0], g_fxMapBytes);
 
 			// then blur the source 'spike blur map' if requested
 			if (mbMapBlur >= 1.f)
-				BoxBlur32(s_pSpikeBlurMap, s_pSpikeBlurMap, kFxMapResX, kFxMapResY, BoxBlurScale(mbMapBlur));
+				BoxBlur32R(s_pSpikeBlurMap, s_pSpikeBlurMap, g_fxMapRect, g_fxMapPitch, BoxBlurScale(mbMapBlur));
 			
 			// do we want to apply some blur to the copied effect itself?
 			if (mbBlur >= 1.f)
-				BoxBlur32(g_pFxMap[1], g_pFxMap[1], kFxMapResX, kFxMapResY, BoxBlurScale(mbBlur));
+				BoxBlur32R(g_pFxMap[1], g_pFxMap[1], g_fxMapRect, g_fxMapPitch, BoxBlurScale(mbBlur));
 			
 			// apply 'soft light' blend mode using appropriate map 
-			SoftLight32AA(g_pFxMap[1], s_pSpikeBlurMap, kFxMapSize, tanhf(mbBlur+mbOpacity));
+			SoftLight32AA(g_pFxMap[1], s_pSpikeBlurMap, g_fxMapSize, tanhf(mbBlur+mbOpacity));
 
 			// mix 'em back together (using 'overlay blend', not exactly a 'mix', but it does look nice)
-//			Mix32(g_pFxMap[0], g_pFxMap[1], kFxMapSize, unsigned(mbOpacity*255.f));
-			Overlay32A(g_pFxMap[0], g_pFxMap[1], kFxMapSize);
+//			Mix32(g_pFxMap[0], g_pFxMap[1], g_fxMapSize, unsigned(mbOpacity*255.f));
+			Overlay32A(g_pFxMap[0], g_pFxMap[1], g_fxMapSize);
 		}
 
 		// blit to main buffer
-		Fx_Blit_2x2(pDest, g_pFxMap[0]);
+		Fx_Blit(pDest, g_pFxMap[0], res);
 	}
 	else
 	{
@@ -715,18 +759,25 @@ void Spikey_Draw(uint32_t *pDest, float time, float delta, bool close /* = true
 		const float warmup = Rocket::getf(trackDistSpikeWarmup);
 		const bool specularOnly = 0.f != warmup;
 		
+		const FxMapRes &res = s_spikeyDistantGovernor.Begin();
+
 		if (!specularOnly)
 		{
 			// render as normal
-			RenderSpikeyMap_2x2_Distant(g_pFxMap[0], time);
-			Fx_Blit_2x2(pDest, g_pFxMap[0]);
+			RenderSpikeyMap_2x2_Distant(g_pFxMap[0], time, res);
+			s_spikeyDistantGovernor.End();
+
+			Fx_Blit(pDest, g_pFxMap[0], res);
 		}
 		else
 		{
 			// render only specular, can be used for a transition as seen in Aura for Laura (hence the track name 'warmup')
-			RenderSpikeyMap_2x2_Distant_SpecularOnly(g_pFxMap[0], time, 1.f+warmup);
-			HorizontalBoxBlur32(g_pFxMap[0], g_pFxMap[0], kFxMapResX, kFxMapResY, BoxBlurScale(1.f+warmup));
-			Fx_Blit_2x2(pDest, g_pFxMap[0]);
+			RenderSpikeyMap_2x2_Distant_SpecularOnly(g_pFxMap[0], time, 1.f+warmup, res);
+			s_spikeyDistantGovernor.End();
+
+			const Rect mapRect = { 0, 0, res.resX, res.resY };
+			HorizontalBoxBlur32R(g_pFxMap[0], g_pFxMap[0], mapRect, g_fxMapPitch, BoxBlurScale((1.f+warmup)/res.div*kFxMapDiv));
+			Fx_Blit(pDest, g_pFxMap[0], res);
 		}
 	}
 
@@ -743,121 +794,288 @@ void Spikey_Draw(uint32_t *pDest, float time, float delta, bool close /* = true
 // you know, classic fun (for tunnel).
 //
 
-static void RenderTunnelMap_2x2(uint32_t *pDest, uint32_t *pGlowDest, float time)
+// parameters that shape the tunnel (as opposed to those that only move and color it)
+struct TunnelShape
 {
-	__m128i *pDest128 = reinterpret_cast<__m128i*>(pDest);
-	__m128i *pGlowDest128 = reinterpret_cast<__m128i*>(pGlowDest);
+	float boxy;
+	float flowerScale, flowerFreq, flowerPhase;
+	float pitch, roll;
+	float radius;
 
-	// FIXME: parametrize
-	const float boxy = Rocket::getf(trackTunnelBoxy);
-	const float flowerScale = Rocket::getf(trackTunnelFlowerScale);
-	const float flowerFreq = Rocket::getf(trackTunnelFlowerFreq);
-	const float flowerPhase = Rocket::getf(trackTunnelFlowerPhase)*time;
-	const float speed = Rocket::getf(trackTunnelSpeed);
-	const float roll = Rocket::getf(trackTunnelRoll)*time;
-	const float pitch = Rocket::getf(trackTunnelPitch)*time;
-	const float radius = Rocket::getf(trackTunnelRadius);
-	const float uMul = Rocket::getf(trackTunnelMulU);
-	const float vMul = Rocket::getf(trackTunnelMulV);
-	const float fogs[2] = { Rocket::getf(trackTunnelFog1), Rocket::getf(trackTunnelFog2) }; // FIXME: should clamp, but lazy today
+	bool operator==(const TunnelShape &shape) const = default;
+};
+
+struct TunnelParams
+{
+	TunnelShape shape;
+	float scroll;      // V offset
+	float uMul, vMul;
+	__m128 baseFog, litFog;
+};
+
+// casts ray for map pixel, yields texture U & V (before scale, V also before scroll) and fog
+VIZ_INLINE void CastTunnelRay(unsigned iX, unsigned iY, const TunnelShape &shape, float &U, float &V, float &U2, float &V2, float &shade)
+{
+	const auto UV = Shadertoy::ToUV_FxMap(iX, iY, 2.f);
+	Vector3 direction(UV.x, UV.y, 1.f); 
+	Shadertoy::rotX(shape.pitch, direction.y, direction.z);
+	Shadertoy::rotZ(shape.roll, direction.x, direction.y);
+	Shadertoy::vFastNorm3(direction);
+
+	// FIXME: this seems very suitable for SIMD, but the FPS is good as it is
+	float A;
+	A = direction.x*direction.x + direction.y*direction.y;
+	A += shape.flowerScale*lutcosf(atan2f(direction.y, direction.x)*shape.flowerFreq + shape.flowerPhase);
+
+	const float absX = fabsf(direction.x);
+	const float absY = fabsf(direction.y);
+	const float box = absX > absY ? absX : absY;
+	A = smoothstepf(A, box, shape.boxy);
+	A += kEpsilon;
+	A = 1.f/A;
+	const float T = shape.radius*A;
+	const float T2 = T*0.912f; // FIXME: parametrize (though this is a nice offset)
+	const Vector3 intersection = direction*T;
+	const Vector3 intersection2 = direction*T2;
+
+	U = atan2f(intersection.y, intersection.x)/kPI;
+	V = intersection.z;
+	U2 = atan2f(intersection2.y, intersection2.x)/kPI;
+	V2 = intersection2.z;
+
+	shade = clampf(0.f, 1.f, 1.f-expf(-0.006f*T*T));
+}
 
-	const __m128 baseFog = _mm_set1_ps(fogs[0]);
-	const __m128 litFog = _mm_set1_ps(fogs[1]);
+// samples both layers at 24:8 fixed point UVs and applies fog
+VIZ_INLINE void SampleTunnel(int fpU, int fpV, int fpU2, int fpV2, float shade, const TunnelParams &params, __m128 &color, __m128 &glowColor)
+{
+	unsigned U0, V0, U1, V1, fracU, fracV;
+
+	// 256x256
+//	bsamp_prepUVs(fpU, fpV, 255, 8, U0, V0, U1, V1, fracU, fracV);
 
-	time *= speed;
+	// 1024x1024
+	bsamp_prepUVs(fpU, fpV, 1023, 10, U0, V0, U1, V1, fracU, fracV);
+	color = bsamp32_32f(s_pFDTunnelTex, U0, V0, U1, V1, fracU, fracV);
 
-	#pragma omp parallel for schedule(static) // inner loop should perform roughly equally, mem. fetch locality is also appreciated
-	for (unsigned iY = 0; iY < kFxMapResY; ++iY)
+	bsamp_prepUVs(fpU2, fpV2, 1023, 10, U0, V0, U1, V1, fracU, fracV);
+	glowColor = bsamp32_32f(s_pFDTunnelTexHighlights, U0, V0, U1, V1, fracU, fracV);
+
+	color = Shadertoy::vLerp4(color, params.baseFog, shade); // FIXME: gamma?
+	glowColor = Shadertoy::vLerp4(glowColor, params.litFog, shade); // FIXME: perhaps don't sample this if not necessary, though it's not what will make or break the framerate
+}
+
+// renders map rows [firstRow, firstRow+numRows)
+static void RenderTunnelMap_2x2(uint32_t *pDest, uint32_t *pGlowDest, const TunnelParams &params, unsigned firstRow, unsigned numRows)
+{
+	__m128i *pDest128 = reinterpret_cast<__m128i*>(pDest);
+	__m128i *pGlowDest128 = reinterpret_cast<__m128i*>(pGlowDest);
+
+	const unsigned endRow = std::min<unsigned>(firstRow+numRows, g_fxMapResY);
+	for (unsigned iY = firstRow; iY < endRow; ++iY)
 	{
-		const int yIndex = iY*kFxMapResX;
+		const int yIndex = iY*g_fxMapPitch;
 
-		for (unsigned iX = 0; iX < kFxMapResX; iX += 4)
+		for (unsigned iX = 0; iX < g_fxMapResX; iX += 4)
 		{	
 			__m128 colors[4], glowColors[4];
 			for (int iColor = 0; iColor < 4; ++iColor)
 			{
-				const auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY, 2.f);
-				Vector3 direction(UV.x, UV.y, 1.f); 
-				Shadertoy::rotX(pitch, direction.y, direction.z);
-				Shadertoy::rotZ(roll, direction.x, direction.y);
-				Shadertoy::vFastNorm3(direction);
+				float U, V, U2, V2, shade;
+				CastTunnelRay(iColor+iX, iY, params.shape, U, V, U2, V2, shade);
 
-				// FIXME: this seems very suitable for SIMD, but the FPS is good as it is
-				float A;
-				A = direction.x*direction.x + direction.y*direction.y;
-				A += flowerScale*lutcosf(atan2f(direction.y, direction.x)*flowerFreq + flowerPhase);
-
-				const float absX = fabsf(direction.x);
-				const float absY = fabsf(direction.y);
-				const float box = absX > absY ? absX : absY;
-				A = smoothstepf(A, box, boxy);
-				A += kEpsilon;
-				A = 1.f/A;
-				const float T = radius*A;
-				const float T2 = T*0.912f; // FIXME: parametrize (though this is a nice offset)
-				const Vector3 intersection = direction*T;
-				const Vector3 intersection2 = direction*T2;
-
-				const float U = atan2f(intersection.y, intersection.x)/kPI;
-				const float V = intersection.z + time*speed;
-				const float U2 = atan2f(intersection2.y, intersection2.x)/kPI;
-				const float V2 = intersection2.z + time*speed;
+				V += params.scroll;
+				V2 += params.scroll;
 
 				// this is f*cking slow due to conversion (FTOL)
-				const int fpU = ftofp24(U*uMul);               
-				const int fpV = ftofp24(V*vMul);        
-				const int fpU2 = ftofp24(U2*uMul);               
-				const int fpV2 = ftofp24(V2*vMul);        
+				const int fpU = ftofp24(U*params.uMul);               
+				const int fpV = ftofp24(V*params.vMul);        
+				const int fpU2 = ftofp24(U2*params.uMul);               
+				const int fpV2 = ftofp24(V2*params.vMul);        
 
-				const float shade = clampf(0.f, 1.f, 1.f-expf(-0.006f*T*T));
+				SampleTunnel(fpU, fpV, fpU2, fpV2, shade, params, colors[iColor], glowColors[iColor]);
+			}
 
-				unsigned U0, V0, U1, V1, fracU, fracV;
+			const int index = (yIndex+iX)>>2;
+			pDest128[index] = Shadertoy::ToPixel4_NoConv(colors);
+			pGlowDest128[index] = Shadertoy::ToPixel4_NoConv(glowColors);
+		}
+	}
+}
 
-				// 256x256
-//				bsamp_prepUVs(fpU, fpV, 255, 8, U0, V0, U1, V1, fracU, fracV);
+/*
+	If pitch, roll and flower phase don't animate (their tracks are zero) the shape holds still and only the scroll
+	(V) changes, so the rays are cast into tables (map layout) once and from then on only offset, scaled and sampled.
+	The tables hold exactly what CastTunnelRay() yields and the rest is done in the same order as it is in
+	RenderTunnelMap_2x2(), so both paths render the exact same image; which one is used only depends on this frame's
+	sync. values (the tables are just a cache, rebuilt when the shape changes).
+*/
 
-				// 1024x1024
-				bsamp_prepUVs(fpU, fpV, 1023, 10, U0, V0, U1, V1, fracU, fracV);
-				__m128 color = bsamp32_32f(s_pFDTunnelTex, U0, V0, U1, V1, fracU, fracV);
+static TunnelShape s_tunnelTableShape;
+static bool s_tunnelTableValid = false;
 
-				bsamp_prepUVs(fpU2, fpV2, 1023, 10, U0, V0, U1, V1, fracU, fracV);
-				__m128 glowColor = bsamp32_32f(s_pFDTunnelTexHighlights, U0, V0, U1, V1, fracU, fracV);
+// fills table rows [firstRow, firstRow+numRows)
+static void BuildTunnelTable(const TunnelShape &shape, unsigned firstRow, unsigned numRows)
+{
+	const unsigned endRow = std::min<unsigned>(firstRow+numRows, g_fxMapResY);
+	for (unsigned iY = firstRow; iY < endRow; ++iY)
+	{
+		const int yIndex = iY*g_fxMapPitch;
 
-				color = Shadertoy::vLerp4(color, baseFog, shade);
-				glowColor = Shadertoy::vLerp4(glowColor, litFog, shade); // FIXME: perhaps don't sample this if not necessary, though it's not what will make or break the framerate
+		for (unsigned iX = 0; iX < g_fxMapResX; ++iX)
+		{
+			const int index = yIndex+iX;
+			CastTunnelRay(iX, iY, shape, s_pTunnelU[index], s_pTunnelV[index], s_pTunnelU2[index], s_pTunnelV2[index], s_pTunnelShade[index]);
+		}
+	}
+}
 
-				colors[iColor] = color; // FIXME: gamma?
-				glowColors[iColor] = glowColor;
-			}
+// renders map rows [firstRow, firstRow+numRows) from table
+static void RenderTunnelMap_2x2_Table(uint32_t *pDest, uint32_t *pGlowDest, const TunnelParams &params, unsigned firstRow, unsigned numRows)
+{
+	__m128i *pDest128 = reinterpret_cast<__m128i*>(pDest);
+	__m128i *pGlowDest128 = reinterpret_cast<__m128i*>(pGlowDest);
 
-			const int index = (yIndex+iX)>>2;
-			pDest128[index] = Shadertoy::ToPixel4_NoConv(colors);
-			pGlowDest128[index] = Shadertoy::ToPixel4_NoConv(glowColors);
+	const __m128 vScroll = _mm_set1_ps(params.scroll);
+	const __m128 uMul = _mm_set1_ps(params.uMul);
+	const __m128 vMul = _mm_set1_ps(params.vMul);
+	const __m128 toFP = _mm_set1_ps(256.f); // see ftofp24()
+
+	const unsigned endRow = std::min<unsigned>(firstRow+numRows, g_fxMapResY);
+	for (unsigned iY = firstRow; iY < endRow; ++iY)
+	{
+		const int yIndex = iY*g_fxMapPitch;
+
+		for (unsigned iX = 0; iX < g_fxMapResX; iX += 4)
+		{
+			const int index = yIndex+iX;
+
+			// same operations (and order) as RenderTunnelMap_2x2(), 4 at a time
+			const __m128 U = _mm_load_ps(s_pTunnelU + index);
+			const __m128 V = _mm_add_ps(_mm_load_ps(s_pTunnelV + index), vScroll);
+			const __m128 U2 = _mm_load_ps(s_pTunnelU2 + index);
+			const __m128 V2 = _mm_add_ps(_mm_load_ps(s_pTunnelV2 + index), vScroll);
+
+			alignas(16) int fpU[4], fpV[4], fpU2[4], fpV2[4];
+			_mm_store_si128(reinterpret_cast<__m128i*>(fpU), _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(U, uMul), toFP)));
+			_mm_store_si128(reinterpret_cast<__m128i*>(fpV), _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(V, vMul), toFP)));
+			_mm_store_si128(reinterpret_cast<__m128i*>(fpU2), _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(U2, uMul), toFP)));
+			_mm_store_si128(reinterpret_cast<__m128i*>(fpV2), _mm_cvttps_epi32(_mm_mul_ps(_mm_mul_ps(V2, vMul), toFP)));
+
+			const float *pShade = s_pTunnelShade + index;
+
+			__m128 colors[4], glowColors[4];
+			for (int iColor = 0; iColor < 4; ++iColor)
+				SampleTunnel(fpU[iColor], fpV[iColor], fpU2[iColor], fpV2[iColor], pShade[iColor], params, colors[iColor], glowColors[iColor]);
+
+			pDest128[index>>2] = Shadertoy::ToPixel4_NoConv(colors);
+			pGlowDest128[index>>2] = Shadertoy::ToPixel4_NoConv(glowColors);
 		}
 	}
 }
 
+// band sizes for the task graph (see Tunnel_Draw())
+constexpr unsigned kTunnelBandRows = 16;
+constexpr unsigned kTunnelBandCols = 64;
+
+static TaskGraph s_tunnelGraph("Tunnel");
+
 void Tunnel_Draw(uint32_t *pDest, float time, float delta)
 {
 	const bool litTiles = Rocket::geti(trackTunnelLitTiles) != 0;
 	const float litBlur = clampf(0.f, 100.f, Rocket::getf(trackTunnelLitBlur));
 
-	RenderTunnelMap_2x2(g_pFxMap[0], g_pFxMap[1], time);
+	uint32_t *pMap = g_pFxMap[0];
+	uint32_t *pGlow = g_pFxMap[1];
+
+	// FIXME: parametrize
+	TunnelParams params;
+	TunnelShape &shape = params.shape;
+	shape.boxy = Rocket::getf(trackTunnelBoxy);
+	shape.flowerScale = Rocket::getf(trackTunnelFlowerScale);
+	shape.flowerFreq = Rocket::getf(trackTunnelFlowerFreq);
+	shape.flowerPhase = Rocket::getf(trackTunnelFlowerPhase)*time;
+	shape.roll = Rocket::getf(trackTunnelRoll)*time;
+	shape.pitch = Rocket::getf(trackTunnelPitch)*time;
+	shape.radius = Rocket::getf(trackTunnelRadius);
+	const float speed = Rocket::getf(trackTunnelSpeed);
+	params.scroll = time*speed*speed;
+	params.uMul = Rocket::getf(trackTunnelMulU);
+	params.vMul = Rocket::getf(trackTunnelMulV);
+	params.baseFog = _mm_set1_ps(Rocket::getf(trackTunnelFog1)); // FIXME: should clamp, but lazy today
+	params.litFog = _mm_set1_ps(Rocket::getf(trackTunnelFog2));
+
+	// shape holds still (see RenderTunnelMap_2x2_Table()): build the table (while marching) unless it's up to date
+	const bool useTable = 0.f == Rocket::getf(trackTunnelPitch) && 0.f == Rocket::getf(trackTunnelRoll) && 0.f == Rocket::getf(trackTunnelFlowerPhase);
+	const bool buildTable = true == useTable && (false == s_tunnelTableValid || !(shape == s_tunnelTableShape));
 
+	if (true == buildTable)
+	{
+		s_tunnelTableShape = shape;
+		s_tunnelTableValid = true;
+	}
+
+	const unsigned numBands = NumBands(g_fxMapResY, kTunnelBandRows);
+
+	const auto march = s_tunnelGraph.Add("march", numBands, [=](unsigned iBand)
+	{
+		const unsigned firstRow = iBand*kTunnelBandRows;
+
+		if (false == useTable)
+			RenderTunnelMap_2x2(pMap, pGlow, params, firstRow, kTunnelBandRows);
+		else
+		{
+			if (true == buildTable)
+				BuildTunnelTable(shape, firstRow, kTunnelBandRows);
+
+			RenderTunnelMap_2x2_Table(pMap, pGlow, params, firstRow, kTunnelBandRows);
+		}
+	});
+
+	auto composed = march;
 	if (true == litTiles)
 	{
+		auto glow = march;
 		if (litBlur >= 1.f)
-			BoxBlur32(g_pFxMap[1], g_pFxMap[1], kFxMapResX, kFxMapResY, BoxBlurScale(litBlur)); // FIXME: can easily turn this into a directional blur by using different kernel sizes
+		{
+			// FIXME: can easily turn this into a directional blur by using different kernel sizes
+			// 2 passes (see BoxBlur32()): rows in bands, then columns in strips
+			const float strength = BoxBlurScale(litBlur);
 
-//		MulSrc32(g_pFxMap[2], g_pFxMap[1], kFxMapSize);
-		Add32(g_pFxMap[0], g_pFxMap[1], kFxMapSize);
+			const auto blurH = s_tunnelGraph.Add("glow blur (H)", numBands, [=](unsigned iBand)
+			{
+				const unsigned firstRow = iBand*kTunnelBandRows;
+				const Rect band = { 0, firstRow, unsigned(g_fxMapResX), std::min<unsigned>(kTunnelBandRows, unsigned(g_fxMapResY)-firstRow) };
+				HorizontalBoxBlur32R(pGlow, pGlow, band, g_fxMapPitch, strength);
+			}, { march });
+
+			glow = s_tunnelGraph.Add("glow blur (V)", NumBands(g_fxMapResX, kTunnelBandCols), [=](unsigned iStrip)
+			{
+				const unsigned firstCol = iStrip*kTunnelBandCols;
+				const Rect strip = { firstCol, 0, std::min<unsigned>(kTunnelBandCols, unsigned(g_fxMapResX)-firstCol), unsigned(g_fxMapResY) };
+				VerticalBoxBlur32R(pGlow, pGlow, strip, g_fxMapPitch, strength);
+			}, { blurH });
+		}
+
+//		MulSrc32(g_pFxMap[2], g_pFxMap[1], g_fxMapSize);
+		composed = s_tunnelGraph.Add("glow add", numBands, [=](unsigned iBand)
+		{
+			const size_t offset = iBand*kTunnelBandRows*g_fxMapPitch;
+			const size_t numPixels = std::min<size_t>(kTunnelBandRows*g_fxMapPitch, g_fxMapSize-offset);
+			Add32(pMap + offset, pGlow + offset, unsigned(numPixels));
+		}, { glow });
 	}
 
 //	Fx_Blit_2x2(g_renderTarget[0], g_pFxMap[0]);
-	Fx_Blit_2x2(pDest, g_pFxMap[0]);
+	s_tunnelGraph.Add("blit", numBands, [=](unsigned iBand)
+	{
+		Fx_Blit_2x2_Band(pDest, pMap, iBand*kTunnelBandRows, kTunnelBandRows);
+	}, { composed });
+
+	s_tunnelGraph.Run();
 
 	// FIXME: blur parameter!
-//	HorizontalBoxBlur32(pDest, g_renderTarget[0], kResX, kResY, 3.f*kBoxBlurScale);
+//	HorizontalBoxBlur32(pDest, g_renderTarget[0], g_resX, g_resY, 3.f*kBoxBlurScale);
 }
 
 //
@@ -925,11 +1143,11 @@ static void RenderSinMap_2x2(uint32_t *pDest, float time)
 	const Vector3 origin = fSinPath(time*speed);
 
 	#pragma omp parallel for schedule(dynamic)
-	for (unsigned iY = 0; iY < kFxMapResY; ++iY)
+	for (unsigned iY = 0; iY < g_fxMapResY; ++iY)
 	{
-		const auto yIndex = iY*kFxMapResX;
+		const auto yIndex = iY*g_fxMapPitch;
 
-		for (unsigned iX = 0; iX < kFxMapResX; iX += 4)
+		for (unsigned iX = 0; iX < g_fxMapResX; iX += 4)
 		{	
 			__m128 colors[4];
 
@@ -1014,7 +1232,7 @@ VIZ_INLINE const Vector3 LauraNormal(float march, const Vector3 &hit)
 	return normal;
 }
 
-void RenderLaura_2x2(uint32_t *pDest, float time)
+void RenderLaura_2x2(uint32_t *pDest, float time, const FxMapRes &res)
 {
 	const float lauraSpeed = Rocket::getf(trackLauraSpeed);
 	const float lauraYaw = Rocket::getf(trackLauraYaw);
@@ -1031,16 +1249,16 @@ void RenderLaura_2x2(uint32_t *pDest, float time)
 	Vector3 origin(0.f, 0.f, lauraSpeed*time);
 
 	#pragma omp parallel for schedule(dynamic) 
-	for (unsigned iY = 0; iY < kFxMapResY; ++iY)
+	for (unsigned iY = 0; iY < res.resY; ++iY)
 	{
-		const auto yIndex = iY*kFxMapResX;
+		const auto yIndex = iY*g_fxMapPitch;
 
-		for (unsigned iX = 0; iX < kFxMapResX; iX += 4)
+		for (unsigned iX = 0; iX < res.resX; iX += 4)
 		{	
 			__m128 colors[4];
 			for (int iColor = 0; iColor < 4; ++iColor)
 			{
-				auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY);
+				auto UV = Shadertoy::ToUV_FxMap(iColor+iX, iY, 2.f, res);
 
 				Vector3 direction(UV.x*kAspect, UV.y, kPI); 
 				Shadertoy::rotY(lauraYaw, direction.x, direction.z);
@@ -1102,8 +1320,13 @@ void RenderLaura_2x2(uint32_t *pDest, float time)
 	}
 }
 
+static FxGovernor s_lauraGovernor("Laura");
+
 void Laura_Draw(uint32_t *pDest, float time, float delta)
 {
-	RenderLaura_2x2(g_pFxMap[0], time);
-	Fx_Blit_2x2(pDest, g_pFxMap[0]);
+	const FxMapRes &res = s_lauraGovernor.Begin();
+	RenderLaura_2x2(g_pFxMap[0], time, res);
+	s_lauraGovernor.End();
+
+	Fx_Blit(pDest, g_pFxMap[0], res);
 }
@@ -2,6 +2,7 @@
 // cookiedough -- shared resources (FX)
 
 #include "main.h"
+#include "alloc-large.h"
 #include "image.h"
 
 __m128i g_gradientUnp16[kNumGradients];
@@ -9,6 +10,7 @@ __m128i g_gradientUnp16[kNumGradients];
 uint32_t *g_renderTarget[kNumRenderTargets] = { nullptr };
 
 uint32_t *g_pNytrikTPB = nullptr;
+Rect g_nytrikTPBRect;
 uint32_t *g_pXboxLogoTPB = nullptr;
 
 bool Shared_Create()
@@ -21,15 +23,15 @@ bool Shared_Create()
 
 	// allocate render targets
 	for (unsigned iTarget = 0; iTarget < kNumRenderTargets; ++iTarget)
-		g_renderTarget[iTarget] = static_cast<uint32_t*>(mallocAligned(kTargetBytes, kAlignTo));
+		g_renderTarget[iTarget] = static_cast<uint32_t*>(mallocLarge(g_targetBytes, "render targets"));
 
 	// load Nytrik's TPB 'end' logo
-	g_pNytrikTPB = Image_Load32("assets/demo/TPB-logo.png");
+	g_pNytrikTPB = Image_Load32_Crop("assets/demo/TPB-logo.png", g_nytrikTPBRect);
 	if (g_pNytrikTPB == NULL)
 		return false;
 
 	// load Alien's TPB-02 Xbox logo
-	g_pXboxLogoTPB = Image_Load32("assets/demo/tpb_xbox_tp-263x243.png");
+	g_pXboxLogoTPB = Image_Load32_Res("assets/demo/tpb_xbox_tp-263x243.png");
 	if (g_pXboxLogoTPB == NULL)
 		return false;
 
@@ -39,5 +41,5 @@ bool Shared_Create()
 void Shared_Destroy()
 {
 	for (unsigned iTarget = 0; iTarget < kNumRenderTargets; ++iTarget)
-		freeAligned(g_renderTarget[iTarget]);
+		freeLarge(g_renderTarget[iTarget]);
 }
@@ -7,19 +7,21 @@
 constexpr unsigned kNumGradients = 256;
 extern __m128i g_gradientUnp16[kNumGradients]; // unpacked to lower 16-bit
 
-// render targets
-constexpr unsigned kNumRenderTargets = 4;
+// render targets (effects use #0 as their own, anything else should request a ScratchTarget, see target-pool.h)
+constexpr unsigned kNumRenderTargets = 1;
 extern uint32_t *g_renderTarget[kNumRenderTargets];
 
 // FIXME: move these images to demo implementation!
-extern uint32_t *g_pNytrikTPB;   // Nytrik's 'end' TPB logo
+extern uint32_t *g_pNytrikTPB;   // Nytrik's 'end' TPB logo (cropped, see g_nytrikTPBRect)
+extern Rect g_nytrikTPBRect;
 extern uint32_t *g_pXboxLogoTPB; // Alien's thing for TPB-02 Xbox
 
 // render target resolution (let us agree to keep it's aspect ratio identical to the output resolution)
-constexpr size_t kTargetResX = kResX;
-constexpr size_t kTargetResY = kResY;
-constexpr size_t kTargetSize = kTargetResX*kTargetResY;
-constexpr size_t kTargetBytes = kTargetSize*sizeof(uint32_t);
+// - follows the output resolution picked at startup (see output.h)
+inline const size_t &g_targetResX = g_resX;
+inline const size_t &g_targetResY = g_resY;
+inline const size_t &g_targetSize = g_outputSize;
+inline const size_t &g_targetBytes = g_outputBytes;
 
 bool Shared_Create();
 void Shared_Destroy();
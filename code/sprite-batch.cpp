@@ -0,0 +1,155 @@
+// cookiedough -- batched sprites (particles, lens flares, logos)
+
+#include "main.h"
+#include "sprite-batch.h"
+
+void SpriteBatch::Add(const Sprite &sprite)
+{
+	VIZ_ASSERT(nullptr != sprite.pImage && sprite.scale > 0.f);
+
+	if (sprite.alpha > 0.f)
+		m_sprites.push_back(sprite);
+}
+
+// 2 pixels at a time, exactly like BlitAdd32A()
+CKD_INLINE static __m128i BlendAdd(__m128i srcColor, __m128i destColor, __m128i fixedAlphaUnp)
+{
+	const __m128i srcColorMod = _mm_srli_epi16(_mm_mullo_epi16(srcColor, fixedAlphaUnp), 8);
+	return _mm_add_epi16(destColor, srcColorMod);
+}
+
+// 2 pixels at a time, exactly like BlitSrc32A()
+CKD_INLINE static __m128i BlendSrc(__m128i srcColor, __m128i destColor, __m128i fixedAlphaUnp)
+{
+	const __m128i srcAlpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(srcColor, 0xff), 0xff);
+	const __m128i alphaUnp = _mm_srli_epi16(_mm_mullo_epi16(srcAlpha, fixedAlphaUnp), 8);
+	const __m128i delta = _mm_mullo_epi16(alphaUnp, _mm_sub_epi16(srcColor, destColor));
+	return _mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(destColor, 8), delta), 8);
+}
+
+template<SpriteBlend kBlend>
+CKD_INLINE static void BlendSpan(uint32_t *pDest, const uint32_t *pSrc, unsigned numPixels, __m128i fixedAlphaUnp)
+{
+	const __m128i zero = _mm_setzero_si128();
+
+	auto blend = [fixedAlphaUnp](__m128i srcColor, __m128i destColor)
+	{
+		return (SpriteBlend::kAdd == kBlend) ? BlendAdd(srcColor, destColor, fixedAlphaUnp) : BlendSrc(srcColor, destColor, fixedAlphaUnp);
+	};
+
+	unsigned iX = 0;
+	for (; iX+4 <= numPixels; iX += 4)
+	{
+		const __m128i src = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pSrc+iX));
+		const __m128i dest = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pDest+iX));
+		const __m128i lo = blend(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dest, zero));
+		const __m128i hi = blend(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dest, zero));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(pDest+iX), _mm_packus_epi16(lo, hi));
+	}
+
+	for (; iX < numPixels; ++iX)
+	{
+		const __m128i color = blend(_mm_unpacklo_epi8(_mm_cvtsi32_si128(pSrc[iX]), zero), _mm_unpacklo_epi8(_mm_cvtsi32_si128(pDest[iX]), zero));
+		pDest[iX] = _mm_cvtsi128_si32(_mm_packus_epi16(color, zero));
+	}
+}
+
+void SpriteBatch::Draw(uint32_t *pDest, unsigned resX, unsigned resY)
+{
+	m_pDest = pDest;
+	m_resX = resX;
+	m_numTilesX = NumBands(resX, kSpriteTileResX);
+	m_numTilesY = NumBands(resY, kSpriteTileResY);
+
+	const unsigned numTiles = m_numTilesX*m_numTilesY;
+	m_bins.resize(numTiles);
+	for (auto &bin : m_bins)
+		bin.clear();
+
+	// clip & bin
+	m_prepared.clear();
+	for (const Sprite &sprite : m_sprites)
+	{
+		// pixels whose center lies on the sprite
+		const float width = sprite.resX*sprite.scale, height = sprite.resY*sprite.scale;
+		const int left = int(ceilf(sprite.x-0.5f)), right = int(ceilf(sprite.x+width-0.5f))-1;
+		const int top = int(ceilf(sprite.y-0.5f)), bottom = int(ceilf(sprite.y+height-0.5f))-1;
+
+		Prepared prepared;
+		prepared.pSprite = &sprite;
+		prepared.minX = std::max(left, 0);
+		prepared.minY = std::max(top, 0);
+		prepared.maxX = std::min(right, int(resX)-1);
+		prepared.maxY = std::min(bottom, int(resY)-1);
+		if (prepared.minX > prepared.maxX || prepared.minY > prepared.maxY)
+			continue;
+
+		const float invScale = 1.f/sprite.scale;
+		prepared.U = int((prepared.minX+0.5f-sprite.x)*invScale*65536.f);
+		prepared.V = int((prepared.minY+0.5f-sprite.y)*invScale*65536.f);
+		prepared.step = int(invScale*65536.f);
+		prepared.alpha = unsigned(saturatef(sprite.alpha)*255.f);
+
+		const unsigned index = unsigned(m_prepared.size());
+		m_prepared.push_back(prepared);
+
+		for (unsigned iTileY = prepared.minY/kSpriteTileResY; iTileY <= prepared.maxY/kSpriteTileResY; ++iTileY)
+			for (unsigned iTileX = prepared.minX/kSpriteTileResX; iTileX <= prepared.maxX/kSpriteTileResX; ++iTileX)
+				m_bins[iTileY*m_numTilesX + iTileX].push_back(index);
+	}
+
+	if (false == m_prepared.empty())
+	{
+		m_graph.Add("composite", numTiles, [this](unsigned iTile) { DrawTile(iTile); });
+		m_graph.Run();
+	}
+
+	m_sprites.clear();
+}
+
+void SpriteBatch::DrawTile(unsigned iTile)
+{
+	const int tileMinX = (iTile % m_numTilesX)*kSpriteTileResX, tileMinY = (iTile / m_numTilesX)*kSpriteTileResY;
+	const int tileMaxX = tileMinX+kSpriteTileResX-1, tileMaxY = tileMinY+kSpriteTileResY-1;
+
+	// point sampled row of a scaled sprite
+	uint32_t scaled[kSpriteTileResX];
+
+	for (unsigned index : m_bins[iTile])
+	{
+		const Prepared &prepared = m_prepared[index];
+		const Sprite &sprite = *prepared.pSprite;
+
+		const int minX = std::max(tileMinX, prepared.minX), maxX = std::min(tileMaxX, prepared.maxX);
+		const int minY = std::max(tileMinY, prepared.minY), maxY = std::min(tileMaxY, prepared.maxY);
+		const unsigned numPixels = maxX-minX+1;
+
+		const int U = prepared.U + (minX-prepared.minX)*prepared.step;
+		const __m128i fixedAlphaUnp = _mm_set1_epi16(short(prepared.alpha)); // 2 pixels
+		const bool unscaled = 65536 == prepared.step;
+
+		for (int iY = minY; iY <= maxY; ++iY)
+		{
+			const int V = prepared.V + (iY-prepared.minY)*prepared.step;
+			const unsigned srcY = std::min<unsigned>(std::max(V >> 16, 0), sprite.resY-1);
+			const uint32_t *pSrcRow = sprite.pImage + srcY*sprite.resX;
+
+			const uint32_t *pSrc;
+			if (true == unscaled)
+				pSrc = pSrcRow + std::min<unsigned>(std::max(U >> 16, 0), sprite.resX-numPixels);
+			else
+			{
+				for (unsigned iX = 0; iX < numPixels; ++iX)
+					scaled[iX] = pSrcRow[std::min<unsigned>(std::max((U + int(iX)*prepared.step) >> 16, 0), sprite.resX-1)];
+
+				pSrc = scaled;
+			}
+
+			uint32_t *pDestRow = m_pDest + iY*m_resX + minX;
+			if (SpriteBlend::kAdd == sprite.blend)
+				BlendSpan<SpriteBlend::kAdd>(pDestRow, pSrc, numPixels, fixedAlphaUnp);
+			else
+				BlendSpan<SpriteBlend::kSrc>(pDestRow, pSrc, numPixels, fixedAlphaUnp);
+		}
+	}
+}
@@ -0,0 +1,72 @@
+// cookiedough -- batched sprites (particles, lens flares, logos)
+
+/*
+	Instead of a BlitAdd32A()/BlitSrc32A() call (and parallel loop) per sprite, collect them and draw them in one go:
+
+	SpriteBatch batch;
+	batch.Add({ .pImage = s_pLenz, .resX = 64, .resY = 64, .x = 100.f, .y = 200.f, .alpha = 0.5f });
+	...
+	batch.Draw(pDest, g_resX, g_resY); // empties the batch
+
+	- sprites are binned into screen tiles (kSpriteTileResX by kSpriteTileResY) and each tile composites it's sprites
+	  in the order they were added, so the result is the same as blitting them one by one (but clipped)
+	- an unscaled sprite on a whole pixel position is blended exactly like BlitAdd32A() and BlitSrc32A() do
+	- scaled sprites are point sampled
+	- images must stay put until Draw() returns
+*/
+
+#pragma once
+
+#include "task-graph.h"
+
+constexpr unsigned kSpriteTileResX = 128;
+constexpr unsigned kSpriteTileResY = 32;
+
+enum class SpriteBlend
+{
+	kAdd, // BlitAdd32A(): color*alpha is added
+	kSrc  // BlitSrc32A(): blended by source alpha*alpha
+};
+
+struct Sprite
+{
+	const uint32_t *pImage = nullptr;
+	unsigned resX = 0, resY = 0;
+	float x = 0.f, y = 0.f; // top left (in pixels)
+	float scale = 1.f;
+	float alpha = 1.f;      // [0..1]
+	SpriteBlend blend = SpriteBlend::kAdd;
+};
+
+class SpriteBatch
+{
+public:
+	SpriteBatch() : m_graph("Sprites") {}
+
+	void Add(const Sprite &sprite);
+	void Draw(uint32_t *pDest, unsigned resX, unsigned resY);
+
+	size_t GetNumSprites() const { return m_sprites.size(); }
+
+private:
+	// clipped to the screen, ready to composite
+	struct Prepared
+	{
+		const Sprite *pSprite;
+		int minX, minY, maxX, maxY; // destination (inclusive)
+		int U, V;                   // source at (minX, minY) (16.16 fixed point)
+		int step;                   // per destination pixel (16.16)
+		uint32_t alpha;             // [0..255]
+	};
+
+	void DrawTile(unsigned iTile);
+
+	std::vector<Sprite> m_sprites;
+	std::vector<Prepared> m_prepared;
+	std::vector<std::vector<unsigned>> m_bins; // per tile, indices into 'm_prepared'
+
+	uint32_t *m_pDest = nullptr;
+	unsigned m_resX = 0, m_numTilesX = 0, m_numTilesY = 0;
+
+	TaskGraph m_graph;
+};
@@ -0,0 +1,397 @@
+// cookiedough -- packed sync. bundle
+
+/*
+	Layout (little endian, everything aligned to kBundleAlign):
+	- header
+	- entries, sorted by hash (binary search)
+	- names (zero terminated, to rule out hash collisions)
+	- track data, in '.track' file format so the Rocket library can parse it as it always does
+
+	Each entry is stamped with the modification time of the '.track' file it was packed from: a loose track
+	that is newer than that (and differs) means the bundle is stale, in which case it's not used at all.
+
+	Entries are keyed by the exact path the library asks for (see sync_track_path() in device.c), so no
+	translation is needed in the I/O callbacks: one map upon start, no file I/O per track from there on out.
+*/
+
+#include "main.h"
+#include "sync-bundle.h"
+
+#include <filesystem>
+#include <limits>
+
+#if defined(_WIN32)
+	#define WIN32_LEAN_AND_MEAN
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <windows.h>
+#else
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <fcntl.h>
+	#include <unistd.h>
+#endif
+
+constexpr uint32_t kBundleMagic = 0x534b4443; // 'CDKS'
+constexpr uint32_t kBundleVersion = 2;
+constexpr size_t kBundleAlign = 16;
+
+struct BundleHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t numEntries;
+	uint32_t size; // of entire file
+};
+
+struct BundleEntry
+{
+	uint64_t hash;
+	uint32_t nameOffset;
+	uint32_t dataOffset;
+	uint32_t dataSize;
+	uint32_t padding;
+	int64_t modified; // of the loose track when packed (see TrackModified())
+};
+
+static_assert(0 == sizeof(BundleHeader) % kBundleAlign);
+static_assert(8 == alignof(BundleEntry) && 32 == sizeof(BundleEntry));
+
+// FNV-1a (64-bit)
+static uint64_t HashPath(const char *path)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	while (0 != *path)
+	{
+		hash ^= uint8_t(*path++);
+		hash *= 0x100000001b3ull;
+	}
+
+	return hash;
+}
+
+// mirrors path_encode() & sync_track_path() in device.c
+static std::string EncodePath(const std::string &path)
+{
+	std::string encoded;
+	for (char ch : path)
+	{
+		if ('.' == ch || '_' == ch || '/' == ch || isalnum(ch))
+			encoded += ch;
+		else
+		{
+			encoded += '-';
+			encoded += "0123456789ABCDEF"[(ch >> 4) & 0xf];
+			encoded += "0123456789ABCDEF"[ch & 0xf];
+		}
+	}
+
+	return encoded;
+}
+
+static std::string TrackPath(const std::string &base, const std::string &name)
+{
+	return EncodePath(base) + "_" + EncodePath(name) + ".track";
+}
+
+// in file clock ticks (can be negative, the epoch is up to the implementation), minimum if there's no such file
+static int64_t TrackModified(const std::string &path)
+{
+	std::error_code error;
+	const auto modified = std::filesystem::last_write_time(path, error);
+	return (error) ? std::numeric_limits<int64_t>::min() : int64_t(modified.time_since_epoch().count());
+}
+
+CKD_INLINE static size_t AlignUp(size_t offset) {
+	return (offset + kBundleAlign-1) & ~(kBundleAlign-1);
+}
+
+bool SyncBundle_Pack(const std::string &path, const std::string &base, const std::vector<SyncBundleTrack> &tracks)
+{
+	// sort by hash
+	std::vector<std::pair<uint64_t, size_t>> order;
+	std::vector<std::string> paths;
+	for (size_t iTrack = 0; iTrack < tracks.size(); ++iTrack)
+	{
+		paths.push_back(TrackPath(base, tracks[iTrack].name));
+		order.emplace_back(HashPath(paths.back().c_str()), iTrack);
+	}
+
+	std::sort(order.begin(), order.end());
+
+	// lay out
+	std::vector<BundleEntry> entries(tracks.size());
+	size_t offset = AlignUp(sizeof(BundleHeader) + entries.size()*sizeof(BundleEntry));
+
+	for (size_t iEntry = 0; iEntry < entries.size(); ++iEntry)
+	{
+		entries[iEntry].hash = order[iEntry].first;
+		entries[iEntry].nameOffset = uint32_t(offset);
+		entries[iEntry].modified = TrackModified(paths[order[iEntry].second]);
+		offset += paths[order[iEntry].second].size()+1;
+	}
+
+	for (size_t iEntry = 0; iEntry < entries.size(); ++iEntry)
+	{
+		offset = AlignUp(offset);
+		entries[iEntry].dataOffset = uint32_t(offset);
+		entries[iEntry].dataSize = uint32_t(tracks[order[iEntry].second].data.size());
+		entries[iEntry].padding = 0;
+		offset += entries[iEntry].dataSize;
+	}
+
+	const size_t size = AlignUp(offset);
+
+	// assemble
+	std::vector<uint8_t> bundle(size, 0);
+
+	const BundleHeader header = { kBundleMagic, kBundleVersion, uint32_t(entries.size()), uint32_t(size) };
+	memcpy(bundle.data(), &header, sizeof(header));
+	if (false == entries.empty())
+		memcpy(bundle.data() + sizeof(header), entries.data(), entries.size()*sizeof(BundleEntry));
+
+	for (size_t iEntry = 0; iEntry < entries.size(); ++iEntry)
+	{
+		const size_t iTrack = order[iEntry].second;
+		const std::string &trackPath = paths[iTrack];
+		memcpy(bundle.data() + entries[iEntry].nameOffset, trackPath.c_str(), trackPath.size()+1);
+
+		const std::vector<uint8_t> &data = tracks[iTrack].data;
+		if (false == data.empty())
+			memcpy(bundle.data() + entries[iEntry].dataOffset, data.data(), data.size());
+	}
+
+	// and write
+	FILE *pFile = fopen(path.c_str(), "wb");
+	if (nullptr == pFile)
+	{
+		SetLastError("Can not write sync. bundle: " + path);
+		return false;
+	}
+
+	const bool written = 1 == fwrite(bundle.data(), size, 1, pFile);
+	fclose(pFile);
+
+	if (false == written)
+	{
+		SetLastError("Can not write sync. bundle: " + path);
+		return false;
+	}
+
+	return true;
+}
+
+// mapped bundle
+static const uint8_t *s_pBundle = nullptr;
+static size_t s_bundleSize = 0;
+
+#if defined(_WIN32)
+	static HANDLE s_hFile = INVALID_HANDLE_VALUE;
+	static HANDLE s_hMapping = NULL;
+#endif
+
+bool SyncBundle_Open(const std::string &path)
+{
+	VIZ_ASSERT(nullptr == s_pBundle);
+
+#if defined(_WIN32)
+	s_hFile = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL|FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (INVALID_HANDLE_VALUE == s_hFile)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(s_hFile, &fileSize);
+	s_bundleSize = size_t(fileSize.QuadPart);
+
+	s_hMapping = CreateFileMappingA(s_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL != s_hMapping)
+		s_pBundle = static_cast<const uint8_t *>(MapViewOfFile(s_hMapping, FILE_MAP_READ, 0, 0, 0));
+#else
+	const int file = open(path.c_str(), O_RDONLY);
+	if (-1 == file)
+		return false;
+
+	struct stat fileStat;
+	if (0 == fstat(file, &fileStat))
+	{
+		s_bundleSize = size_t(fileStat.st_size);
+
+		void *pMapped = mmap(nullptr, s_bundleSize, PROT_READ, MAP_PRIVATE, file, 0);
+		if (MAP_FAILED != pMapped)
+		{
+			// it's small and we'll touch all of it right away
+			madvise(pMapped, s_bundleSize, MADV_WILLNEED);
+			s_pBundle = static_cast<const uint8_t *>(pMapped);
+		}
+	}
+
+	// mapping stays valid
+	close(file);
+#endif
+
+	if (nullptr == s_pBundle)
+	{
+		SyncBundle_Close();
+		return false;
+	}
+
+	// validate (a bad bundle is treated as if it isn't there)
+	const BundleHeader *pHeader = reinterpret_cast<const BundleHeader *>(s_pBundle);
+	if (s_bundleSize < sizeof(BundleHeader) || kBundleMagic != pHeader->magic || kBundleVersion != pHeader->version || s_bundleSize != pHeader->size ||
+		s_bundleSize < sizeof(BundleHeader) + size_t(pHeader->numEntries)*sizeof(BundleEntry))
+	{
+		printf("Sync. bundle is damaged or outdated, loading loose tracks: %s\n", path.c_str());
+		SyncBundle_Close();
+		return false;
+	}
+
+	const BundleEntry *pEntries = reinterpret_cast<const BundleEntry *>(s_pBundle + sizeof(BundleHeader));
+	for (uint32_t iEntry = 0; iEntry < pHeader->numEntries; ++iEntry)
+	{
+		const BundleEntry &entry = pEntries[iEntry];
+
+		// name and data must lie within the file (and the name must be terminated there)
+		const bool nameInBounds = entry.nameOffset < s_bundleSize && nullptr != memchr(s_pBundle + entry.nameOffset, 0, s_bundleSize - entry.nameOffset);
+		const bool dataInBounds = entry.dataOffset <= s_bundleSize && entry.dataSize <= s_bundleSize - entry.dataOffset;
+		if (false == nameInBounds || false == dataInBounds)
+		{
+			printf("Sync. bundle is damaged, loading loose tracks: %s\n", path.c_str());
+			SyncBundle_Close();
+			return false;
+		}
+	}
+
+	// loose tracks saved after the bundle was packed win (if they actually differ)
+	for (uint32_t iEntry = 0; iEntry < pHeader->numEntries; ++iEntry)
+	{
+		const BundleEntry &entry = pEntries[iEntry];
+		const char *trackPath = reinterpret_cast<const char *>(s_pBundle + entry.nameOffset);
+
+		if (TrackModified(trackPath) <= entry.modified)
+			continue;
+
+		bool identical = false;
+		FILE *pFile = fopen(trackPath, "rb");
+		if (nullptr != pFile)
+		{
+			std::vector<uint8_t> loose(entry.dataSize+1);
+			identical = entry.dataSize == fread(loose.data(), 1, loose.size(), pFile) && 0 == memcmp(loose.data(), s_pBundle + entry.dataOffset, entry.dataSize);
+			fclose(pFile);
+		}
+
+		if (false == identical)
+		{
+			printf("Sync. bundle is stale (%s is newer), loading loose tracks: %s\n", trackPath, path.c_str());
+			SyncBundle_Close();
+			return false;
+		}
+	}
+
+	printf("Sync. tracks (%u) served from bundle: %s\n", pHeader->numEntries, path.c_str());
+
+	return true;
+}
+
+void SyncBundle_Close()
+{
+#if defined(_WIN32)
+	if (nullptr != s_pBundle)
+		UnmapViewOfFile(s_pBundle);
+
+	if (NULL != s_hMapping)
+		CloseHandle(s_hMapping);
+
+	if (INVALID_HANDLE_VALUE != s_hFile)
+		CloseHandle(s_hFile);
+
+	s_hMapping = NULL;
+	s_hFile = INVALID_HANDLE_VALUE;
+#else
+	if (nullptr != s_pBundle)
+		munmap(const_cast<uint8_t *>(s_pBundle), s_bundleSize);
+#endif
+
+	s_pBundle = nullptr;
+	s_bundleSize = 0;
+}
+
+static const BundleEntry *FindEntry(const char *path)
+{
+	if (nullptr == s_pBundle)
+		return nullptr;
+
+	const BundleHeader *pHeader = reinterpret_cast<const BundleHeader *>(s_pBundle);
+	const BundleEntry *pFirst = reinterpret_cast<const BundleEntry *>(s_pBundle + sizeof(BundleHeader));
+	const BundleEntry *pLast = pFirst + pHeader->numEntries;
+
+	const uint64_t hash = HashPath(path);
+	const BundleEntry *pEntry = std::lower_bound(pFirst, pLast, hash, [](const BundleEntry &entry, uint64_t hash) { return entry.hash < hash; });
+	for (; pEntry != pLast && pEntry->hash == hash; ++pEntry)
+	{
+		if (0 == strcmp(reinterpret_cast<const char *>(s_pBundle + pEntry->nameOffset), path))
+			return pEntry;
+	}
+
+	return nullptr;
+}
+
+// stream: either (part of) the mapped bundle or a regular file
+struct BundleStream
+{
+	const uint8_t *pData;
+	size_t size, position;
+	FILE *pFile;
+};
+
+static void *BundleOpen(const char *path, const char *mode)
+{
+	const BundleEntry *pEntry = FindEntry(path);
+	if (nullptr != pEntry)
+		return new BundleStream{ s_pBundle + pEntry->dataOffset, pEntry->dataSize, 0, nullptr };
+
+	FILE *pFile = fopen(path, mode);
+	if (nullptr == pFile)
+		return nullptr;
+
+	return new BundleStream{ nullptr, 0, 0, pFile };
+}
+
+static size_t BundleRead(void *pDest, size_t size, size_t numItems, void *stream)
+{
+	BundleStream *pStream = static_cast<BundleStream *>(stream);
+	if (nullptr != pStream->pFile)
+		return fread(pDest, size, numItems, pStream->pFile);
+
+	// whole items only, like fread()
+	const size_t available = (pStream->size - pStream->position)/std::max<size_t>(1, size);
+	numItems = std::min(numItems, available);
+
+	memcpy(pDest, pStream->pData + pStream->position, size*numItems);
+	pStream->position += size*numItems;
+
+	return numItems;
+}
+
+static int BundleClose(void *stream)
+{
+	BundleStream *pStream = static_cast<BundleStream *>(stream);
+
+	int result = 0;
+	if (nullptr != pStream->pFile)
+		result = fclose(pStream->pFile);
+
+	delete pStream;
+	return result;
+}
+
+static sync_io_cb s_bundleCallbacks = {
+	BundleOpen,
+	BundleRead,
+	BundleClose
+};
+
+sync_io_cb *SyncBundle_GetIOCallbacks()
+{
+	return &s_bundleCallbacks;
+}
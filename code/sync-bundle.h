@@ -0,0 +1,30 @@
+// cookiedough -- packed sync. bundle: all Rocket tracks in a single aligned, memory-mappable file
+
+#pragma once
+
+#include "../3rdparty/rocket-stripped/lib/sync.h"
+
+// relative to working directory, like the loose tracks ('sync/*.track')
+constexpr const char *kSyncBundlePath = "sync/bundle.bin";
+
+// track as exported by Rocket (i.e. exactly what would otherwise be in it's '.track' file)
+struct SyncBundleTrack
+{
+	std::string name;
+	std::vector<uint8_t> data;
+};
+
+// offline: pack tracks into bundle (done by editor builds upon exit, see Rocket::Land())
+// 'base' must be the same as the one passed to sync_create_device()
+// each track is stamped with the modification time of it's '.track' file, so save those first
+bool SyncBundle_Pack(const std::string &path, const std::string &base, const std::vector<SyncBundleTrack> &tracks);
+
+// player: map bundle (returns false if it isn't there, in which case tracks are loaded one by one as before)
+// - a bundle with entries out of bounds, or one that's older than any loose track that differs from it, is not used either
+// - prints which one it is
+bool SyncBundle_Open(const std::string &path);
+void SyncBundle_Close();
+
+// I/O callbacks for sync_set_io_cb() that serve track files from the mapped bundle
+// anything not in it is still read from disk
+sync_io_cb *SyncBundle_GetIOCallbacks();
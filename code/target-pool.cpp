@@ -0,0 +1,111 @@
+// cookiedough -- transient (frame-scoped) render target pool
+
+#include "main.h"
+#include "alloc-large.h"
+#include "target-pool.h"
+
+#include <mutex>
+
+namespace
+{
+	struct Block
+	{
+		uint32_t *pMem;
+		size_t numPixels;
+		bool inUse;
+		unsigned generation; // bumped on each acquisition, so a stale release is caught
+		const char *owner;
+	};
+}
+
+static std::vector<Block> s_blocks;
+static std::mutex s_mutex;
+
+bool TargetPool_Create()
+{
+	return true;
+}
+
+void TargetPool_Destroy()
+{
+	for (const Block &block : s_blocks)
+	{
+		VIZ_ASSERT(false == block.inUse);
+		freeLarge(block.pMem);
+	}
+
+	s_blocks.clear();
+}
+
+void TargetPool_NewFrame()
+{
+#if defined(_DEBUG)
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	// if you end up here, the target named 'owner' was not released in the previous frame
+	for (const Block &block : s_blocks)
+		VIZ_ASSERT(false == block.inUse);
+#endif
+}
+
+size_t TargetPool_GetBytes()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	size_t numBytes = 0;
+	for (const Block &block : s_blocks)
+		numBytes += block.numPixels*sizeof(uint32_t);
+
+	return numBytes;
+}
+
+ScratchTarget::ScratchTarget(unsigned resX, unsigned resY, const char *name)
+{
+	const size_t numPixels = size_t(resX)*resY;
+	VIZ_ASSERT(numPixels > 0);
+
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	// smallest free block that fits
+	size_t iBest = s_blocks.size();
+	for (size_t iBlock = 0; iBlock < s_blocks.size(); ++iBlock)
+	{
+		const Block &block = s_blocks[iBlock];
+		if (false == block.inUse && block.numPixels >= numPixels)
+		{
+			if (iBest == s_blocks.size() || block.numPixels < s_blocks[iBest].numPixels)
+				iBest = iBlock;
+		}
+	}
+
+	if (iBest == s_blocks.size())
+	{
+		// none: grow (rounded up to 4 pixels so memset32() & co. can be used on any target)
+		const size_t numAllocPixels = (numPixels+3) & ~size_t(3);
+		s_blocks.push_back({ static_cast<uint32_t*>(mallocLarge(numAllocPixels*sizeof(uint32_t), "scratch targets")), numAllocPixels, false, 0, nullptr });
+	}
+
+	Block &block = s_blocks[iBest];
+	block.inUse = true;
+	block.owner = name;
+
+	m_iBlock = iBest;
+	m_generation = ++block.generation;
+	m_pTarget = block.pMem;
+}
+
+ScratchTarget::~ScratchTarget()
+{
+	std::lock_guard<std::mutex> lock(s_mutex);
+
+	Block &block = s_blocks[m_iBlock];
+	VIZ_ASSERT(true == block.inUse && m_generation == block.generation);
+
+#if defined(_DEBUG)
+	// make any use after release stand out
+	std::fill(block.pMem, block.pMem + block.numPixels, 0xffff00ff);
+#endif
+
+	block.inUse = false;
+	block.owner = nullptr;
+}
@@ -0,0 +1,49 @@
+// cookiedough -- transient (frame-scoped) render target pool
+
+/*
+	Instead of picking one of the fixed render targets by index and hoping nobody else is using it, request a
+	ScratchTarget of the size you need for as long as you need it:
+
+	{
+		ScratchTarget target(g_resX, g_resY, "blur");
+		HorizontalBoxBlur32(target, pSrc, g_resX, g_resY, strength);
+		...
+	} // released, memory is up for grabs
+
+	- memory is recycled (aliased) between targets whose lifetimes don't overlap, so the pool only ever grows
+	  to the peak number of simultaneously live targets
+	- contents are undefined upon acquisition (debug builds fill released memory with garbage to make sure
+	  you'll see it if a pointer outlives it's target)
+	- thread-safe (can be used inside task graphs)
+	- targets must not live across frames: TargetPool_NewFrame() asserts that
+	- all targets are 32-bit (ARGB8888), it's the only format we've got
+*/
+
+#pragma once
+
+bool TargetPool_Create();
+void TargetPool_Destroy();
+
+// call at the top of each frame (checks for targets still being held)
+void TargetPool_NewFrame();
+
+// for debugging & tuning
+size_t TargetPool_GetBytes();
+
+class ScratchTarget
+{
+public:
+	ScratchTarget(unsigned resX, unsigned resY, const char *name);
+	~ScratchTarget();
+
+	ScratchTarget(const ScratchTarget &) = delete;
+	ScratchTarget &operator=(const ScratchTarget &) = delete;
+
+	uint32_t *Get() const { return m_pTarget; }
+	operator uint32_t *() const { return m_pTarget; }
+
+private:
+	size_t m_iBlock;
+	unsigned m_generation;
+	uint32_t *m_pTarget;
+};
@@ -0,0 +1,191 @@
+// cookiedough -- per-frame task graph (work stealing on top of the OpenMP team)
+
+#include "main.h"
+#include "task-graph.h"
+
+#include <atomic>
+#include <mutex>
+#include <deque>
+
+TaskGraph::Task TaskGraph::Add(const char *name, unsigned numTiles, std::function<void(unsigned iTile)> function, std::initializer_list<Task> dependencies /* = {} */)
+{
+	VIZ_ASSERT(numTiles > 0);
+
+	const Task task = Task(m_nodes.size());
+	m_nodes.push_back({ name, numTiles, std::move(function), {}, unsigned(dependencies.size()), m_tileTimes.size() });
+	m_tileTimes.resize(m_tileTimes.size() + numTiles, 0.f);
+
+	for (Task dependency : dependencies)
+	{
+		VIZ_ASSERT(dependency < task);
+		m_nodes[dependency].successors.push_back(task);
+	}
+
+	return task;
+}
+
+namespace
+{
+	struct WorkItem
+	{
+		TaskGraph::Task task;
+		unsigned iTile;
+	};
+
+	// owner pushes & pops at the back, thieves take from the front (biggest chunk of remaining work, least contention)
+	struct WorkQueue
+	{
+		std::mutex mutex;
+		std::deque<WorkItem> items;
+
+		void Push(TaskGraph::Task task, unsigned numTiles)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			for (unsigned iTile = numTiles; iTile > 0; --iTile)
+				items.push_back({ task, iTile-1 });
+		}
+
+		bool Pop(WorkItem &item)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (true == items.empty())
+				return false;
+
+			item = items.back();
+			items.pop_back();
+			return true;
+		}
+
+		bool Steal(WorkItem &item)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			if (true == items.empty())
+				return false;
+
+			item = items.front();
+			items.pop_front();
+			return true;
+		}
+	};
+}
+
+void TaskGraph::Run()
+{
+	const size_t numNodes = m_nodes.size();
+	if (0 == numNodes)
+		return;
+
+	const double start = omp_get_wtime();
+
+	std::unique_ptr<std::atomic<unsigned>[]> dependenciesLeft(new std::atomic<unsigned>[numNodes]);
+	std::unique_ptr<std::atomic<unsigned>[]> tilesLeft(new std::atomic<unsigned>[numNodes]);
+	for (size_t iNode = 0; iNode < numNodes; ++iNode)
+	{
+		dependenciesLeft[iNode] = m_nodes[iNode].numDependencies;
+		tilesLeft[iNode] = m_nodes[iNode].numTiles;
+	}
+
+	const unsigned numThreads = unsigned(omp_get_max_threads());
+	std::unique_ptr<WorkQueue[]> queues(new WorkQueue[numThreads]);
+
+	// spread what's ready to go
+	unsigned iQueue = 0;
+	for (size_t iNode = 0; iNode < numNodes; ++iNode)
+		if (0 == m_nodes[iNode].numDependencies)
+			queues[iQueue++ % numThreads].Push(Task(iNode), m_nodes[iNode].numTiles);
+
+	std::atomic<size_t> numDone = 0;
+
+	#pragma omp parallel num_threads(numThreads)
+	{
+		const unsigned iThread = unsigned(omp_get_thread_num());
+		WorkQueue &queue = queues[iThread];
+
+		while (numDone < numNodes)
+		{
+			WorkItem item;
+			bool found = queue.Pop(item);
+			for (unsigned iVictim = 1; false == found && iVictim < numThreads; ++iVictim)
+				found = queues[(iThread+iVictim) % numThreads].Steal(item);
+
+			if (false == found)
+			{
+				std::this_thread::yield();
+				continue;
+			}
+
+			Node &node = m_nodes[item.task];
+
+			const double tileStart = omp_get_wtime();
+			node.function(item.iTile);
+			m_tileTimes[node.firstTile + item.iTile] = float((omp_get_wtime()-tileStart)*1000.0);
+
+			if (1 == tilesLeft[item.task]--)
+			{
+				// last tile: release successors (onto own queue, their input is likely still in our cache)
+				for (Task successor : node.successors)
+					if (1 == dependenciesLeft[successor]--)
+						queue.Push(successor, m_nodes[successor].numTiles);
+
+				++numDone;
+			}
+		}
+	}
+
+	UpdateStats(float((omp_get_wtime()-start)*1000.0));
+
+	m_nodes.clear();
+	m_tileTimes.clear();
+}
+
+void TaskGraph::UpdateStats(float wall)
+{
+	const size_t numNodes = m_nodes.size();
+
+	m_stats.work = 0.f;
+	m_stats.wall = wall;
+
+	// nodes are in topological order by definition, so one pass does it
+	std::vector<float> finish(numNodes, 0.f);
+	std::vector<size_t> previous(numNodes, size_t(-1));
+
+	size_t iLast = 0;
+	for (size_t iNode = 0; iNode < numNodes; ++iNode)
+	{
+		const Node &node = m_nodes[iNode];
+
+		float span = 0.f;
+		for (unsigned iTile = 0; iTile < node.numTiles; ++iTile)
+		{
+			const float time = m_tileTimes[node.firstTile + iTile];
+			m_stats.work += time;
+			span = std::max(span, time);
+		}
+
+		finish[iNode] += span;
+		for (Task successor : node.successors)
+		{
+			if (finish[iNode] > finish[successor])
+			{
+				finish[successor] = finish[iNode];
+				previous[successor] = iNode;
+			}
+		}
+
+		if (finish[iNode] > finish[iLast])
+			iLast = iNode;
+	}
+
+	m_stats.criticalPath = finish[iLast];
+
+	m_stats.path.clear();
+	for (size_t iNode = iLast; size_t(-1) != iNode; iNode = previous[iNode])
+		m_stats.path = std::string(m_nodes[iNode].name) + (m_stats.path.empty() ? "" : " > ") + m_stats.path;
+
+#if !defined(SYNC_PLAYER)
+	if (true == ImGuiIsVisible())
+	{
+		ImGui::Text("%s: %.2fms wall, %.2fms work, %.2fms critical path (%s)", m_name, m_stats.wall, m_stats.work, m_stats.criticalPath, m_stats.path.c_str());
+	}
+#endif
+}
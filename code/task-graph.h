@@ -0,0 +1,68 @@
+// cookiedough -- per-frame task graph (work stealing on top of the OpenMP team)
+
+/*
+	Instead of a barrier after each kernel (every '#pragma omp parallel for'), a part builds a small graph each frame:
+	tasks split into tiles (row bands, mostly) that start as soon as the tasks they depend on are done, so independent
+	work overlaps. Each thread works off it's own queue and steals from others when it runs dry.
+
+	- tasks must be added after the tasks they depend on
+	- tile functions run inside the team, so kernels with their own parallel loop called from there run single threaded
+	  (nested parallelism is off); call them on a band, not the whole buffer
+	- after Run() the graph is empty again and GetStats() tells you the total work and the critical path (if you had
+	  infinite cores, each task taking as long as it's slowest tile): if work/critical path is low, there's not enough
+	  to overlap and you'll want smaller tiles or less dependencies
+*/
+
+#pragma once
+
+#include <functional>
+
+class TaskGraph
+{
+public:
+	typedef unsigned Task;
+
+	struct Stats
+	{
+		float work = 0.f;         // ms (all tiles, summed)
+		float criticalPath = 0.f; // ms
+		float wall = 0.f;         // ms (time Run() took)
+		std::string path;         // names of tasks on critical path
+	};
+
+	TaskGraph(const char *name) : m_name(name) {}
+
+	Task Add(const char *name, unsigned numTiles, std::function<void(unsigned iTile)> function, std::initializer_list<Task> dependencies = {});
+
+	Task Add(const char *name, std::function<void()> function, std::initializer_list<Task> dependencies = {})
+	{
+		return Add(name, 1, [function](unsigned) { function(); }, dependencies);
+	}
+
+	void Run();
+
+	const Stats &GetStats() const { return m_stats; }
+
+private:
+	struct Node
+	{
+		const char *name;
+		unsigned numTiles;
+		std::function<void(unsigned)> function;
+		std::vector<Task> successors;
+		unsigned numDependencies;
+		size_t firstTile; // index into m_tileTimes
+	};
+
+	void UpdateStats(float wall);
+
+	const char *m_name;
+	std::vector<Node> m_nodes;
+	std::vector<float> m_tileTimes;
+	Stats m_stats;
+};
+
+// helper: number of bands of 'bandSize' needed to cover 'size'
+constexpr unsigned NumBands(size_t size, size_t bandSize) {
+	return unsigned((size + bandSize-1)/bandSize);
+}
@@ -1,10 +1,158 @@
-
 // cookiedough -- this is where functional tests go (FIXME: or rather, where they should go)
 
 #include "main.h"
 // #include "tests.h"
+#include "retro3D/retro3D.h"
 
-bool RunTests()
+// counter-based random generator (random.h): SIMD lanes must match the scalar version, no matter how (or by how
+// many threads) the counters are divided
+static bool TestRandom()
 {
+	constexpr int kNumValues = 4096;
+	const uint32_t key = ctr_rand_key(0xbadf00d, 1);
+
+	std::vector<uint32_t> values(kNumValues);
+
+	#pragma omp parallel for schedule(dynamic, 16)
+	for (int iValue = 0; iValue < kNumValues; iValue += 4)
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(&values[iValue]), ctr_randu32x4(key, iValue));
+
+	for (int iValue = 0; iValue < kNumValues; ++iValue)
+	{
+		const float normalized = ctr_rand_norm_f(key, iValue);
+		if (values[iValue] != ctr_randu32(key, iValue) || normalized <= 0.f || normalized > 1.f)
+		{
+			SetLastError("Functional test failed: counter-based random generator (random.h).");
+			return false;
+		}
+	}
+
 	return true;
 }
+
+// retro3D (retro3D/retro3D.h): edge function fill (top-left rule, no cracks), vertex stage clipping and depth
+// hierarchy rejection, on a tiny buffer of 2x2 tiles
+static bool TestRetro3D()
+{
+	using namespace retro3D;
+
+	constexpr unsigned kTestResX = kTileResX*2, kTestResY = kTileResY*2;
+	std::vector<uint32_t> pixels(kTestResX*kTestResY);
+
+	constexpr uint32_t kRed = 0xffff0000, kGreen = 0xff00ff00, kBlue = 0xff0000ff;
+
+	// rectangle (pixels, exclusive) split along it's diagonal, corners on pixel centers so every edge runs through
+	// them: the fill rule keeps the top and left edges (and the diagonal once), so exactly the pixels inside are filled
+	constexpr int kRectMinX = 8, kRectMinY = 8, kRectMaxX = 40, kRectMaxY = 24;
+	constexpr int kHalfPixel = kSubPixelOne>>1;
+
+	auto quad = [&](float projZ, uint32_t ARGB)
+	{
+		const int X[4] = { kRectMinX, kRectMaxX, kRectMaxX, kRectMinX }, Y[4] = { kRectMinY, kRectMinY, kRectMaxY, kRectMaxY };
+
+		std::vector<Projected> vertices;
+		for (int iVertex = 0; iVertex < 4; ++iVertex)
+			vertices.push_back({ (X[iVertex]<<kSubPixelBits) + kHalfPixel, (Y[iVertex]<<kSubPixelBits) + kHalfPixel, projZ, ARGB, Vector2(0.f, 0.f) });
+
+		return vertices;
+	};
+
+	auto inRect = [&](unsigned iX, unsigned iY)
+	{
+		return int(iX) >= kRectMinX && int(iX) < kRectMaxX && int(iY) >= kRectMinY && int(iY) < kRectMaxY;
+	};
+
+	const Face quadFaces[2] = { { 0, 1, 2 }, { 0, 2, 3 } };
+
+	TriFiller filler;
+
+	// fill
+	{
+		const std::vector<Projected> vertices = quad(1.f, kRed);
+
+		Material material;
+		material.depthTest = false;
+
+		filler.Begin(pixels.data(), kTestResX, kTestResY);
+		filler.Add(vertices.data(), quadFaces, 2, material);
+		filler.Flush();
+
+		for (unsigned iY = 0; iY < kTestResY; ++iY)
+		{
+			for (unsigned iX = 0; iX < kTestResX; ++iX)
+			{
+				if (pixels[iY*kTestResX + iX] != (inRect(iX, iY) ? kRed : 0))
+				{
+					SetLastError("Functional test failed: retro3D triangle fill (retro3D/tri-filler.h).");
+					return false;
+				}
+			}
+		}
+	}
+
+	// clipping & depth hierarchy: a triangle way past the guard band that covers the screen, one outside of the
+	// frustum, then a quad behind it (must be rejected) and one in front of it
+	{
+		std::fill(pixels.begin(), pixels.end(), 0);
+
+		const Vertex clipVertices[6] = {
+			{ Vector3(-200.f, -200.f, 0.5f), kRed, Vector2(0.f, 0.f) },
+			{ Vector3(   0.f,  400.f, 0.5f), kRed, Vector2(0.f, 0.f) },
+			{ Vector3( 200.f, -200.f, 0.5f), kRed, Vector2(0.f, 0.f) },
+			{ Vector3(   2.f,   -1.f, 0.5f), kRed, Vector2(0.f, 0.f) },
+			{ Vector3(   3.f,    1.f, 0.5f), kRed, Vector2(0.f, 0.f) },
+			{ Vector3(   3.f,   -1.f, 0.5f), kRed, Vector2(0.f, 0.f) }
+		};
+
+		const Face clipFaces[2] = { { 0, 1, 2 }, { 3, 4, 5 } };
+
+		// clip space is object space: W is 1, so projZ is too
+		const Material material;
+		VertexStage stage;
+		stage.Process(clipVertices, 6, clipFaces, 2, Matrix44::Identity(), kTestResX, kTestResY, material);
+
+		const VertexStage::Stats &stageStats = stage.GetStats();
+		if (1 != stageStats.numClipped || 1 != stageStats.numRejected || 0 == stage.GetNumFaces())
+		{
+			SetLastError("Functional test failed: retro3D clipping (retro3D/vertex-stage.h).");
+			return false;
+		}
+
+		const std::vector<Projected> behind = quad(0.5f, kGreen), inFront = quad(2.f, kBlue);
+
+		filler.Begin(pixels.data(), kTestResX, kTestResY);
+		filler.Add(stage.GetVertices(), stage.GetFaces(), stage.GetNumFaces(), material);
+		filler.Add(behind.data(), quadFaces, 2, material);
+		filler.Add(inFront.data(), quadFaces, 2, material);
+		filler.Flush();
+
+		for (unsigned iY = 0; iY < kTestResY; ++iY)
+		{
+			for (unsigned iX = 0; iX < kTestResX; ++iX)
+			{
+				if (pixels[iY*kTestResX + iX] != (inRect(iX, iY) ? kBlue : kRed))
+				{
+					SetLastError("Functional test failed: retro3D clipping & depth test (retro3D/vertex-stage.h, retro3D/tri-filler.h).");
+					return false;
+				}
+			}
+		}
+
+		// the quad behind is rejected per tile before it's interpolated, and IsOccluded() agrees on the (bottom left)
+		// block the quad in front covers entirely with one triangle, but not on anything in front of that quad
+		if (0 == filler.GetOcclusionStats().numTriangles ||
+			false == filler.IsOccluded(kRectMinX, kRectMaxY-kBlockRes, kRectMinX+kBlockRes-1, kRectMaxY-1, 1.5f) ||
+			true == filler.IsOccluded(kRectMinX, kRectMinY, kRectMaxX-1, kRectMaxY-1, 3.f))
+		{
+			SetLastError("Functional test failed: retro3D depth hierarchy (retro3D/tri-filler.h).");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool RunTests()
+{
+	return TestRandom() && TestRetro3D();
+}
@@ -34,7 +34,7 @@ const unsigned int kRayLength = 512;
 static unsigned s_heightProj[kRayLength];
 static unsigned s_heightProjNorm[kRayLength];
 
-// max. radius (in pixels)
+// max. radius (in pixels at author resolution, scaled by g_resScale)
 const float kCylRadius = 600.f;
 
 static void vtwister_ray(uint32_t *pDest, int curX, int curY, int dX)
@@ -95,22 +95,22 @@ static void vtwister(uint32_t *pDest, float time)
 	constexpr float fMapSize = float(kMapSize);
 	constexpr float fMapSizeHH = (fMapSize*0.5f) - 0.5f;
 	constexpr float fMapSizeHHH = (fMapSize*0.25f) - 0.5f;
-	constexpr float mapStepY = fMapSize/(kTargetResY-1); 
+	const float mapStepY = fMapSize/(g_targetResY-1); 
 
 	const float speed = Rocket::getf(trackTwisterSpeed);
 	const float shearSpeed = Rocket::getf(trackTwisterShearSpeed);
 
 	// FIXME: I really wonder if throwing "all" threads at this is worth the overhead -> measure
 	#pragma omp parallel for schedule(static) // dynamic isn't that appropriate given the usual geometry (and thus calc. load) of a twister
-	for (unsigned iRay = 0; iRay < kTargetResY; ++iRay)
+	for (unsigned iRay = 0; iRay < g_targetResY; ++iRay)
 	{
-		const float shearAngle = (float) iRay * (k2PI/(kTargetResY-1));
+		const float shearAngle = (float) iRay * (k2PI/(g_targetResY-1));
 
 		const float mapY = iRay*mapStepY;
 		const int fromX = ftofp24(fMapSizeHH + fMapSizeHHH*sinf(time*shearSpeed + shearAngle));
 		const int fromY = ftofp24(mapY + time*speed);
 
-		const size_t xOffs = iRay*kTargetResX + (kTargetResX>>1);
+		const size_t xOffs = iRay*g_targetResX + (g_targetResX>>1);
 		vtwister_ray(pDest+xOffs, fromX, fromY,  kMapSize/2);
 		vtwister_ray(pDest+xOffs-1, fromX- kMapSize/2, fromY, -(kMapSize/2));
 	}
@@ -122,7 +122,7 @@ void vtwister_precalc()
 	for (unsigned int iAngle = 0; iAngle < kRayLength; ++iAngle)
 	{
 		const float angle = kPI/(kRayLength-1) * iAngle;
-		const float scale = kCylRadius*sinf(angle);
+		const float scale = kCylRadius*g_resScale*sinf(angle);
 		s_heightProj[iAngle] = (unsigned) scale;
 		
 		// for basic lighting
@@ -147,7 +147,7 @@ bool Twister_Create()
 		return false;
 
 	// load background (1280x720)
-	s_pBackground = Image_Load32("assets/twister/nytrik-background_1280x720.png");
+	s_pBackground = Image_Load32_Res("assets/twister/nytrik-background_1280x720.png");
 	if (nullptr == s_pBackground)
 		return false;
 
@@ -166,7 +166,7 @@ void Twister_Destroy()
 void Twister_Draw(uint32_t *pDest, float time, float delta)
 {
 	// render twister 
-	memset32(g_renderTarget[0], 0, kTargetSize); // FIXME
+	memset32(g_renderTarget[0], 0, g_targetSize); // FIXME
 	vtwister(g_renderTarget[0], time);
 
 	// (radial) blur
@@ -174,15 +174,12 @@ void Twister_Draw(uint32_t *pDest, float time, float delta)
 	if (0.f != blur)
 	{
 		const float scaledBlur = BoxBlurScale(blur);
-		HorizontalBoxBlur32(g_renderTarget[0], g_renderTarget[0], kTargetResX, kTargetResY, scaledBlur);
+		HorizontalBoxBlur32(g_renderTarget[0], g_renderTarget[0], g_targetResX, g_targetResY, scaledBlur);
 	}
 
-	// blit background (FIXME)
-	memcpy(pDest, s_pBackground, kOutputBytes);
-
-	// polar blit
-	Polar_BlitA(pDest, g_renderTarget[0]);
+	// polar blit on top of background
+	Polar_BlitA(pDest, s_pBackground, g_renderTarget[0]);
 
 	// debug blit (vertical)
-//	memcpy(pDest, g_renderTarget[0], kOutputBytes);
+//	memcpy(pDest, g_renderTarget[0], g_outputBytes);
 }
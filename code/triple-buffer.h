@@ -0,0 +1,51 @@
+// cookiedough -- lock-free triple buffer (single producer, single consumer, latest wins)
+
+#pragma once
+
+#include <atomic>
+
+// - producer fills Back() and calls Publish(), never waits (unless it asks to, see WaitForFetch())
+// - consumer calls Fetch() whenever it likes and reads Front() which stays put until the next successful Fetch()
+// - if the producer publishes more than once in between the consumer only gets to see the latest
+template<typename T>
+class TripleBuffer
+{
+public:
+	// producer
+	T &Back() { return m_buffers[m_back]; }
+
+	void Publish()
+	{
+		m_back = m_middle.exchange(m_back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+	}
+
+	// blocks until the consumer has picked up what was published last (so nothing gets dropped)
+	void WaitForFetch()
+	{
+		unsigned middle;
+		while (0 != ((middle = m_middle.load(std::memory_order_acquire)) & kFresh))
+			m_middle.wait(middle, std::memory_order_acquire);
+	}
+
+	// consumer (returns true if Front() changed)
+	bool Fetch()
+	{
+		if (0 == (m_middle.load(std::memory_order_relaxed) & kFresh))
+			return false;
+
+		m_front = m_middle.exchange(m_front, std::memory_order_acq_rel) & kIndexMask;
+		m_middle.notify_one();
+		return true;
+	}
+
+	const T &Front() const { return m_buffers[m_front]; }
+	T &Front() { return m_buffers[m_front]; }
+
+private:
+	static constexpr unsigned kIndexMask = 3;
+	static constexpr unsigned kFresh = 4;
+
+	T m_buffers[3];
+	unsigned m_back = 0, m_front = 1;
+	std::atomic<unsigned> m_middle = 2;
+};
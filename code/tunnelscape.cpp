@@ -27,7 +27,7 @@ static __m128i s_fogGradientUnp[256];
 
 // -- voxel renderer --
 
-// adjust to map (FIXME: parametrize)
+// adjust to map (FIXME: parametrize), tilt & scale are in pixels (see ToRes())
 constexpr float kMapViewLenScale = kAspect*0.5f; // FIXME: turn this into the closest integer (hardcoded) instead of "ftol()'ing" it
 constexpr int kMapViewHeight = 96;
 constexpr int kMapTilt = 120;
@@ -41,10 +41,10 @@ constexpr unsigned kMapShift = 11;
 // trace depth
 const unsigned int kRayLength = 512; // 256 -- used for fog table!
 
-static void tscape_ray(uint32_t *pDest, int curX, int curY, int dX, int dY)
+static void tscape_ray(uint32_t *pDest, int curX, int curY, int dX, int dY, int mapTilt, int mapScale)
 {
-	int lastHeight = kResX;
-	int lastDrawnHeight = kResX;
+	int lastHeight = g_resX;
+	int lastDrawnHeight = g_resX;
 
 	const unsigned int U = curX >> 8 & kMapAnd, V = (curY >> 8 & kMapAnd) << kMapShift;
 	__m128i lastColor = c2vISSE16(s_pColorMap[U|V]);
@@ -77,9 +77,9 @@ static void tscape_ray(uint32_t *pDest, int curX, int curY, int dX, int dY)
 		height <<= 8;
 		height = int(height/kMapViewLenScale); // FIXME: this is pure evil, heed the FIXME above soon!
 		height /= iStep+1;          //
-		height *= kMapScale;
+		height *= mapScale;
 		height >>= 8;
-		height += kMapTilt;
+		height += mapTilt;
 
 		VIZ_ASSERT(height >= 0);
 
@@ -103,7 +103,7 @@ static void tscape_ray(uint32_t *pDest, int curX, int curY, int dX, int dY)
 static void tscape(uint32_t *pDest, float time)
 {
 //	float mapX = 0.f; 
-	constexpr float mapStepX = 2048.f/(kTargetResY-1); // tile (for blit)
+	const float mapStepX = 2048.f/(g_targetResY-1); // tile (for blit)
 
 	const float syncDirX = Rocket::getf(trackStarsStepU);
 	const float syncDirY = Rocket::getf(trackStarsStepV);
@@ -117,16 +117,19 @@ static void tscape(uint32_t *pDest, float time)
 
 	const auto fpFromY = ftofp24(fromY);
 
+	const int mapTilt = ToRes(kMapTilt);
+	const int mapScale = ToRes(kMapScale);
+
 	// FIXME: I really wonder if throwing "all" threads at this is worth the overhead -> measure
 	#pragma omp parallel for schedule(static) // static is fine for most landscapes
-	for (unsigned iRay = 0; iRay < kTargetResY; ++iRay)
+	for (unsigned iRay = 0; iRay < g_targetResY; ++iRay)
 	{
 		const float mapX = iRay*mapStepX;
 		const float fromX = mapX + syncDirX * time*kGoldenRatio;
 
-		tscape_ray(pDest + iRay*kTargetResX, ftofp24(fromX), fpFromY, dX, dY);
+		tscape_ray(pDest + iRay*g_targetResX, ftofp24(fromX), fpFromY, dX, dY, mapTilt, mapScale);
 
-//		pDest += kTargetResX;
+//		pDest += g_targetResX;
 //		mapX += mapStepX;
 	}
 
@@ -167,7 +170,7 @@ void Tunnelscape_Destroy()
 
 void Tunnelscape_Draw(uint32_t *pDest, float time, float delta)
 {
-	memset32(g_renderTarget[0], s_pFogGradient[0], kTargetResX*kTargetResY);
+	memset32(g_renderTarget[0], s_pFogGradient[0], g_targetResX*g_targetResY);
 	tscape(g_renderTarget[0], time);
 
 	// polar blit
@@ -180,7 +183,7 @@ void Tunnelscape_Draw(uint32_t *pDest, float time, float delta)
 		const float scaledBlur = BoxBlurScale(blur);
 
 		// Twice, and not efficiently, but to come closer to non-linearity!
-		BoxBlur32(pDest, pDest, kResX, kResY, scaledBlur);
-		BoxBlur32(pDest, pDest, kResX, kResY, scaledBlur);
+		BoxBlur32(pDest, pDest, g_resX, g_resY, scaledBlur);
+		BoxBlur32(pDest, pDest, g_resX, g_resY, scaledBlur);
 	}
 }
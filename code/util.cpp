@@ -129,6 +129,22 @@ void Mix32(uint32_t *pDest, const uint32_t *pSrc, unsigned int numPixels, uint8_
 #endif
 }
 
+void Mix32(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, unsigned numPixels, uint8_t alpha)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i alphaUnp = _mm_unpacklo_epi8(_mm_cvtsi32_si128(0x01010101 * alpha), zero);
+
+	#pragma omp parallel for schedule(static)
+	for (int iPixel = 0; iPixel < int(numPixels); ++iPixel)
+	{
+		const __m128i srcColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pSrc[iPixel]), zero);
+		const __m128i destColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pBack[iPixel]), zero);
+		const __m128i delta = _mm_mullo_epi16(alphaUnp, _mm_sub_epi16(srcColor, destColor));
+		const __m128i color = _mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(destColor, 8), delta), 8);
+		pDest[iPixel] = _mm_cvtsi128_si32(_mm_packus_epi16(color, zero));
+	}
+}
+
 void Add32(uint32_t *pDest, const uint32_t *pSrc, unsigned int numPixels)
 {
 	const __m128i zero = _mm_setzero_si128();
@@ -555,6 +571,10 @@ void TapeWarp32(uint32_t *pDest, const uint32_t *pSrc, unsigned xRes, unsigned y
 //	const float halfResY = yRes/2.f;
 //	const float maxDist = sqrtf(halfResX*halfResX + halfResY*halfResY);
 
+	// displacement in pixels, frequency per pixel
+	strength *= g_resScale;
+	speed /= g_resScale;
+
     #pragma omp parallel for schedule(static)
     for (int iY = 0; iY < int(yRes); ++iY)
     {
@@ -591,12 +611,12 @@ void TapeWarp32(uint32_t *pDest, const uint32_t *pSrc, unsigned xRes, unsigned y
 
 			// prepare UVs
 			const unsigned int U0 = U >> 8;
-			const unsigned int V0 = (V >> 8) * kResX;
+			const unsigned int V0 = (V >> 8) * xRes;
 			const unsigned int fracU = (U & 0xff) * 0x01010101;
 			const unsigned int fracV = (V & 0xff) * 0x01010101;
 
 			// sample & return
-			const auto sixteen = bsamp32_16(pSrc, U0, V0, U0+1, V0+kResX, fracU, fracV);
+			const auto sixteen = bsamp32_16(pSrc, U0, V0, U0+1, V0+xRes, fracU, fracV);
 			pDest[index] = v2cISSE16(sixteen);
         }
     }
@@ -633,45 +653,38 @@ void MulSrc32A(uint32_t *pDest, const uint32_t *pSrc, unsigned int numPixels)
 	}
 }
 
-void MixSrc32S(uint32_t *pDest, const uint32_t *pSrc, unsigned resX, unsigned resY, unsigned srcStride)
+// blend a row using the source buffer's alpha: 'pDest' = 'pBack' + ('pSrc'-'pBack')*srcAlpha ('pDest' may be 'pBack')
+VIZ_INLINE void MixSrc32_Row(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, unsigned numPixels)
 {
 	const __m128i zero = _mm_setzero_si128();
 
-	#pragma omp parallel for schedule(static)
-	for (int iY = 0; iY < int(resY); ++iY)
+	for (unsigned iPixel = 0; iPixel < numPixels; ++iPixel)
 	{
-		const auto yIndex = iY*resX;
-		const auto yIndexSrc = iY*srcStride;
-
-		for (int iX = 0; iX < int(resX); ++iX)
-		{
-			const auto srcIndex = yIndexSrc + iX; 
-			const auto destIndex = yIndex + iX;
-
-			const __m128i srcColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pSrc[srcIndex]), zero);
-			const __m128i alphaUnp = _mm_shufflelo_epi16(srcColor, 0xff);
-			const __m128i destColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pDest[destIndex]), zero);
-			const __m128i delta = _mm_mullo_epi16(alphaUnp, _mm_sub_epi16(srcColor, destColor));
-			const __m128i color = _mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(destColor, 8), delta), 8);
-			pDest[destIndex] = _mm_cvtsi128_si32(_mm_packus_epi16(color, zero));
-		}
+		const __m128i srcColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pSrc[iPixel]), zero);
+		const __m128i alphaUnp = _mm_shufflelo_epi16(srcColor, 0xff);
+		const __m128i destColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pBack[iPixel]), zero);
+		const __m128i delta = _mm_mullo_epi16(alphaUnp, _mm_sub_epi16(srcColor, destColor));
+		const __m128i color = _mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(destColor, 8), delta), 8);
+		pDest[iPixel] = _mm_cvtsi128_si32(_mm_packus_epi16(color, zero));
 	}
 }
 
-void MixSrc32(uint32_t *pDest, const uint32_t *pSrc, unsigned int numPixels)
-{
-	const __m128i zero = _mm_setzero_si128();
+// flat buffers are cut into rows of this many pixels
+constexpr unsigned kMixSrcRowLen = 1024;
 
+void MixSrc32S(uint32_t *pDest, const uint32_t *pSrc, unsigned resX, unsigned resY, unsigned srcStride)
+{
 	#pragma omp parallel for schedule(static)
-	for (int iPixel = 0; iPixel < int(numPixels); ++iPixel)
+	for (int iY = 0; iY < int(resY); ++iY)
 	{
-		const __m128i srcColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pSrc[iPixel]), zero);
-		const __m128i alphaUnp = _mm_shufflelo_epi16(srcColor, 0xff);
-		const __m128i destColor = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pDest[iPixel]), zero);
-		const __m128i delta = _mm_mullo_epi16(alphaUnp, _mm_sub_epi16(srcColor, destColor));
-		const __m128i color = _mm_srli_epi16(_mm_add_epi16(_mm_slli_epi16(destColor, 8), delta), 8);
-		pDest[iPixel] = _mm_cvtsi128_si32(_mm_packus_epi16(color, zero));
+		uint32_t *pDestLine = pDest + iY*resX;
+		MixSrc32_Row(pDestLine, pDestLine, pSrc + iY*srcStride, resX);
 	}
+}
+
+void MixSrc32(uint32_t *pDest, const uint32_t *pSrc, unsigned int numPixels)
+{
+	MixSrc32(pDest, pDest, pSrc, numPixels);
 
 #if 0
 	__asm
@@ -703,6 +716,51 @@ void MixSrc32(uint32_t *pDest, const uint32_t *pSrc, unsigned int numPixels)
 #endif
 }
 
+void MixSrc32(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, unsigned numPixels)
+{
+	const int numRows = int((numPixels + kMixSrcRowLen-1)/kMixSrcRowLen);
+
+	#pragma omp parallel for schedule(static)
+	for (int iRow = 0; iRow < numRows; ++iRow)
+	{
+		const unsigned offset = iRow*kMixSrcRowLen;
+		MixSrc32_Row(pDest + offset, pBack + offset, pSrc + offset, std::min(kMixSrcRowLen, numPixels-offset));
+	}
+}
+
+void MixSrc32R(uint32_t *pDest, const uint32_t *pSrc, const Rect &rect, unsigned destResX, unsigned srcResX)
+{
+	VIZ_ASSERT(rect.x+rect.resX <= destResX && srcResX >= rect.resX);
+
+	uint32_t *pDestRect = pDest + RectOffset(rect, destResX);
+
+	const bool parallelize = rect.resX*rect.resY*sizeof(uint32_t) > kCacheL1;
+
+	#pragma omp parallel for schedule(static) if (parallelize)
+	for (int iY = 0; iY < int(rect.resY); ++iY)
+	{
+		uint32_t *pDestLine = pDestRect + iY*destResX;
+		MixSrc32_Row(pDestLine, pDestLine, pSrc + iY*srcResX, rect.resX);
+	}
+}
+
+void MixSrc32R(uint32_t *pDest, uint32_t background, const uint32_t *pSrc, const Rect &rect, unsigned destResX, unsigned destResY, unsigned srcResX)
+{
+	VIZ_ASSERT(rect.x+rect.resX <= destResX && rect.y+rect.resY <= destResY);
+	VIZ_ASSERT(srcResX >= rect.resX);
+
+	#pragma omp parallel for schedule(static)
+	for (int iY = 0; iY < int(destResY); ++iY)
+	{
+		uint32_t *pDestLine = pDest + iY*destResX;
+
+		std::fill_n(pDestLine, destResX, background);
+
+		if (unsigned(iY) >= rect.y && unsigned(iY) < rect.y+rect.resY)
+			MixSrc32_Row(pDestLine + rect.x, pDestLine + rect.x, pSrc + (iY-rect.y)*srcResX, rect.resX);
+	}
+}
+
 // FIXME: optimize, that shuffle instruction sucks!
 void BlitSrc32(uint32_t *pDest, const uint32_t *pSrc, unsigned destResX, unsigned srcResX, unsigned yRes)
 {
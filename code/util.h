@@ -66,11 +66,28 @@ VIZ_INLINE void memset32(void *pDest, int value, size_t numInts)
 	while (numInts--) _mm_stream_si32(pInt++, value);
 }
 
+// region of interest (in pixels): ...R() variants (see MixSrc32R() below and deprecated/boxblur.h) only touch this rectangle of the destination
+// - the source is expected to hold just that rectangle, with 'srcResX' as its stride (for a full-size source offset it by RectOffset())
+// - handy for overlays that only cover part of the screen (see Image_Load32_Crop()) so cost scales with the content
+struct Rect
+{
+	unsigned x, y;
+	unsigned resX, resY;
+};
+
+CKD_INLINE static size_t RectOffset(const Rect &rect, unsigned stride) {
+	return rect.y*stride + rect.x;
+}
+
 // function intended to slowly zoom in to backgrounds (an idea Nytrik had for Arrested Development)
 void Zoom32(uint32_t *pDest, const uint32_t *pSrc, unsigned xRes, unsigned yRes, float scale);
 
+// out-of-place variants ('pDest' = op('pBack', 'pSrc')) write the destination without reading it: use them instead of
+// copying (or clearing) a background first and blending on top of it
+
 // blend 32-bit color buffers
 void Mix32(uint32_t *pDest, const uint32_t *pSrc, unsigned numPixels, uint8_t alpha);
+void Mix32(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, unsigned numPixels, uint8_t alpha);
 
 // blend 32-bit color buffers as follows: A+B(1-ALPHA), discards dest. alpha
 void MixOver32(uint32_t *pDest, const uint32_t *pSrc, unsigned numPixels);
@@ -90,6 +107,7 @@ void SoftLight32A(uint32_t *pDest, const uint32_t *pSrc, unsigned numPixels); //
 void SoftLight32AA(uint32_t *pDest, const uint32_t *pSrc, unsigned numPixels, float alpha); // applies effect by alpha
 
 // nonsensical warp effect applied to a 32-bit color buffer
+// - 'strength' and 'speed' are in terms of author resolution pixels (scaled by g_resScale)
 void TapeWarp32(uint32_t *pDest, const uint32_t *pSrc, unsigned xRes, unsigned yRes, float strength, float speed);
 
 // Photoshop-style overlay blend effect between two 32-bit color buffers (zeroes dest. alpha)
@@ -106,9 +124,13 @@ void MulSrc32A(uint32_t *pDest, const uint32_t *pSrc, unsigned int numPixels);
 
 // blend 32-bit color buffers using the source buffer's alpha (the latter has a src. stride)
 void MixSrc32(uint32_t *pDest, const uint32_t *pSrc, unsigned int numPixels);
+void MixSrc32(uint32_t *pDest, const uint32_t *pBack, const uint32_t *pSrc, unsigned numPixels);
 void MixSrc32S(uint32_t *pDest, const uint32_t *pSrc, unsigned destResX, unsigned destResY, unsigned srcStride);
+void MixSrc32R(uint32_t *pDest, const uint32_t *pSrc, const Rect &rect, unsigned destResX, unsigned srcResX);
+void MixSrc32R(uint32_t *pDest, uint32_t background, const uint32_t *pSrc, const Rect &rect, unsigned destResX, unsigned destResY, unsigned srcResX); // on a flat color, writes all of 'pDest'
 
 // blit 32-bit color buffer using the source buffer's alpha
+// these are region of interest functions already: offset 'pDest' yourself
 // use this to composite graphics on top of effects for ex.
 // BlitSrc32A(): alpha parameter will modulate source alpha ([0..1])
 void BlitSrc32(uint32_t *pDest, const uint32_t *pSrc, unsigned destResX, unsigned srcResX, unsigned yRes);